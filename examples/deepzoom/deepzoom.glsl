@@ -0,0 +1,17 @@
+#include "../utils/header.hl"
+#include "../utils/deepZoom.hl"
+
+void main() {
+    vec2 view = (2.0*fragCoord - 1.0) * vec2(iRatio, 1.0);
+    float iter = DeepMandelbrot(view);
+
+    if (iter < 0.0) {
+        fragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    // Cosine palette over logarithm of count, so bands keep their width while zooming
+    float t = 0.35 * log(1.0 + iter) + 0.05 * iTime;
+    vec3 col = 0.5 + 0.5*cos(6.2831853 * (t + vec3(0.0, 0.1, 0.2)));
+    fragColor = vec4(col, 1.0);
+}
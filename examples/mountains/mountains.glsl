@@ -9,6 +9,11 @@ uniform vec3 cLake;
 uniform vec3 vAng;
 uniform float theta; // up-down
 uniform float phi; // around
+uniform int octaves; // @quality 4 12
+
+// Same for every pixel, so they are evaluated once per frame on the CPU
+uniform vec3 lightDir; // @expr vec3(sin(theta) * sin(phi), cos(theta), sin(theta) * cos(phi))
+uniform float fovScale; // @expr tan(0.5*iFOV)
 
 #define GROUND 1
 #define LAKE 2
@@ -22,7 +27,7 @@ mat2 Rotate(float angle) {
 
 Object GetDist(vec3 pos) {
     Object obj;
-    obj.dist = pos.y - (850.0*FBM(pos.xz/800.0, 12) + 100.0);
+    obj.dist = pos.y - (850.0*FBM(pos.xz/800.0, octaves) + 100.0);
     obj.color = cGround;
     obj.index = GROUND;
     
@@ -37,12 +42,11 @@ Object GetDist(vec3 pos) {
 void main() {
     // moving origin to center of screen and correcting for aspect ratio
     vec2 uv = (2.0 * vec2(fragCoord.x, fragCoord.y) - 1.0) * vec2(iRatio, 1.0);
-    float fov = tan(0.5*iFOV);
 
     // setup where we are and where we are looking
     vec3 rayOrg = iCamPos;
-    float pitch = fov*uv.y + iCamPitch;
-    float yaw = fov*uv.x + iCamYaw;
+    float pitch = fovScale*uv.y + iCamPitch;
+    float yaw = fovScale*uv.x + iCamYaw;
 
     vec3 rayDir;
     rayDir.x = cos(yaw)*cos(pitch);
@@ -54,12 +58,18 @@ void main() {
     const float MAX_DIST = 15000.0;
     const float SURF_DIST = 0.1;
 
-    Object obj = RayMarch(rayOrg, rayDir, MAX_STEPS, MAX_DIST, SURF_DIST);
+    // Most steps cross empty air, so the depth pre-pass tells where to start
+    Object obj = RayMarch(rayOrg, rayDir, iStartDist(), MAX_STEPS, MAX_DIST, SURF_DIST);
+    if (iPrepass == 1) {
+        fragColor = vec4(obj.dist);
+        return;
+    }
+    fragKey = vec4(obj.dist, float(obj.index), 0.0, 0.0);
+
     vec3 pos = rayOrg + obj.dist * rayDir;
     vec3 normal = GetNormal(pos);
 
     // diffusive light
-    vec3 lightDir = vec3(sin(theta) * sin(phi), cos(theta), sin(theta) * cos(phi));
     float dif = max(0.0, dot(normal, lightDir));
 
     //shadow
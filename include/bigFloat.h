@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Signed fixed point number with a 32 bits integer part followed by any number of 32 bits
+// fractional limbs. Precision is chosen by the caller, so the same code serves a view at 1e-5
+// and one at 1e-100. Only what reference orbits need is provided; values must stay below 2^16
+// in magnitude, so products never overflow the integer part.
+
+class BigFloat {
+public:
+    BigFloat(void) = default;
+    explicit BigFloat(uint32_t numLimbs) : limbs(numLimbs, 0) {}
+
+    static BigFloat fromDouble(double value, uint32_t numLimbs);
+    // Plain decimal like "-0.7436438870371587", optionally followed by an exponent like "e-12"
+    static BigFloat fromString(const std::string& text, uint32_t numLimbs);
+
+    std::string toString(uint32_t digits) const; // 'digits' after decimal point
+    double toDouble(void) const;
+
+    uint32_t getLimbs(void) const { return uint32_t(limbs.size()); }
+    void setLimbs(uint32_t numLimbs); // extends with zeros or truncates
+
+    // Limbs needed to resolve steps of 'scale' with 'guard' extra bits
+    static uint32_t limbsFor(double scale, uint32_t guard = 64);
+
+    BigFloat operator-(void) const;
+    friend BigFloat operator+(const BigFloat& a, const BigFloat& b);
+    friend BigFloat operator-(const BigFloat& a, const BigFloat& b);
+    friend BigFloat operator*(const BigFloat& a, const BigFloat& b);
+
+private:
+    // Magnitudes only, with result sized as the longest operand
+    static int32_t compare(const BigFloat& a, const BigFloat& b);
+    static BigFloat addMagnitudes(const BigFloat& a, const BigFloat& b);
+    static BigFloat subMagnitudes(const BigFloat& a, const BigFloat& b); // requires |a| >= |b|
+
+    void divSmall(uint32_t den);
+    void mulSmall(uint32_t factor);
+    bool isZero(void) const;
+
+private:
+    bool negative = false;
+    std::vector<uint32_t> limbs; // [0] is integer part, then multiples of 2^-32, 2^-64, ...
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "dynamicShader.h"
+#include "renderTarget.h"
+#include "threadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct GLFWwindow;
+
+// Panel listing every shader and configuration file under a folder with a rendered preview.
+// Sources are expanded and hashed in the background, previews are looked up in a disk cache
+// keyed by that hash and only missing ones are rendered, on a thread with its own context
+// shared with the interface one. Entries are refreshed whenever one of their files is modified,
+// and least recently used previews leave the cache once it is full.
+
+class Browser {
+public:
+	static constexpr uint32_t THUMB_WIDTH = 192, THUMB_HEIGHT = 108;
+	static constexpr uintmax_t CACHE_LIMIT = uintmax_t(64) << 20; // bytes of cached previews
+
+public:
+	Browser(void) = default;
+	~Browser(void);
+
+	// Hashes pending previews, queues missing ones and uploads finished ones. Requires OpenGL context
+	void update(float deltaTime);
+	bool isBusy(void) const; // previews still being produced
+
+	void showBrowser(void);
+	std::filesystem::path selected(void); // file clicked by user, once
+
+	void setRoot(const std::filesystem::path& folder);
+
+	void open(void);
+	void close(void);
+
+private:
+	enum class State : int32_t { HASHING, DECODED, RENDER, RENDERING, READY, FAILED };
+
+	struct Entry {
+		std::filesystem::path path, shaderpath;
+		std::filesystem::file_time_type modTime;
+		bool isConfig = false;
+
+		std::atomic<State> state = { State::HASHING };
+		DynamicShader source;          // only expanded, keeps track of included files
+		uint64_t key = 0;
+		std::vector<uint8_t> pixels;   // decoded from cache or rendered, bottom row first
+		std::string errors;
+
+		RenderTarget image;
+	};
+
+	void scan(void);
+	void submit(Entry* entry);
+
+	static void process(Entry* entry, const std::filesystem::path& cacheDir);
+	static void render(Entry& entry, DynamicShader& renderer, RenderTarget& target, uint32_t vao, const std::filesystem::path& cacheDir);
+	static void trim(const std::filesystem::path& cacheDir);
+
+	// Preview thread. Starting needs the interface context current
+	bool startRenderer(void);
+	void stopRenderer(void);
+	void waitRenderer(void); // gives queued entries back and waits for the one being drawn
+	void run(void);
+
+private:
+	bool active = false;
+	bool initialized = false;
+
+	char root[512] = "../examples";
+	std::filesystem::path cacheDir = "thumbnails";
+	std::filesystem::path clicked;
+
+	float sinceCheck = 0.0f;   // seconds since files were last checked
+
+	GLFWwindow* window = nullptr;
+	std::thread renderThread;
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::deque<Entry*> queue;  // waiting for preview thread
+	Entry* current = nullptr;  // being drawn
+	bool stopping = false;
+
+	std::vector<std::unique_ptr<Entry>> entries;
+	ThreadPool pool{ 2 };
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "dynamicShader.h"
+#include "imageReader.h"
+#include "stagingRing.h"
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Image textures sampled by shaders as 'uniform sampler2D iChannel0..7'.
+// Files are read, hashed and decoded on worker threads, then uploaded a band of rows per frame
+// through pixel buffers and mipmapped on the GPU. Finished textures are cached by content hash,
+// so reloading a scene or opening another configuration with the same images reuses them.
+
+class Channels {
+public:
+	static constexpr int32_t NUM_CHANNELS = 8;
+	static constexpr int32_t FIRST_UNIT = 8; // lower texture units are left to data buffers
+
+	enum class Filter : int32_t { MIPMAP, LINEAR, NEAREST };
+	enum class Wrap : int32_t { REPEAT, CLAMP, MIRROR };
+
+	struct Source {
+		std::filesystem::path path;  // empty if channel isn't used
+		Filter filter = Filter::MIPMAP;
+		Wrap wrap = Wrap::REPEAT;
+	};
+
+	struct Texture {
+		uint32_t id = 0;
+		glm::uvec2 size = { 0, 0 };
+		size_t bytes = 0;
+	};
+
+public:
+	Channels(void);
+	~Channels(void) = default;
+
+	Channels(Channels&&) noexcept = default;
+	Channels& operator=(Channels&&) noexcept = default;
+
+	// Deletes every cached texture. Must run while the context is still current
+	static void clearCache(void);
+
+	void set(int32_t index, const Source& source);
+	const Source& get(int32_t index) const { return channels[index]->source; }
+
+	// Collects decoded images, uploads pending rows and reloads modified files. Requires OpenGL context
+	void update(float deltaTime);
+	bool isBusy(void) const; // images still being decoded or uploaded
+	bool isEmpty(void) const; // no channel is set
+	uint32_t getVersion(void) const { return version; } // changes whenever what shaders sample does
+
+	void bind(const DynamicShader& program) const;
+
+	void showChannels(void);
+	bool pickRequested(void); // true once after "Set..." was pressed for some channel
+	void setPicked(const std::filesystem::path& path);
+
+	void open(void);
+	void close(void);
+
+private:
+	// Shared between main thread and the worker decoding an image
+	struct Job {
+		std::atomic<bool> done = { false };
+		uint64_t hash = 0;
+		bool cached = false;  // texture already exists, so image wasn't decoded
+		Image image;
+		std::string error;
+	};
+
+	struct Channel {
+		~Channel(void);
+
+		Source source;
+		std::filesystem::file_time_type modTime;
+		uint32_t sampler = 0;
+
+		std::shared_ptr<Job> job;          // decode in flight
+		std::shared_ptr<Texture> texture;  // what shaders currently sample
+
+		// Texture being uploaded, replaces current one once complete
+		Texture upload;
+		std::shared_ptr<Job> uploading;
+		uint32_t nextRow = 0;
+
+		std::string error;
+	};
+
+	void submit(Channel& channel);
+	void finish(Channel& channel);
+	void updateSampler(Channel& channel);
+
+private:
+	bool active = false;
+	bool pickOn = false;
+	int32_t picking = 0;
+
+	float sinceCheck = 0.0f; // seconds since files were last checked
+	int32_t budgetMB = 16;   // bytes uploaded per frame
+	uint32_t version = 0;
+
+	std::unique_ptr<StagingRing> ring;
+	std::vector<std::unique_ptr<Channel>> channels;
+};
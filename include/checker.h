@@ -0,0 +1,40 @@
+#pragma once
+
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Batch validation for the '--check' command line mode. Shaders and configurations matching
+// directories or globs are expanded, compiled and linked in parallel, each worker thread with
+// its own hidden context. Every file produces one JSON line with its errors, remapped to
+// original files and lines, and its compile time; a summary line comes last.
+
+class Checker {
+public:
+    struct Error {
+        std::filesystem::path file;  // empty if error can't be located
+        int32_t line = 0;
+        std::string message;
+    };
+
+    struct Result {
+        std::filesystem::path file;    // as found, shader or configuration
+        std::filesystem::path shader;  // what was compiled
+        bool success = false;
+        double ms = 0.0;               // expanding, compiling and linking
+        std::vector<Error> errors;
+    };
+
+public:
+    // Arguments following '--check', relative to 'currDir'. Returns process exit code
+    static int32_t run(const std::vector<std::string>& args, const std::filesystem::path& currDir);
+
+    // Every .glsl and .json under a directory, matching a glob, or a single file
+    static std::vector<std::filesystem::path> gather(const std::string& pattern, const std::filesystem::path& currDir);
+
+private:
+    static Result check(const std::filesystem::path& file);
+    static std::vector<Error> parseErrors(const std::string& errors, const std::filesystem::path& shader);
+    static void write(std::ostream& out, const Result& result);
+};
@@ -4,6 +4,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 
 
@@ -13,11 +14,17 @@ public:
 	~Colors() = default;
 
 	void append(const std::string& name, const glm::vec3& color);
+	void set(const std::string& tag, const glm::vec3& color); // tag includes '##' prefix
+	void remove(const std::string& tag);
 
 	void addColor();
 	void showColors();
 	void submit(const DynamicShader& shader);
 
+	// Flags colors the shader doesn't use or declares with another type, and finds vec3
+	// uniforms nothing assigns, which can then be created from the window
+	void reflect(const DynamicShader& shader);
+
 	void open();
 	void close();
 
@@ -33,6 +40,13 @@ private:
 	bool active = false;
 	std::map<std::string, glm::vec3> mColors;
 
+	struct Issue {
+		bool mismatch;  // otherwise just unused
+		std::string message;
+	};
+	std::map<std::string, Issue> issues;
+	std::vector<std::string> missing;
+
 private:
 	// specs for adding new color
 	bool addOn = false;
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "dynamicShader.h"
+#include "gpuTimer.h"
+#include "renderTarget.h"
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// A/B comparison of two shaders, or of one shader at two git revisions.
+// Both are drawn off-screen in alternating order with identical inputs and a frozen time,
+// so GPU timings differ only by the shader code. Results include the speedup with its
+// confidence interval and how much the two images differ.
+
+class Compare {
+public:
+	struct Stats {
+		size_t samples = 0;
+		double mean = 0.0, stddev = 0.0;  // milliseconds
+	};
+
+	struct Difference {
+		double rmse = 0.0, psnr = 0.0;    // over 8 bit channels
+		uint32_t maxError = 0;
+		double changed = 0.0;             // fraction of pixels that differ
+	};
+
+public:
+	Compare(void) = default;
+	~Compare(void) = default;
+
+	// Presets sides without a shader yet
+	void setShader(const std::filesystem::path& path);
+
+	void showCompare(void);
+	bool requested(void); // true once after user pressed "Start"
+
+	bool start(float time);
+	void stop(void);
+	bool isRunning(void) const;
+
+	// Binds target and program for k-th draw of this frame (k = 0, 1)
+	DynamicShader& begin(int32_t k);
+	void end(void);
+
+	const glm::uvec2& getResolution(void) const { return resolution; }
+	float getTime(void) const { return time; }
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Side {
+		char path[512] = { 0 };
+		char revision[64] = { 0 };   // empty for file on disk
+
+		DynamicShader shader;
+		RenderTarget target;
+		GpuTimer timer;
+		std::vector<double> samples;
+		int32_t discarded = 0;       // warm-up measurements
+		std::vector<uint8_t> pixels;
+	};
+
+	bool load(Side& side);
+	Stats statistics(const Side& side) const;
+	void collect(void);
+	void difference(void);
+
+private:
+	bool active = false;
+	bool startOn = false;
+	bool running = false;
+	bool initialized = false;
+
+	glm::uvec2 resolution = { 1280, 720 };
+	int32_t numSamples = 300, warmup = 10;
+
+	float time = 0.0f;
+	uint64_t frame = 0;
+	int32_t current = 0;
+
+	std::array<Side, 2> sides;
+	Difference diff;
+	bool hasDifference = false;
+};
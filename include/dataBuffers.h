@@ -0,0 +1,92 @@
+#pragma once
+
+#include "stagingRing.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Binary data files referenced by a configuration, like point clouds, heightmaps or lookup tables.
+// Files are streamed as they are into shader storage buffers or buffer textures, a limited number
+// of bytes per frame. When a file changes, it is memory mapped just long enough to hash its blocks,
+// and only blocks whose content differs are uploaded again. Files are never held open between
+// frames, so other programs can rewrite them at any time. Storage bindings 6 and 7 are used by
+// tools and can't be picked.
+
+class DataBuffers {
+public:
+	enum class Kind : int32_t { STORAGE, TEXTURE };
+
+	struct Source {
+		std::string name;
+		std::filesystem::path path;
+		Kind kind = Kind::STORAGE;
+		int32_t binding = 0;          // storage binding or texture unit
+		std::string format = "r32f";  // texel format of buffer textures
+	};
+
+	static constexpr size_t BLOCK_SIZE = size_t(64) << 10; // granularity of change detection
+	static constexpr int32_t RESERVED_BINDINGS[] = { 6, 7 }; // storage bindings used by tools
+
+public:
+	DataBuffers(void) = default;
+	~DataBuffers(void) = default;
+
+	DataBuffers(DataBuffers&&) noexcept = default;
+	DataBuffers& operator=(DataBuffers&&) noexcept = default;
+
+	void append(const Source& source);
+	void add(const std::filesystem::path& path); // storage buffer on first free binding
+	std::vector<Source> getSources(void) const;
+
+	// Checks for modified files and streams pending data. Requires OpenGL context
+	void update(float deltaTime);
+	bool isUploading(void) const;
+
+	void bind(void) const;
+
+	void showBuffers(void);
+	bool addRequested(void); // true once after "Add..." was pressed
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Entry {
+		~Entry(void);
+
+		Source source;
+		size_t size = 0;  // bytes of file when last loaded
+		std::filesystem::file_time_type modTime;
+
+		uint32_t bufferID = 0, textureID = 0;
+		size_t capacity = 0;
+
+		std::vector<uint64_t> hashes;                    // content of each block on GPU
+		std::vector<std::pair<size_t, size_t>> pending;  // offset and size still to upload
+		size_t pendingBytes = 0;
+		std::string error;
+	};
+
+	void load(Entry& entry);
+	void allocate(Entry& entry);
+	void createTexture(Entry& entry);
+	void queue(Entry& entry, size_t offset, size_t size);
+
+	static uint64_t hashBlock(const uint8_t* data, size_t size);
+	int32_t freeBinding(void) const;
+	static bool isReserved(int32_t binding);
+
+private:
+	bool active = false;
+	bool addOn = false;
+
+	float sinceCheck = 0.0f; // seconds since files were last checked
+	int32_t budgetMB = 32;   // bytes uploaded per frame
+
+	std::unique_ptr<StagingRing> ring;
+	std::vector<uint8_t> chunk; // read from file before going to write-only staging memory
+	std::vector<std::unique_ptr<Entry>> entries;
+};
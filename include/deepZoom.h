@@ -0,0 +1,101 @@
+#pragma once
+
+#include "dynamicShader.h"
+#include "bigFloat.h"
+#include "threadPool.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Zooms into the Mandelbrot set far beyond single precision for shaders built on 'utils/deepZoom.hl'.
+// A reference orbit is iterated on the CPU in fixed point with as many bits as the zoom needs, a few
+// candidates around the view in parallel, keeping the one that survives longest. Shaders follow
+// each pixel as a small perturbation of that orbit, starting after the iterations a cubic series
+// approximation covers. Enabled for shaders declaring 'iDeepOrbit'; wheel zooms and dragging pans.
+
+class DeepZoom {
+public:
+	static constexpr int32_t UNIT = 17;          // after channels and depth pre-pass
+	static constexpr int32_t ORBIT_WIDTH = 1024; // texels per row of orbit texture
+	static constexpr double BAILOUT = 256.0;     // squared radius, as in shader
+
+public:
+	DeepZoom(void);
+	~DeepZoom(void);
+
+	// Uploads finished orbits and starts new ones when view changed. True if image must be redrawn
+	bool update(const DynamicShader& shader);
+	bool isActive(void) const { return inUse; }
+
+	// Cursor in [0, 1] over a viewport of 'size' pixels, input only read while hovered. True if view changed
+	bool navigate(const glm::vec2& cursor, const glm::vec2& size, bool hovered);
+
+	void bind(const DynamicShader& program) const;
+
+	void showDeepZoom(void);
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Series {
+		int32_t skip = 0;             // iterations covered
+		glm::vec2 coefs[3];           // mantissas of first, second and third order terms
+		glm::ivec3 exponents = { 0, 0, 0 };
+	};
+
+	struct Candidate {
+		BigFloat re, im;
+		std::vector<glm::dvec2> orbit;
+	};
+
+	// Shared between main thread and workers computing candidates
+	struct Job {
+		std::atomic<bool> done = { false }, cancel = { false };
+		std::atomic<int32_t> remaining = { 0 };
+
+		BigFloat re, im;              // view center
+		double scale = 1.0;
+		double radius = 1.0;          // farthest pixel from center, in view units
+		int32_t maxIter = 0;
+
+		std::vector<Candidate> candidates;
+		int32_t best = 0;
+		glm::dvec2 offset = { 0.0, 0.0 }; // center relative to best reference, in view units
+		Series series;
+	};
+
+	void submit(void);
+	void upload(Job& job);
+	void setCenter(const std::string& re, const std::string& im);
+
+	static void iterate(Job& job, Candidate& cand);
+	static void finish(Job& job);
+
+private:
+	bool active = false;
+	bool inUse = false;   // shader declares orbit
+	bool dirty = true;    // view changed since last orbit was started
+
+	BigFloat re, im;      // center of view
+	double scale = 1.5;   // half height of view
+	int32_t maxIter = 1000;
+	float ratio = 1.0f;   // width over height
+
+	std::shared_ptr<Job> job;
+
+	// Orbit shaders are using
+	BigFloat refRe, refIm;
+	int32_t length = 0;
+	Series series;
+	bool seriesValid = false; // coefficients belong to current view
+	glm::vec2 offset = { 0.0f, 0.0f };
+	uint32_t texture = 0;
+	glm::ivec2 texSize = { 0, 0 };
+
+	char textRe[256] = { 0 }, textIm[256] = { 0 };
+
+	ThreadPool pool; // last, so workers stop before the rest goes away
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "dynamicShader.h"
+#include "renderTarget.h"
+
+// Optional coarse pass for ray marchers built on 'utils/rayMarcher.hl'. The scene is first drawn
+// at a fraction of the resolution with iPrepass set, where primary rays march a cone covering
+// their block and store how far it got. Full resolution rays then read a safe start distance
+// through iStartDist(), skipping the empty space already crossed.
+
+class DepthPrepass {
+public:
+    static constexpr int32_t UNIT = 16; // texture unit, above image channels
+
+public:
+    DepthPrepass(void) = default;
+    ~DepthPrepass(void) = default;
+
+    bool isEnabled(void) const { return enabled; }
+    void setEnabled(bool value) { enabled = value; }
+
+    int32_t getBlockSize(void) const { return blockSize; }
+    void setBlockSize(int32_t value);
+
+    // Binds the coarse target for an image of resolution 'res', returning its size
+    glm::uvec2 beginCoarse(const glm::uvec2& res, float fov);
+    void endCoarse(void);  // following draws read start distances
+    void finish(void);     // following draws ignore the pre-pass
+
+    // Sets pre-pass uniforms of the bound program according to current stage
+    void bind(const DynamicShader& program) const;
+
+private:
+    enum class Stage : int32_t { OFF, WRITING, READING };
+
+    bool enabled = false;
+    int32_t blockSize = 8;  // pixels of full image per coarse ray
+    float cone = 0.0f;      // radius of a block's cone per unit of distance
+
+    Stage stage = Stage::OFF;
+    RenderTarget target;
+};
@@ -3,12 +3,27 @@
 #include "glad/glad.h"
 #include "GRender/mailbox.h"
 
+#include <functional>
+#include <memory>
+
 class DynamicShader {
     struct Data {
         std::filesystem::file_time_type modTime;  // used to reload shader if it was modified
         std::pair<int32_t, int32_t> range;
     };
 
+public:
+    // Uniform used by linked program, as reported by the driver
+    struct Reflected {
+        int32_t location = -1;
+        GLenum type = 0;
+        int32_t size = 1;               // elements of arrays
+        mutable bool assigned = false;  // if any setter reached it since linking
+    };
+
+    // Compiled module, shared by every shader linking it
+    struct ModuleObject;
+
 public:
     DynamicShader(void) = default;
     ~DynamicShader(void);
@@ -20,43 +35,108 @@ public:
     DynamicShader& operator=(DynamicShader&&) noexcept;
 
 
-    void initialize(void);
+    // Transformation applied to expanded source before compiling. It must keep the
+    // lines of the original source in place, so errors are still reported correctly
+    using Pass = std::function<std::string(const std::string&)>;
+    void setPass(Pass pass);
+
+    // In module mode, files containing '#pragma module' are compiled once into their own
+    // shader objects and linked with the main file. Ignored while a pass is set
+    void setModules(bool value) { useModules = value; }
+    bool usesModules(void) const { return useModules; }
+
+    // Drops functions, structs and macros of the main object that 'main' never reaches, so large
+    // include libraries don't slow down compiling. Lines stay in place, as with passes
+    void setPruning(bool value) { usePruning = value; }
+    bool usesPruning(void) const { return usePruning; }
+
+    // Default vertex shader draws a single quad; tools may provide their own
+    void initialize(const std::string& vertexSource = "");
     void loadShader(const std::filesystem::path& frgPath);
-    bool hasFailed(void);
+
+    // Only resolves includes, filling source and watched files. Doesn't need OpenGL
+    bool expand(const std::filesystem::path& frgPath);
+
+    // Silent shaders keep their errors instead of sending them to the mailbox
+    void setSilent(bool value) { silent = value; }
+    const std::string& getErrors(void) const { return errors; }
+
+    bool hasFailed(void) const;
     void bind(void);
 
     bool wasUpdated(); // if any file was touched since opened
 
+    // Expanded source with all includes, as sent to the compiler
+    const std::string& getSource(void) const { return program; }
+    // Original file and line for a line of the expanded source
+    std::string locate(int32_t line) const;
+
+    // Active uniforms of last link, arrays named without brackets. Setters look locations up here,
+    // so values for uniforms the program doesn't use are never uploaded
+    const std::unordered_map<std::string, Reflected>& getUniforms(void) const { return uniforms; }
+    const Reflected* findUniform(const std::string& name) const; // nullptr if not active
+
+    // Pointers may hold 'count' consecutive elements, filling an array with a single call
     void setInteger(const char*, int) const;
-    void setVec2i(const char*, const int32_t*) const;
-    void setVec3i(const char*, const int32_t*) const;
-    void setVec4i(const char*, const int32_t*) const;
+    void setInteger(const char*, const int32_t*, int32_t count) const;
+    void setVec2i(const char*, const int32_t*, int32_t count = 1) const;
+    void setVec3i(const char*, const int32_t*, int32_t count = 1) const;
+    void setVec4i(const char*, const int32_t*, int32_t count = 1) const;
 
     void setFloat(const char*, float) const;
-    void setVec2f(const char*, const float*) const;
-    void setVec3f(const char*, const float*) const;
-    void setVec4f(const char*, const float*) const;
+    void setFloat(const char*, const float*, int32_t count) const;
+    void setVec2f(const char*, const float*, int32_t count = 1) const;
+    void setVec3f(const char*, const float*, int32_t count = 1) const;
+    void setVec4f(const char*, const float*, int32_t count = 1) const;
+
+    // Column major, like glm
+    void setMat2f(const char*, const float*, int32_t count = 1) const;
+    void setMat3f(const char*, const float*, int32_t count = 1) const;
+    void setMat4f(const char*, const float*, int32_t count = 1) const;
 
 
 private:
+    void swap(DynamicShader& rhs) noexcept; // every member, new ones must be added here
+
     uint32_t createShaderFromFile(const std::filesystem::path& shaderPath, GLenum shaderType);
     uint32_t createShader(const std::string& shaderData, GLenum shaderType);
     void checkShader(uint32_t id, uint32_t flag);
     void checkProgram(uint32_t id, uint32_t flag);
+    void report(const std::string& message);
+
+    void reflect(void);
+    int32_t uniformLocation(const char* name) const; // -1 if not active
+    int32_t uniformLocation(const char* name, int32_t& count) const; // also clamps count to elements declared
+
+    // Program with bodies of functions coming from other files replaced by prototypes
+    std::string keepBodies(const std::function<bool(const std::string&)>& keep) const;
+    uint32_t createModules(GLenum shaderType);
+    std::string pruned(const std::string& source) const;
     
     bool success = false; // determines if shader was loaded correctly
+    bool silent = false;
+    std::string errors;
 
     uint32_t
         programID = 0,   // id used to bind shader
         vtxID = 0;       // vertex compilation id
 
+    std::unordered_map<std::string, Reflected> uniforms;
+
+    bool useModules = false;
+    bool usePruning = false;
+    std::vector<std::shared_ptr<const ModuleObject>> modules; // cached objects linked with the main one
+
 private:
     bool recurseFiles(const std::filesystem::path& shadername);
 
     // Tracks which line came from which file
     int32_t numLines = 0;
     std::string program;
+    std::vector<std::string> origins; // file of each line in program
+    std::vector<std::string> moduleFiles;
     std::filesystem::path location;
+    Pass pass;
     std::unordered_map<std::string, Data> fileMap;
 };
     
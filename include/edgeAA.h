@@ -0,0 +1,77 @@
+#pragma once
+
+#include "dynamicShader.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Optional anti-aliasing that only supersamples edges. The scene is drawn once into a target that
+// also keeps 'fragKey', the distance and object index shaders may write for their primary rays.
+// A detection pass marks pixels differing from a neighbor in key or brightness in the stencil
+// buffer, the scene is drawn again with jittered tile offsets for marked pixels only, and a
+// resolve pass averages these samples into the view.
+
+class EdgeAA {
+public:
+    static constexpr int32_t UNIT = 18;       // first of two units read by internal passes
+    static constexpr int32_t MAX_SAMPLES = 16;
+
+public:
+    EdgeAA(void) = default;
+    ~EdgeAA(void);
+
+    EdgeAA(const EdgeAA&) = delete;
+    EdgeAA& operator=(const EdgeAA&) = delete;
+
+    bool isEnabled(void) const { return enabled; }
+    void setEnabled(bool value) { enabled = value; }
+
+    int32_t getSamples(void) const { return numSamples; }
+    void setSamples(int32_t value);
+
+    // Looks for writes to 'fragKey'; without them only brightness marks edges
+    void scan(const DynamicShader& program);
+
+    // Binds target for the first pass at resolution 'res'
+    void beginBase(const glm::uvec2& res);
+
+    // Marks edges; following samples only shade marked pixels
+    void detect(void);
+
+    // Binds target for extra sample 'k', returning its offset in pixels
+    glm::vec2 beginSample(int32_t k);
+    void endSamples(void);
+
+    // Writes final image to the bound framebuffer, of the same resolution
+    void resolve(void);
+
+    float getCoverage(void) const { return coverage; } // fraction of pixels marked, a few frames late
+
+    void showMenu(void); // entries for options menu
+
+private:
+    void initialize(void);
+    void release(void);
+
+private:
+    bool enabled = false;
+    bool showEdges = false;         // tints marked pixels in resolve
+    int32_t numSamples = 4;         // besides the first pass
+    float depthThreshold = 0.05f;   // relative distance difference
+    float lumaThreshold = 0.1f;
+    bool useKeys = false;           // shader writes distance and object index
+
+    glm::uvec2 size = { 0, 0 };
+    uint32_t baseFBO = 0, accumFBO = 0;
+    uint32_t baseTex = 0, keyTex = 0, accumTex = 0, stencilRB = 0;
+
+    uint32_t detectProgram = 0, resolveProgram = 0, vao = 0;
+
+    uint32_t query = 0;
+    bool queryPending = false;
+    float coverage = 0.0f;
+
+    // Blend state of the application, restored after samples
+    GLboolean blendWasOn = GL_FALSE;
+    GLint blendSrc = GL_ONE, blendDst = GL_ZERO, blendSrcAlpha = GL_ONE, blendDstAlpha = GL_ZERO;
+};
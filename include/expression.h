@@ -0,0 +1,73 @@
+#pragma once
+
+#include "uniforms.h"
+#include "colors.h"
+
+#include "GRender/camera.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Uniforms whose value is an expression over time, camera and other uniforms, for per frame
+// constants a shader would otherwise recompute for every pixel. Expressions follow the declaration:
+//     uniform vec3 lightDir; // @expr vec3(sin(theta)*sin(phi), cos(theta), sin(theta)*cos(phi))
+// They are compiled once to a small stack bytecode and evaluated on the CPU once per frame.
+// Syntax is a subset of GLSL: arithmetic, swizzles, constructors and common built-in functions.
+namespace expr {
+
+// Every value is made of floats; integer uniforms are converted on the way in and rounded on the way out
+struct Value {
+	uniform::Type tp = uniform::Type::NONE; // NONE marks a failed evaluation
+	float v[16] = { 0.0f };
+};
+
+// Built-in names available to every expression, as the shader receives them
+struct Inputs {
+	float time = 0.0f;                       // iTime
+	float ratio = 1.0f;                      // iRatio
+	glm::vec2 mouse = { 0.0f, 0.0f };        // iMouse
+	const GRender::Camera* camera = nullptr; // iCamPos, iCamYaw, iCamPitch and iFOV
+};
+
+class Program {
+public:
+	static constexpr int32_t MAX_DEPTH = 32;
+
+public:
+	// False with a message in 'error' if text doesn't parse
+	bool compile(const std::string& text, std::string& error);
+
+	// 'values' holds the current value of each of getNames(), in the same order
+	Value run(const std::vector<Value>& values) const;
+
+	const std::string& getText(void) const { return text; }
+	const std::vector<std::string>& getNames(void) const { return names; }
+
+private:
+	enum class Op : uint8_t { CONSTANT, LOAD, NEGATE, ADD, SUBTRACT, MULTIPLY, DIVIDE, CALL, SWIZZLE };
+
+	struct Instruction {
+		Op op;
+		int32_t arg = 0;   // constant, name or function index, or swizzle with two bits per component
+		int32_t count = 0; // arguments of calls, components of swizzles
+	};
+
+	struct Parser; // recursive descent emitting instructions in postfix order
+
+private:
+	std::string text;
+	std::vector<Instruction> code;
+	std::vector<float> constants;
+	std::vector<std::string> names;
+};
+
+// Compiles '@expr' annotations found in shader source and attaches them to their uniforms,
+// creating the ones not defined yet. Errors and unknown names are reported in the mailbox,
+// unless 'silent' for threads other than the interface one
+void scan(const DynamicShader& shader, uniform::Uniform& uniforms, const Colors& colors, bool silent = false);
+
+// Updates every expression uniform, after the ones it depends on
+void evaluate(uniform::Uniform& uniforms, const Colors& colors, const Inputs& inputs);
+
+} // namespace expr
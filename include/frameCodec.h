@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fast lossless compression for rendered frames, in the spirit of LZ4. Each byte is first replaced
+// by its difference to the same channel of the pixel on its left, which turns smooth gradients into
+// long runs of repeated values; then repeated sequences are replaced by references to earlier ones.
+namespace codec {
+
+// 'stride' is the number of bytes per pixel
+void compress(const uint8_t* data, size_t size, uint32_t stride, std::vector<uint8_t>& out);
+
+// 'size' must be the size given to compress. False if data is corrupt
+bool decompress(const std::vector<uint8_t>& data, size_t size, uint32_t stride, std::vector<uint8_t>& out);
+
+} // namespace codec
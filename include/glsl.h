@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lightweight GLSL scanning used by tools working on the expanded shader source.
+// It isn't a full parser, it only understands what is needed to find functions,
+// their calls and loops with constant bounds.
+namespace glsl {
+
+struct Function {
+	std::string name, returnType;
+	std::vector<std::string> params;  // parameter names
+	size_t begin = 0;                 // start of return type
+	size_t bodyBegin = 0;             // position of '{', or of ';' for prototypes
+	size_t end = 0;                   // one past closing '}' or ';'
+	bool prototype = false;
+};
+
+// Replaces comments by spaces, keeping newlines so positions and lines are preserved
+std::string stripComments(const std::string& src);
+
+// Top level functions, in order of appearance. Source must be free of comments
+std::vector<Function> findFunctions(const std::string& src);
+
+// Turns a function definition into a prototype, blanking its body but keeping newlines,
+// so the source keeps its size and every position stays valid
+void blankBody(std::string& src, const Function& fn);
+
+// Blanks functions, structs and '#define's not reachable from 'main' or from any other top level
+// declaration, like uniforms and global constants. Overloads are kept or dropped together.
+// Newlines are kept, so lines of the result match those of 'src'
+std::string prune(const std::string& src);
+
+// Matching closing bracket for the one at 'pos', or npos
+size_t matchBracket(const std::string& src, size_t pos);
+
+// First non-space position from 'pos'
+size_t skipSpaces(const std::string& src, size_t pos);
+// Top level arguments between brackets at 'open' and 'close'
+std::vector<std::string> splitArguments(const std::string& src, size_t open, size_t close);
+
+bool isIdentifierChar(char ch);
+size_t lineOf(const std::string& src, size_t pos); // starting at 1
+
+} // namespace glsl
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "uniforms.h"
+#include "gpuTimer.h"
+
+#include "GRender/camera.h"
+
+#include <string>
+#include <vector>
+
+// Keeps navigation smooth in heavy scenes by lowering uniforms marked as quality knobs, like
+// step counts or octaves, while the camera moves or the main view runs over its GPU budget.
+// Knobs go from their value towards the bottom of their range and ramp back once the view settles.
+// Uniforms are marked from their context menu, with "knob": true in the configuration or
+// with a '// @quality' comment after their declaration, optionally followed by a range.
+
+class Governor {
+public:
+	Governor(void) = default;
+	~Governor(void) = default;
+
+	// Marks uniforms annotated in shader source, creating the ones not defined yet
+	void scan(const DynamicShader& shader, uniform::Uniform& uniforms);
+
+	// Decides quality of the next frame from camera motion and measured GPU time
+	void update(float deltaTime, const GRender::Camera& camera);
+
+	// Knobs are lowered only for the duration of a draw, so editors always show chosen values
+	void lower(uniform::Uniform& uniforms);
+	void restore(void);
+
+	void beginTiming(void);
+	void endTiming(void);
+
+	bool isLowered(void) const { return quality < 1.0f; }
+	void reset(void);
+
+	void showGovernor(const uniform::Uniform& uniforms);
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Saved {
+		uniform::ParentData* data;
+		float value;
+	};
+
+	bool active = false;
+	bool enabled = true;
+
+	float budget = 16.0f;         // milliseconds of GPU time for main view
+	float movingQuality = 0.5f;   // while camera moves
+	float minQuality = 0.1f;
+	float rampTime = 0.5f;        // seconds to climb back to full quality
+	float settleTime = 0.2f;      // seconds the camera must be still before climbing
+
+	float quality = 1.0f;
+	float still = 0.0f;
+	double gpuTime = 0.0;         // average of recent measurements
+
+	glm::vec3 lastPosition = { 0.0f, 0.0f, 0.0f };
+	float lastYaw = 0.0f, lastPitch = 0.0f, lastFOV = 0.0f;
+
+	GpuTimer timer;
+	std::vector<Saved> saved;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstdint>
+
+// Measures GPU time of a sequence of draws with GL_TIME_ELAPSED queries.
+// Queries are kept in a small ring and collected once available, so timing never stalls.
+
+class GpuTimer {
+public:
+    GpuTimer(void) = default;
+    ~GpuTimer(void);
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Starts a measurement. Returns false if every query is still pending
+    bool begin(void);
+    void end(void);
+
+    // Oldest finished measurement in milliseconds, if any
+    bool fetch(double& ms);
+
+    // Drops every measurement still in flight
+    void clear(void);
+
+private:
+    std::array<uint32_t, 8> queries = {};
+    uint32_t head = 0, count = 0;
+    bool running = false;
+};
@@ -2,6 +2,30 @@
 #include "dynamicShader.h"
 #include "colors.h"
 #include "uniforms.h"
+#include "poster.h"
+#include "scheduler.h"
+#include "shaderAnalyzer.h"
+#include "heatMap.h"
+#include "compare.h"
+#include "sweep.h"
+#include "browser.h"
+#include "recorder.h"
+#include "profiler.h"
+#include "viewports.h"
+#include "dataBuffers.h"
+#include "channels.h"
+#include "governor.h"
+#include "depthPrepass.h"
+#include "renderThread.h"
+#include "deepZoom.h"
+#include "expression.h"
+#include "history.h"
+#include "edgeAA.h"
+
+#ifdef GSHADER_PREVIEW_SERVER
+#include "previewServer.h"
+#include "readback.h"
+#endif
 
 #include "configFile.h"
 
@@ -26,17 +50,36 @@ class GShader : public Application {
 
 public:
 	GShader(const fs::path& filepath);
-	~GShader(void) = default;
+	~GShader(void);
 
 	void onUserUpdate(float deltaTime) override;
 	void ImGuiLayer(void) override;
 	void ImGuiMenuLayer(void) override;
 
 	void importShader(const fs::path& shaderpath);
+	void replay(const fs::path& logpath, bool headless);
 
 	void loadConfig(const fs::path& configpath);
 	void saveConfig(const fs::path& configpath);
 
+private:
+	// Draws given program into whatever target is bound. Offset and size describe
+	// the region of an image with resolution 'fullRes' that the target holds; offsets
+	// may be fractional, shifting every pixel by part of itself
+	void drawShader(DynamicShader& program, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor);
+	// Binds program, data buffers, channels and tool textures, and submits every built-in
+	// and user uniform, without drawing
+	void setupShader(DynamicShader& program, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor);
+
+	// Same as above with the scene of another viewport. Resources of the main view's tools
+	// aren't bound, as render thread and viewports have none of them
+	void drawShader(DynamicShader& program, Camera& cam, Colors& cols, Uniform& unis, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor);
+	void setupShader(DynamicShader& program, Camera& cam, Colors& cols, Uniform& unis, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor);
+
+	// Computes expression uniforms once for every draw sharing these inputs, like tiles,
+	// extra samples and passes of a frame. Must come before any of them
+	void evaluate(Camera& cam, Colors& cols, Uniform& unis, const glm::uvec2& fullRes, float time, const glm::vec2& cursor);
+
 private:
 	fs::path currentShader;
 	float elapsedTime = 0.0f;
@@ -45,6 +88,9 @@ private:
 	bool ctrlPlay = true;
 	bool ctrlReset = false;
 	bool ctrlStep = false;
+	bool moduleMode = false;
+	bool pruneMode = false;
+	bool threadedView = false; // main view was last drawn by render thread
 
 	Quad quad;
 	QuadSpecs specs;
@@ -53,6 +99,29 @@ private:
 	Colors colors;
 	Camera camera;
 	DynamicShader shader;
+	Poster poster;
+	Scheduler scheduler;
+	ShaderAnalyzer analyzer;
+	HeatMap heat;
+	Compare compare;
+	Sweep sweep;
+	Browser browser;
+	Recorder recorder;
+	Profiler profiler;
+	Viewports viewports;
+	DataBuffers buffers;
+	Channels channels;
+	Governor governor;
+	DepthPrepass prepass;
+	RenderThread renderer;
+	DeepZoom deepZoom;
+	History history;
+	EdgeAA edgeAA;
+
+#ifdef GSHADER_PREVIEW_SERVER
+	PreviewServer server;
+	Readback readback;
+#endif
 
 	Ref<Framebuffer> fbuffer;
 };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "dynamicShader.h"
+#include "renderTarget.h"
+
+#include <array>
+#include <filesystem>
+#include <string>
+
+// Diagnostic mode rendering an instrumented copy of the current shader.
+// Per pixel it counts loop iterations inside the ray marcher, calls to the distance
+// function and early exits from the marching loop. Counts are written to an integer
+// side target, accumulated in a histogram and shown as a heat map over the image.
+// Histograms are read back through a small ring of buffers once their fence has signaled,
+// so statistics lag a frame or two behind and the render loop never waits for them.
+
+class HeatMap {
+public:
+	enum class Mode : int32_t { STEPS, CALLS, EXITS };
+	static constexpr uint32_t NUM_BINS = 64;
+
+public:
+	HeatMap(void) = default;
+	~HeatMap(void);
+
+	void load(const std::filesystem::path& shaderpath);
+	bool isEnabled(void) const;
+
+	// Binds instrumented shader and its outputs. Target must have given size
+	DynamicShader& begin(const glm::uvec2& size);
+	// Queues statistics and counters under given pixel (negative if none) for readback
+	void end(const glm::ivec2& hoveredPixel);
+
+	void showHeatMap(void);
+	bool wasToggled(void); // true once after heat map was switched on or off
+
+	// Inserts counters into expanded source, keeping lines in place
+	static std::string instrument(const std::string& src, const std::string& march, const std::string& dist);
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Slot {
+		uint32_t bufferID = 0; // histogram, then counters of hovered pixel
+		GLsync fence = nullptr;
+		bool hovered = false;
+	};
+
+	void collect(Slot& slot); // statistics of a finished frame
+
+private:
+	bool active = false;
+	bool enabled = false, toggled = false;
+
+	bool initialized = false;
+	DynamicShader shader;
+	RenderTarget counts;
+	std::array<Slot, 3> slots;
+	uint32_t head = 0;         // slot of next frame, oldest one in flight
+
+	// Functions to instrument
+	char marchName[64] = "RayMarch";
+	char distName[64] = "GetDist";
+
+	Mode mode = Mode::STEPS;
+	bool autoScale = true;
+	float maxValue = 100.0f, blend = 0.85f;
+
+	// Statistics from last frame
+	std::array<float, NUM_BINS> bins = {};
+	uint32_t frameMax = 0;
+	double frameMean = 0.0;
+	bool isHovered = false;
+	glm::uvec4 hovered = { 0, 0, 0, 0 };
+};
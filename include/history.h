@@ -0,0 +1,96 @@
+#pragma once
+
+#include "readback.h"
+#include "threadPool.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Keeps recently drawn frames of the main view in memory, so the timeline can be scrubbed without
+// drawing again. Frames are read back asynchronously, compressed on worker threads and stored with
+// the iTime they were drawn at; oldest ones go once the memory budget is reached. Times without a
+// frame close enough are drawn again. Frames are only kept while the scene they show stays the same,
+// and frames drawn at lowered quality aren't stored. See 'Options > Frame history...'.
+
+class History {
+public:
+	History(void);
+	~History(void);
+
+	bool isEnabled(void) const { return enabled; }
+
+	// Queues the bound framebuffer for storage, labeled with the time it was drawn at
+	void capture(float time, const glm::uvec2& size);
+
+	// Hands read back frames to workers, stores compressed ones and uploads decoded ones
+	void update(void);
+	bool isBusy(void); // decoding a frame about to be shown
+
+	// Time picked on scrub bar, reported once
+	bool scrubRequested(float& time);
+
+	// Shows the stored frame closest to 'time' in place of main view. False if none is close enough
+	bool display(float time);
+	void resume(void); // back to live view
+
+	bool isDisplaying(void) const { return displaying; }
+	uint32_t getTexture(void) const { return texture; }
+
+	void clear(void);
+
+	// Key of everything besides time that frames depend on. True if stored frames were dropped
+	bool setScene(uint64_t key);
+
+	void showHistory(float currentTime);
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Frame {
+		float time;
+		glm::uvec2 size;
+		std::shared_ptr<const std::vector<uint8_t>> data; // compressed RGB, bottom row first
+	};
+
+	// Filled by workers, collected by update
+	struct Shared {
+		std::mutex mtx;
+		uint32_t generation = 0;  // frames compressed before last clear are dropped
+		std::vector<Frame> compressed;
+
+		uint32_t ticket = 0;      // latest decode requested, older results are dropped
+		bool decoded = false;
+		glm::uvec2 size = { 0, 0 };
+		std::vector<uint8_t> rgb;
+	};
+
+	const Frame* closest(float time) const;
+
+private:
+	bool active = false;
+	bool enabled = false;
+	int32_t budget = 512;       // megabytes of compressed frames
+
+	bool requested = false;
+	float target = 0.0f;
+
+	bool displaying = false;
+	bool decoding = false;
+	float shownTime = -1.0f;    // frame currently in texture
+	uint64_t scene = 0;
+
+	std::deque<Frame> frames;   // in order of capture
+	size_t usedBytes = 0, rawBytes = 0;
+
+	Readback readback;
+	std::vector<float> inFlight; // times of readbacks not fetched yet
+
+	uint32_t texture = 0;
+	glm::uvec2 texSize = { 0, 0 };
+
+	std::shared_ptr<Shared> shared;
+	ThreadPool pool; // last, so workers stop before the rest goes away
+};
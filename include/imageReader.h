@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Decodes images into 8 bit pixels with rows from bottom to top, as expected by OpenGL.
+// Binary PPM and PGM are always supported, PNG and JPEG when built with libpng and libjpeg.
+
+struct Image {
+    uint32_t
+        width = 0,
+        height = 0,
+        channels = 0;   // 1, 3 or 4
+    std::vector<uint8_t> pixels;
+};
+
+class ImageReader {
+public:
+    // Format is recognized from the first bytes, not from the extension
+    static bool decode(const std::vector<uint8_t>& bytes, Image& image, std::string& error);
+    static bool load(const std::filesystem::path& path, Image& image, std::string& error);
+
+    static std::vector<uint8_t> readFile(const std::filesystem::path& path);
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+// Streams a binary PPM image to disk one band of rows at a time.
+// Only the band being written needs to live in memory, so huge images are fine.
+
+class ImageWriter {
+public:
+    ImageWriter(void) = default;
+    ~ImageWriter(void);
+
+    bool open(const std::filesystem::path& path, uint32_t width, uint32_t height);
+    bool isOpen(void) const;
+
+    // Rows are tightly packed RGB and go from top to bottom
+    void writeRows(const uint8_t* rgb, uint32_t numRows);
+    bool close(void);
+
+    // Writes a whole image at once, rows ordered from bottom to top as read from OpenGL
+    static bool save(const std::filesystem::path& path, uint32_t width, uint32_t height, const uint8_t* rgb);
+
+private:
+    std::ofstream arq;
+    uint32_t
+        width = 0,
+        height = 0,
+        rowsWritten = 0;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Read-only view of a whole file through virtual memory.
+// Nothing is read when opening, pages are only loaded by the system once they are touched.
+
+class MappedFile {
+public:
+    MappedFile(void) = default;
+    MappedFile(const std::filesystem::path& path);
+    ~MappedFile(void);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&&) noexcept;
+    MappedFile& operator=(MappedFile&&) noexcept;
+
+    bool isOpen(void) const { return data != nullptr; }
+    const uint8_t* getData(void) const { return data; }
+    size_t getSize(void) const { return size; }
+
+private:
+    void release(void);
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void* file = nullptr;       // HANDLE
+    void* mapping = nullptr;    // HANDLE
+#else
+    int fd = -1;
+#endif
+};
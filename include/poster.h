@@ -0,0 +1,53 @@
+#pragma once
+
+#include "imageWriter.h"
+#include "renderTarget.h"
+
+#include <filesystem>
+#include <vector>
+
+// Renders stills larger than what the GPU can hold as a grid of tiles.
+// Tiles are rendered top row first and each finished row of tiles is streamed to disk,
+// so memory usage is bounded by one band of 'width x tileHeight' pixels.
+
+class Poster {
+public:
+	Poster(void) = default;
+	~Poster(void) = default;
+
+	void showPoster(void);
+	bool requested(void); // true once after user pressed "Render..."
+
+	bool start(const std::filesystem::path& path, float time);
+	void cancel(void);
+	bool isRendering(void) const;
+
+	// Binds tile target and returns its offset in pixels within the full image
+	glm::ivec2 beginTile(void);
+	// Reads back current tile and moves to next one
+	void endTile(void);
+
+	const glm::uvec2& getResolution(void) const { return resolution; }
+	const glm::uvec2& getTileSize(void) const { return tileSize; }
+	int32_t getTilesPerFrame(void) const { return tilesPerFrame; }
+	float getTime(void) const { return time; }
+
+	void open(void);
+	void close(void);
+
+private:
+	bool active = false;
+	bool startOn = false;
+	bool rendering = false;
+
+	glm::uvec2 resolution = { 7680, 4320 };
+	glm::uvec2 tileSize = { 1024, 1024 };
+	int32_t tilesPerFrame = 1;
+
+	float time = 0.0f;
+	glm::uvec2 numTiles = { 0, 0 }, current = { 0, 0 }; // tile column and row (from top)
+
+	RenderTarget tile;
+	ImageWriter writer;
+	std::vector<uint8_t> band, pixels;
+};
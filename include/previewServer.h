@@ -0,0 +1,82 @@
+#pragma once
+
+#include "threadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Small HTTP server bound to localhost streaming rendered frames as MJPEG.
+//   /           -> page displaying the stream
+//   /stream     -> multipart/x-mixed-replace stream of JPEG frames
+//   /frame.jpg  -> most recent frame
+// Frames are encoded on a worker pool. Each client always receives the newest frame
+// available, so a slow client simply skips frames and never holds back rendering.
+// While the view is paused, streams repeat their last frame and requests made before
+// any frame was drawn are answered with 503.
+
+class PreviewServer {
+	using Socket = intptr_t;
+	using Frame = std::shared_ptr<const std::vector<uint8_t>>;
+	struct Client;
+
+	enum class Wait : int32_t { FRAME, TIMEOUT, STOPPED };
+	static constexpr int32_t WAIT_MS = 2000; // before repeating a frame or giving up
+
+public:
+	PreviewServer(void);
+	~PreviewServer(void);
+
+	PreviewServer(const PreviewServer&) = delete;
+	PreviewServer& operator=(const PreviewServer&) = delete;
+
+	bool start(uint16_t port);
+	void stop(void);
+	bool isRunning(void) const;
+
+	// Only worth reading frames back if someone is watching
+	bool wantsFrames(void) const;
+
+	// Image is tightly packed RGB with bottom row first, as read from OpenGL
+	void publish(std::vector<uint8_t>&& rgb, const glm::uvec2& size);
+
+	void showServer(void);
+
+	void open(void);
+	void close(void);
+
+private:
+	void acceptLoop(void);
+	void serveClient(std::shared_ptr<Client> client);
+	Wait waitFrame(uint64_t& lastID, Frame& frame);
+
+	static bool encodeJPEG(const std::vector<uint8_t>& rgb, const glm::uvec2& size, int32_t quality, std::vector<uint8_t>& jpeg);
+
+private:
+	bool active = false;
+	int32_t port = 8080;
+	std::atomic<int32_t> quality{ 80 };
+
+	std::atomic<bool> running{ false };
+	Socket listener = -1;
+	std::thread acceptThread;
+	std::unique_ptr<ThreadPool> encoders;
+
+	// Latest encoded frame shared by every client
+	std::mutex mtx;
+	std::condition_variable cvFrame;
+	Frame latest;
+	uint64_t latestID = 0, publishID = 0;
+
+	std::mutex mtxClients;
+	std::vector<std::shared_ptr<Client>> clients;
+
+	// Statistics
+	std::atomic<uint32_t> numClients{ 0 };
+	std::atomic<uint64_t> numEncoded{ 0 }, numDropped{ 0 };
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped CPU timers written to per-thread ring buffers. Instrumentation compiles to nothing
+// unless GSHADER_PROFILING is defined, so it can stay in the code at no cost.
+// Captured events are shown as a flame graph and exported as Chrome trace JSON.
+
+#ifdef GSHADER_PROFILING
+#define GSHADER_PROFILE_CONCAT_(a, b) a##b
+#define GSHADER_PROFILE_CONCAT(a, b) GSHADER_PROFILE_CONCAT_(a, b)
+#define GSHADER_PROFILE_SCOPE(name) Profiler::Scope GSHADER_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define GSHADER_PROFILE_FUNCTION() GSHADER_PROFILE_SCOPE(__func__)
+#define GSHADER_PROFILE_FRAME() Profiler::frame()
+#else
+#define GSHADER_PROFILE_SCOPE(name)
+#define GSHADER_PROFILE_FUNCTION()
+#define GSHADER_PROFILE_FRAME()
+#endif
+
+class Profiler {
+public:
+	struct Event {
+		const char* name = nullptr;   // must outlive profiler, string literals in practice
+		uint64_t start = 0, end = 0;  // nanoseconds
+		uint32_t depth = 0;
+	};
+
+	class Scope {
+	public:
+		Scope(const char* name);
+		~Scope(void);
+
+	private:
+		const char* name;
+		uint64_t start;
+	};
+
+public:
+	Profiler(void) = default;
+	~Profiler(void) = default;
+
+	static void frame(void); // marks beginning of a new frame on calling thread
+	static bool enabled(void);
+
+	void showProfiler(void);
+	bool exportRequested(void); // true once after user pressed "Export..."
+	bool exportTrace(const std::filesystem::path& path) const;
+
+	void open(void);
+	void close(void);
+
+private:
+	static constexpr size_t CAPACITY = 1 << 14;
+
+	struct Ring {
+		uint32_t id = 0;
+		std::string name;
+		std::atomic<uint64_t> head = { 0 };  // number of events ever written
+		std::array<Event, CAPACITY> events;
+		uint32_t depth = 0;
+		uint64_t lastEnd = 0;                // end of last top level event
+		uint64_t frameBegin = 0, frameEnd = 0;
+	};
+
+	struct Registry {
+		std::mutex mtx;
+		std::vector<std::shared_ptr<Ring>> rings;
+	};
+
+	static Registry& registry(void);
+	static Ring& local(void);
+	static uint64_t now(void);
+	static void push(Ring& ring, const Event& event);
+
+	// Consistent copy of whatever a ring still holds
+	static std::vector<Event> snapshot(const Ring& ring);
+
+private:
+	bool active = false;
+	bool exportOn = false;
+	bool paused = false;
+
+	// Last complete frame and events of every thread during it
+	uint64_t frameBegin = 0, frameEnd = 0;
+	uint32_t maxDepth = 0;
+	std::vector<std::pair<std::string, std::vector<Event>>> lanes;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Reads frames back from the GPU through a small ring of pixel buffers.
+// Data is only mapped once its fence has signaled, so the render loop never stalls.
+
+class Readback {
+public:
+    Readback(void) = default;
+    ~Readback(void);
+
+    Readback(const Readback&) = delete;
+    Readback& operator=(const Readback&) = delete;
+
+    // Queues a read of the currently bound read framebuffer. Dropped if ring is full
+    bool capture(uint32_t width, uint32_t height);
+
+    // Copies oldest completed capture as tightly packed RGB (bottom row first)
+    bool fetch(std::vector<uint8_t>& rgb, glm::uvec2& size);
+
+    // Drops every capture still in flight
+    void clear(void);
+
+private:
+    struct Slot {
+        uint32_t pbo = 0;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+        glm::uvec2 size = { 0, 0 };
+    };
+
+    std::array<Slot, 3> slots;
+    uint32_t head = 0, count = 0;
+};
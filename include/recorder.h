@@ -0,0 +1,104 @@
+#pragma once
+
+#include "colors.h"
+#include "gpuTimer.h"
+#include "uniforms.h"
+
+#include "GRender/camera.h"
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Records every input that influences a frame into a compact binary log, so a session
+// can be replayed frame by frame, either in the interface or headless as a performance test.
+// Camera, mouse and values are only stored when they change since previous frame.
+
+class Recorder {
+	using Clock = std::chrono::steady_clock;
+
+public:
+	struct Edit {
+		uint8_t kind = 0;                 // 0 for uniform, 1 for color, 2 and 3 remove one of them
+		uniform::Type tp = uniform::Type::NONE;
+		std::string name;                 // with '##' prefix
+		int32_t count = 1;                // elements of arrays
+		std::array<uint32_t, 2> range = { 0, 0 };
+		std::vector<uint32_t> value;      // raw bits of int or float components
+	};
+
+	struct Frame {
+		float deltaTime = 0.0f;
+		bool render = true, play = false, step = false, reset = false;
+
+		glm::vec3 position = { 0.0f, 0.0f, 0.0f };
+		float yaw = 0.0f, pitch = 0.0f, fov = 0.0f;
+		glm::vec2 cursor = { 0.0f, 0.0f };
+
+		std::vector<Edit> edits;
+	};
+
+public:
+	Recorder(void) = default;
+	~Recorder(void) = default;
+
+	bool startRecording(const std::filesystem::path& path, const std::filesystem::path& shaderpath, float time, bool playing);
+	void stopRecording(void);
+	bool isRecording(void) const { return recording; }
+
+	// Stores frame, adding the edits made to uniforms and colors since last one
+	void record(Frame& frame, const uniform::Uniform& uniforms, const Colors& colors);
+
+	bool startReplay(const std::filesystem::path& path, bool headless);
+	bool isReplaying(void) const { return replaying; }
+
+	// Next frame of the log. Returns false once log is over, reporting timings
+	bool next(Frame& frame);
+	static void apply(const Frame& frame, uniform::Uniform& uniforms, Colors& colors, GRender::Camera& camera);
+
+	// Brackets drawing of each replayed frame to collect GPU timings
+	void beginTiming(void);
+	void endTiming(void);
+
+	const std::filesystem::path& getShader(void) const { return shaderpath; }
+	float getStartTime(void) const { return startTime; }
+	bool getStartPlaying(void) const { return startPlaying; }
+
+	void showRecorder(void);
+	bool recordRequested(void); // true once after user pressed "Record..."
+	bool replayRequested(void); // true once after user pressed "Replay..."
+
+	void open(void);
+	void close(void);
+
+private:
+	void finish(void);
+
+private:
+	bool active = false;
+	bool recordOn = false, replayOn = false;
+
+	bool recording = false, replaying = false, headless = false;
+	std::ofstream output;
+	std::ifstream input;
+
+	std::filesystem::path shaderpath;
+	float startTime = 0.0f;
+	bool startPlaying = true;
+
+	// Last stored state, used to only write changes
+	bool hasLast = false;
+	Frame last;
+	std::map<std::string, Edit> values;
+
+	// Replay statistics
+	uint64_t numFrames = 0;
+	Clock::time_point begin;
+	std::vector<double> cpuTimes, gpuTimes;
+	Clock::time_point frameStart;
+	GpuTimer timer;
+};
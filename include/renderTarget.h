@@ -0,0 +1,40 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Off-screen color target with a known internal format.
+// Used whenever the shader has to be drawn somewhere else than the viewport.
+class RenderTarget {
+public:
+    RenderTarget(void) = default;
+    RenderTarget(uint32_t width, uint32_t height, GLenum format = GL_RGBA8);
+    ~RenderTarget(void);
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    RenderTarget(RenderTarget&&) noexcept;
+    RenderTarget& operator=(RenderTarget&&) noexcept;
+
+    void bind(void);
+    void unbind(void);
+
+    // Reads a region of the color attachment as tightly packed RGB bytes (bottom row first)
+    void readRGB(int32_t x, int32_t y, uint32_t width, uint32_t height, uint8_t* rgb) const;
+
+    uint32_t getID(void) const { return texID; }
+    uint32_t getFramebufferID(void) const { return bufferID; }
+    const glm::uvec2& getSize(void) const { return size; }
+    GLenum getFormat(void) const { return format; }
+
+private:
+    uint32_t
+        bufferID = 0,   // framebuffer object
+        texID = 0;      // color attachment
+
+    GLenum format = GL_RGBA8;
+    glm::uvec2 size = { 0, 0 };
+};
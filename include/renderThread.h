@@ -0,0 +1,114 @@
+#pragma once
+
+#include "dynamicShader.h"
+#include "renderTarget.h"
+#include "uniforms.h"
+#include "colors.h"
+
+#include "GRender/camera.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct GLFWwindow;
+
+// Latest value handed from a single producer thread to a single consumer without locks.
+// Producer fills the back slot and swaps it with the middle one; consumer takes the middle
+// slot only when it holds something newer than its front one. Neither side ever waits.
+template <typename TP>
+class TripleBuffer {
+public:
+    TP& back(void) { return slots[backIndex]; }
+    void publish(void) { backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // True if front was replaced by a newer value
+    bool acquire(void) {
+        if ((middle.load(std::memory_order_acquire) & FRESH) == 0)
+            return false;
+
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    TP& front(void) { return slots[frontIndex]; }
+
+    // Only while neither side is using the buffer
+    std::array<TP, 3>& all(void) { return slots; }
+
+private:
+    static constexpr uint8_t INDEX = 3, FRESH = 4;
+
+    std::array<TP, 3> slots;
+    uint8_t backIndex = 0, frontIndex = 1;
+    std::atomic<uint8_t> middle = { 2 };
+};
+
+// Draws the main view on its own thread and context, shared with the interface one, so a slow
+// shader no longer holds back sliders and windows. Every interface frame publishes a snapshot
+// of the parameters; the render thread always picks the latest one and publishes finished
+// frames through a second triple buffer, after a fence confirms the GPU is done with them.
+
+class RenderThread {
+public:
+    struct Snapshot {
+        std::filesystem::path shaderpath;
+        bool modules = false, pruning = false;
+
+        glm::uvec2 resolution = { 0, 0 };
+        float time = 0.0f;
+        glm::vec2 cursor = { 0.0f, 0.0f };
+
+        GRender::Camera camera;
+        Colors colors;
+        uniform::Uniform uniforms;
+    };
+
+    // Binds program and submits uniforms of a snapshot. Called from render thread
+    using Setup = std::function<void(DynamicShader&, Snapshot&)>;
+
+public:
+    RenderThread(void) = default;
+    ~RenderThread(void);
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // Must be called from interface thread, with its context current
+    bool start(Setup setup);
+    void stop(void);
+    bool isRunning(void) const { return window != nullptr; }
+
+    // Snapshot is filled in place and handed over by 'submit'
+    Snapshot& snapshot(void) { return snapshots.back(); }
+    void submit(void);
+
+    // Texture of latest finished frame, 0 until the first one arrives
+    uint32_t getTexture(void);
+    float getFrameTime(void) const { return frameTime.load(std::memory_order_relaxed); }
+
+private:
+    struct Frame {
+        RenderTarget target;
+    };
+
+    void run(void);
+
+private:
+    GLFWwindow* window = nullptr;
+    Setup setup;
+
+    TripleBuffer<Snapshot> snapshots;
+    TripleBuffer<Frame> frames;
+    std::atomic<float> frameTime = { 0.0f };  // milliseconds, including wait for GPU
+
+    // Only used to sleep while there is nothing to draw
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool pending = false, stopping = false;
+
+    std::thread worker;
+};
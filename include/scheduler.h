@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+
+// Decides how often frames are produced depending on window state, so an unfocused,
+// minimized or paused GShader doesn't keep the GPU busy.
+
+class Scheduler {
+	using Clock = std::chrono::steady_clock;
+
+public:
+	struct Policy {
+		float focusedFPS = 0.0f;      // 0 means no limit
+		float unfocusedFPS = 10.0f;
+		float pausedFPS = 4.0f;       // refresh rate while paused if no events arrive
+		bool renderMinimized = false;
+	};
+
+public:
+	Scheduler(void) = default;
+	~Scheduler(void) = default;
+
+	// Waits according to policy. Returns false if shader should not be rendered this frame
+	bool wait(bool playing);
+
+	void showScheduler(void);
+	bool wasModified(void); // true once after an edit of policy in the interface was completed
+
+	const Policy& getPolicy(void) const { return policy; }
+	void setPolicy(const Policy& pol) { policy = pol; }
+
+	void open(void);
+	void close(void);
+
+private:
+	// Waits for events until deadline or, if 'wakeOnEvent', until the first event
+	void waitUntil(Clock::time_point deadline, bool wakeOnEvent);
+
+	bool active = false;
+	bool modified = false;
+
+	Policy policy;
+	const char* state = "Focused";
+	Clock::time_point lastFrame = Clock::now();
+};
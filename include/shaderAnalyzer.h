@@ -0,0 +1,74 @@
+#pragma once
+
+#include "glsl.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+class DynamicShader;
+
+// Estimates worst-case number of invocations per pixel of every function reachable
+// from main, using constant loop bounds and call multiplicities.
+
+class ShaderAnalyzer {
+public:
+	struct Entry {
+		std::string name, location;
+		double invocations = 0.0;   // worst-case calls per pixel
+		double weight = 0.0;        // invocations times number of statements
+		bool bounded = true;        // false if a loop with unknown bound was involved
+		std::vector<std::string> callees;
+	};
+
+public:
+	ShaderAnalyzer(void) = default;
+	~ShaderAnalyzer(void) = default;
+
+	void analyze(const DynamicShader& shader);
+	void analyze(const std::string& source);
+	const std::vector<Entry>& getEntries(void) const { return entries; }
+
+	void showAnalysis(void);
+	bool requested(void); // true once after user pressed "Analyze"
+	void invalidate(void); // source changed, analyzed again only if the panel is open
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Bound {
+		int64_t value = 1;
+		int32_t param = -1;   // if bound is given by a parameter of the function
+		int64_t offset = 0;   // iterations = param value - offset
+		bool known = true;
+	};
+
+	struct CallSite {
+		std::string callee;
+		std::vector<std::string> args;
+		std::vector<Bound> loops;  // enclosing loops
+	};
+
+	struct Node {
+		std::vector<std::string> params;
+		std::vector<CallSite> calls;
+		int32_t statements = 0;
+		size_t begin = 0;
+	};
+
+	void parseBody(const std::string& src, const glsl::Function& fn, Node& node);
+	Bound parseLoop(const std::string& header, const Node& node);
+	int64_t evaluate(const std::string& expr, const std::string& caller, bool& known);
+	int64_t paramValue(const std::string& fn, int32_t param, bool& known);
+
+private:
+	bool active = false;
+	bool analyzeOn = false;
+
+	std::map<std::string, int64_t> constants;
+	std::map<std::string, Node> nodes;
+	std::map<std::string, std::map<int32_t, int64_t>> paramCache;
+	std::vector<Entry> entries;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Streams data to the GPU through one persistently mapped staging buffer split in slots.
+// Every copy out of a slot is fenced and the slot is only written again once the fence has
+// signaled, so uploads never wait for the GPU nor overwrite data still being copied.
+
+class StagingRing {
+public:
+    static constexpr size_t NUM_SLOTS = 4;
+
+public:
+    StagingRing(size_t slotSize = size_t(8) << 20);
+    ~StagingRing(void);
+
+    StagingRing(const StagingRing&) = delete;
+    StagingRing& operator=(const StagingRing&) = delete;
+
+    // Free slot to write into, nullptr while every slot is in flight
+    uint8_t* acquire(void);
+
+    // Copies first 'bytes' of acquired slot into a buffer and fences the slot
+    void copyToBuffer(uint32_t buffer, size_t offset, size_t bytes);
+    // Copies tightly packed 8 bit rows of acquired slot into base level of a texture and fences the slot
+    void copyToTexture(uint32_t texture, int32_t x, int32_t y, uint32_t width, uint32_t height, GLenum format);
+
+    size_t getSlotSize(void) const { return slotSize; }
+
+private:
+    void release(void);
+
+    size_t slotSize = 0;
+    uint32_t bufferID = 0;
+    uint8_t* mapped = nullptr;
+
+    std::array<GLsync, NUM_SLOTS> fences = {};
+    uint32_t current = 0;
+    bool acquired = false;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "colors.h"
+#include "renderTarget.h"
+#include "uniforms.h"
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Renders a grid of thumbnails for every combination of values of one or two
+// uniforms or colors. All tiles come from a single instanced draw: the swept
+// uniforms are turned into globals filled per instance from a storage buffer.
+
+class Sweep {
+public:
+	struct Axis {
+		std::string name;          // as stored in Uniform or Colors, with '##' prefix
+		int32_t component = 0;
+		float from = 0.0f, to = 1.0f;
+		int32_t count = 5;
+	};
+
+public:
+	Sweep(void) = default;
+	~Sweep(void);
+
+	void showSweep(const uniform::Uniform& uniforms, const Colors& colors);
+	bool requested(void);     // true once after user pressed "Render"
+	bool saveRequested(void); // true once after user pressed "Save..."
+
+	// Compiles sweep version of shader, uploads values and binds contact sheet
+	bool begin(const std::filesystem::path& shaderpath, const uniform::Uniform& uniforms, const Colors& colors);
+	// Issues instanced draw. Shader must have been set up after 'begin'
+	void end(void);
+
+	bool save(const std::filesystem::path& path);
+
+	DynamicShader& getShader(void) { return shader; }
+	const glm::uvec2& getTileSize(void) const { return tileSize; }
+
+	// Replaces declarations of swept uniforms by globals set from the storage buffer
+	static std::string transform(const std::string& src, const std::vector<std::string>& names, const std::vector<uniform::Type>& types);
+
+	void open(void);
+	void close(void);
+
+private:
+	struct Target {
+		std::string name;
+		uniform::Type tp = uniform::Type::NONE;
+		glm::vec4 value = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glm::vec2 range = { 0.0f, 1.0f };
+	};
+
+	std::vector<Target> gather(const uniform::Uniform& uniforms, const Colors& colors) const;
+	float valueAt(const Axis& axis, int32_t k) const;
+
+private:
+	bool active = false;
+	bool renderOn = false, saveOn = false;
+	bool initialized = false;
+
+	std::array<Axis, 2> axes;
+	bool useSecond = false;
+	glm::uvec2 tileSize = { 256, 144 };
+	glm::ivec2 grid = { 0, 0 };
+
+	DynamicShader shader;
+	RenderTarget sheet;
+	uint32_t bufferID = 0, vaoID = 0;
+
+	std::vector<std::string> names; // swept uniforms, in buffer order
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads consuming jobs in submission order
+
+class ThreadPool {
+public:
+    ThreadPool(uint32_t numThreads = std::thread::hardware_concurrency());
+    ~ThreadPool(void);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void(void)> job);
+    void wait(void); // blocks until every submitted job has finished
+
+    size_t pending(void);  // jobs queued or running
+    uint32_t size(void) const { return uint32_t(workers.size()); }
+
+private:
+    void run(void);
+
+    bool stop = false;
+    size_t running = 0;
+
+    std::mutex mtx;
+    std::condition_variable cvJob, cvDone;
+    std::queue<std::function<void(void)>> jobs;
+    std::vector<std::thread> workers;
+};
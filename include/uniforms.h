@@ -5,6 +5,9 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
+
+namespace expr { class Program; }
 
 namespace uniform {
 
@@ -14,18 +17,25 @@ enum class Type : int32_t {
 	INT, IVEC2, IVEC3, IVEC4,
 	// float types
 	FLOAT, VEC2, VEC3, VEC4,
+	// square matrices of floats, column major like glsl
+	MAT2, MAT3, MAT4,
 	// total numner of types
 	TOTAL
 };
 
+constexpr int32_t MAX_COUNT = 256; // elements of an array, for files as well as the interface
+
 ///////////////////////////////////////////////////////////////////////////////
 
 struct ParentData {
-	ParentData(const std::string& _name, Type _tp)
-		: name(_name), tp(_tp) {}
+	ParentData(const std::string& _name, Type _tp, int32_t _count = 1)
+		: name(_name), tp(_tp), count(_count) {}
 
 	std::string name;
 	Type tp;
+	int32_t count; // number of elements, more than one for arrays
+	bool knob = false; // lowered by quality governor while navigating
+	std::shared_ptr<const expr::Program> expression; // value computed every frame, see 'expression.h'
 };
 
 template<size_t N, typename TP>
@@ -37,6 +47,25 @@ struct Data : public ParentData {
 	glm::vec<N, TP> data;
 };
 
+template<size_t N>
+struct MatData : public ParentData {
+	MatData(const std::string& name, Type _tp, glm::vec2 _range, glm::mat<N, N, float> _data)
+		: ParentData(name, _tp), range(_range), data(_data) {}
+
+	glm::vec2 range;
+	glm::mat<N, N, float> data;
+};
+
+// Arrays of any of the types above, sent to shader in a single call
+template<typename TP>
+struct ArrayData : public ParentData {
+	ArrayData(const std::string& name, Type _tp, int32_t _count, glm::vec<2, TP> _range)
+		: ParentData(name, _tp, _count), range(_range) {}
+
+	glm::vec<2, TP> range;
+	std::vector<TP> data;
+};
+
 // Some helpers for commonly used specializations
 using DataInt = Data<1, int32_t>;
 using DataInt2 = Data<2, int32_t>;
@@ -48,16 +77,48 @@ using DataFloat2 = Data<2, float>;
 using DataFloat3 = Data<3, float>;
 using DataFloat4 = Data<4, float>;
 
+using DataMat2 = MatData<2>;
+using DataMat3 = MatData<3>;
+using DataMat4 = MatData<4>;
+
+// Type independent access to values, used by tools that don't care about the exact type
+int32_t numComponents(Type tp);              // per element
+int32_t numValues(const ParentData* ptr);     // components of all elements
+void* dataPointer(ParentData* ptr);
+void* rangePointer(ParentData* ptr);
+ParentData* create(const std::string& name, Type tp, int32_t count = 1); // zero initialized, identity matrices
+ParentData* copy(const std::string& name, const ParentData* ptr);
+
+Type fromGL(GLenum type);       // NONE for samplers and other types without an editor
+const char* glslName(Type tp);
+
+// Uniform declaration followed by a comment starting with '@' and a keyword, like
+//     uniform int octaves; // @quality 4 12
+struct Annotation {
+	std::string type, name;
+	std::string args; // rest of the line, may be empty
+};
+
+// Comments are part of annotations, so 'source' must be the expanded one, as compiled
+std::vector<Annotation> findAnnotations(const std::string& source, const std::string& keyword);
+
 ///////////////////////////////////////////////////////////////////////////////
 
 class Uniform {
 public:
 	void append(const std::string& name, ParentData* ptr);
+	ParentData* find(const std::string& name); // nullptr if absent
+	void remove(const std::string& name);
+	Uniform clone(void) const;                  // deep copy of every value
 
 	void addUniform(void);
 	void showUniforms(void);
 	void submit(const DynamicShader& shader);
 
+	// Flags uniforms the shader doesn't use or declares with another type or size, and finds
+	// the ones it declares but nothing assigns, which can then be created from the window
+	void reflect(const DynamicShader& shader);
+
 	void open();
 	void close();
 
@@ -75,11 +136,31 @@ private:
 
 	template <typename TP>
 	void showData(ParentData* ptr, std::string& toRemove);
+	void showBlock(ParentData* ptr, std::string& toRemove); // arrays and matrices
+	bool rename(ParentData* ptr, const char* local);
+
+	// Name fields are tinted by their issue, which shows when hovering them
+	bool pushIssue(const std::string& name);
+	void popIssue(const std::string& name);
 
 private:
 	bool addOn = false;
 	bool active = false;
 	std::map<std::string, std::unique_ptr<ParentData>> mData;
+
+	struct Issue {
+		bool mismatch;  // otherwise just unused
+		std::string message;
+	};
+
+	struct Missing {
+		std::string name;
+		Type tp;
+		int32_t count;
+	};
+
+	std::map<std::string, Issue> issues;
+	std::vector<Missing> missing;
 };
 
 } // namespace uniform
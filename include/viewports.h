@@ -0,0 +1,95 @@
+#pragma once
+
+#include "colors.h"
+#include "dynamicShader.h"
+#include "gpuTimer.h"
+#include "renderTarget.h"
+#include "uniforms.h"
+
+#include "GRender/camera.h"
+
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Extra viewports shown next to the main one, each with its own shader, configuration and camera.
+// They share a per-frame GPU time budget: the hovered view gets the largest share, while the
+// others first lower their resolution and then their frame rate until the estimated cost fits.
+
+class Viewports {
+public:
+	static constexpr int32_t MAX_INTERVAL = 30; // frames between updates of a background view
+
+	struct View {
+		uint32_t id = 0;
+		std::filesystem::path shaderpath;
+
+		DynamicShader shader;
+		Colors colors;
+		uniform::Uniform uniforms;
+		GRender::Camera camera;
+		bool syncCamera = false;      // follows camera of main viewport
+
+		RenderTarget target;
+		GpuTimer timer;
+		std::deque<uint64_t> pending; // pixels drawn by each measurement in flight
+		double costPerPixel = 0.0;    // milliseconds, smoothed over frames
+
+		float scale = 1.0f;           // resolution relative to window
+		int32_t interval = 1;         // frames between updates
+		uint64_t lastFrame = 0;
+
+		glm::uvec2 size = { 1, 1 };   // window region
+		glm::vec2 cursor = { 0.0f, 0.0f };
+		bool hovered = false, open = true;
+	};
+
+public:
+	Viewports(void) = default;
+	~Viewports(void) = default;
+
+	// Shader or configuration file
+	void add(const std::filesystem::path& path);
+	// Copy of main viewport, useful to compare variants of the same scene
+	void add(const std::filesystem::path& shaderpath, const Colors& colors, const uniform::Uniform& uniforms, const GRender::Camera& camera);
+
+	void setModules(bool value);
+
+	// Reloads modified shaders and moves camera of hovered view
+	void update(float deltaTime, bool playing, const GRender::Camera& mainCamera);
+
+	// Views to draw this frame after distributing budget. All of them if 'force' is set
+	std::vector<View*> schedule(bool force);
+	// Binds target of a view, returns its resolution
+	glm::uvec2 begin(View& view);
+	void end(View& view);
+
+	bool hasViews(void) const { return !views.empty(); }
+	bool isHovered(void) const;
+
+	void showViewports(void);
+	bool addRequested(void);       // true once after "Add viewport..." was pressed
+	bool duplicateRequested(void); // true once after "Duplicate main" was pressed
+
+	void open(void);
+	void close(void);
+
+private:
+	bool load(View& view, const std::filesystem::path& path);
+	void distribute(void);
+
+private:
+	bool active = false;
+	bool addOn = false, duplicateOn = false;
+	bool useModules = false;
+
+	float budget = 8.0f;          // milliseconds per frame for every extra view together
+	float minScale = 0.25f;
+	float hoverWeight = 4.0f;     // share of hovered view relative to a background one
+
+	uint64_t frame = 0;
+	uint32_t nextID = 1;
+	std::vector<std::unique_ptr<View>> views;
+};
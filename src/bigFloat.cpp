@@ -0,0 +1,217 @@
+#include "bigFloat.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+BigFloat BigFloat::fromDouble(double value, uint32_t numLimbs) {
+    BigFloat out(std::max(numLimbs, 1u));
+    out.negative = value < 0.0;
+
+    // Scaling by powers of two is exact, so every bit of the double lands in place
+    double rest = std::abs(value);
+    for (uint32_t k = 0; k < out.limbs.size() && rest > 0.0; k++) {
+        double whole = std::floor(rest);
+        out.limbs[k] = uint32_t(whole);
+        rest = std::ldexp(rest - whole, 32);
+    }
+
+    return out;
+}
+
+BigFloat BigFloat::fromString(const std::string& text, uint32_t numLimbs) {
+    BigFloat out(std::max(numLimbs, 1u));
+
+    size_t pos = 0;
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+        pos++;
+
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+'))
+        out.negative = text[pos++] == '-';
+
+    uint32_t whole = 0;
+    for (; pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])); pos++)
+        whole = 10 * whole + uint32_t(text[pos] - '0');
+
+    std::string fraction;
+    if (pos < text.size() && text[pos] == '.') {
+        for (pos++; pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])); pos++)
+            fraction += text[pos];
+    }
+
+    // Horner from the last digit, each step adding a digit and dividing by ten
+    for (auto it = fraction.rbegin(); it != fraction.rend(); ++it) {
+        out.limbs[0] = uint32_t(*it - '0');
+        out.divSmall(10);
+    }
+    out.limbs[0] = whole;
+
+    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+        int32_t exponent = std::atoi(text.c_str() + pos + 1);
+        for (int32_t k = 0; k < std::abs(exponent); k++)
+            exponent < 0 ? out.divSmall(10) : out.mulSmall(10);
+    }
+
+    if (out.isZero())
+        out.negative = false;
+
+    return out;
+}
+
+std::string BigFloat::toString(uint32_t digits) const {
+    std::string out = negative ? "-" : "";
+    out += std::to_string(limbs.empty() ? 0 : limbs[0]) + ".";
+
+    BigFloat rest = *this;
+    for (uint32_t k = 0; k < digits; k++) {
+        rest.limbs[0] = 0;
+        rest.mulSmall(10);
+        out += char('0' + rest.limbs[0]);
+    }
+
+    return out;
+}
+
+double BigFloat::toDouble(void) const {
+    // From the smallest limb up, so tiny values keep their precision
+    double value = 0.0;
+    for (auto it = limbs.rbegin(); it != limbs.rend(); ++it)
+        value = std::ldexp(value, -32) + double(*it);
+
+    return negative ? -value : value;
+}
+
+void BigFloat::setLimbs(uint32_t numLimbs) {
+    limbs.resize(std::max(numLimbs, 1u), 0);
+}
+
+uint32_t BigFloat::limbsFor(double scale, uint32_t guard) {
+    double bits = std::max(-std::log2(scale), 0.0) + double(guard);
+    return 1 + uint32_t(std::ceil(bits / 32.0));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+BigFloat BigFloat::operator-(void) const {
+    BigFloat out = *this;
+    out.negative = !negative && !isZero();
+    return out;
+}
+
+BigFloat operator+(const BigFloat& a, const BigFloat& b) {
+    if (a.negative == b.negative) {
+        BigFloat out = BigFloat::addMagnitudes(a, b);
+        out.negative = a.negative && !out.isZero();
+        return out;
+    }
+
+    // Signs differ, so the larger magnitude decides the sign
+    const bool aLarger = BigFloat::compare(a, b) >= 0;
+    BigFloat out = aLarger ? BigFloat::subMagnitudes(a, b) : BigFloat::subMagnitudes(b, a);
+    out.negative = (aLarger ? a.negative : b.negative) && !out.isZero();
+    return out;
+}
+
+BigFloat operator-(const BigFloat& a, const BigFloat& b) {
+    return a + (-b);
+}
+
+BigFloat operator*(const BigFloat& a, const BigFloat& b) {
+    const uint32_t num = uint32_t(std::max(a.limbs.size(), b.limbs.size()));
+
+    // Each limb collects 32 bits halves of partial products, carried once at the end.
+    // Products below the last limb are dropped, except for the one limb just below it
+    std::vector<uint64_t> acc(num + 1, 0);
+    for (size_t i = 0; i < a.limbs.size(); i++) {
+        if (a.limbs[i] == 0)
+            continue;
+
+        for (size_t j = 0; j < b.limbs.size() && i + j <= num; j++) {
+            uint64_t prod = uint64_t(a.limbs[i]) * uint64_t(b.limbs[j]);
+            acc[i + j] += prod & 0xFFFFFFFFu;
+            if (i + j > 0)
+                acc[i + j - 1] += prod >> 32;
+        }
+    }
+
+    for (size_t k = num; k > 0; k--) {
+        acc[k - 1] += acc[k] >> 32;
+        acc[k] &= 0xFFFFFFFFu;
+    }
+
+    BigFloat out(num);
+    for (uint32_t k = 0; k < num; k++)
+        out.limbs[k] = uint32_t(acc[k]);
+
+    out.negative = a.negative != b.negative && !out.isZero();
+    return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+int32_t BigFloat::compare(const BigFloat& a, const BigFloat& b) {
+    const uint32_t num = uint32_t(std::max(a.limbs.size(), b.limbs.size()));
+    for (size_t k = 0; k < num; k++) {
+        uint32_t x = k < a.limbs.size() ? a.limbs[k] : 0;
+        uint32_t y = k < b.limbs.size() ? b.limbs[k] : 0;
+        if (x != y)
+            return x < y ? -1 : 1;
+    }
+    return 0;
+}
+
+BigFloat BigFloat::addMagnitudes(const BigFloat& a, const BigFloat& b) {
+    const uint32_t num = uint32_t(std::max(a.limbs.size(), b.limbs.size()));
+    BigFloat out(num);
+
+    uint64_t carry = 0;
+    for (size_t k = num; k > 0; k--) {
+        uint64_t x = k - 1 < a.limbs.size() ? a.limbs[k - 1] : 0;
+        uint64_t y = k - 1 < b.limbs.size() ? b.limbs[k - 1] : 0;
+        uint64_t sum = x + y + carry;
+        out.limbs[k - 1] = uint32_t(sum);
+        carry = sum >> 32;
+    }
+
+    return out;
+}
+
+BigFloat BigFloat::subMagnitudes(const BigFloat& a, const BigFloat& b) {
+    const uint32_t num = uint32_t(std::max(a.limbs.size(), b.limbs.size()));
+    BigFloat out(num);
+
+    int64_t borrow = 0;
+    for (size_t k = num; k > 0; k--) {
+        int64_t x = k - 1 < a.limbs.size() ? a.limbs[k - 1] : 0;
+        int64_t y = k - 1 < b.limbs.size() ? b.limbs[k - 1] : 0;
+        int64_t diff = x - y - borrow;
+        borrow = diff < 0 ? 1 : 0;
+        out.limbs[k - 1] = uint32_t(diff + (borrow << 32));
+    }
+
+    return out;
+}
+
+void BigFloat::divSmall(uint32_t den) {
+    uint64_t rem = 0;
+    for (uint32_t& limb : limbs) {
+        uint64_t cur = (rem << 32) | limb;
+        limb = uint32_t(cur / den);
+        rem = cur % den;
+    }
+}
+
+void BigFloat::mulSmall(uint32_t factor) {
+    uint64_t carry = 0;
+    for (auto it = limbs.rbegin(); it != limbs.rend(); ++it) {
+        uint64_t cur = uint64_t(*it) * factor + carry;
+        *it = uint32_t(cur);
+        carry = cur >> 32;
+    }
+}
+
+bool BigFloat::isZero(void) const {
+    return std::all_of(limbs.begin(), limbs.end(), [](uint32_t limb) { return limb == 0; });
+}
@@ -0,0 +1,524 @@
+#include "browser.h"
+#include "profiler.h"
+#include "colors.h"
+#include "uniforms.h"
+#include "configFile.h"
+#include "expression.h"
+#include "imageReader.h"
+#include "imageWriter.h"
+
+#include "GRender/camera.h"
+#include "GRender/mailbox.h"
+
+#include "imgui.h"
+#include "glm/gtc/type_ptr.hpp"
+#include "GLFW/glfw3.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// Full screen quad without vertex buffers
+static const char* vertexSource =
+	"#version 450 core\n"
+	"out vec2 fragCoord;\n"
+	"void main() {\n"
+	"    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+	"    fragCoord = corner;\n"
+	"    gl_Position = vec4(2.0 * corner - 1.0, 0.0, 1.0);\n"
+	"}\n";
+
+static uint64_t fnv1a(const std::string& data, uint64_t hash = 14695981039346656037ull) {
+	for (unsigned char ch : data) {
+		hash ^= ch;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static std::string readFile(const fs::path& path) {
+	std::ifstream arq(path, std::ios::binary);
+	std::stringstream ss;
+	ss << arq.rdbuf();
+	return ss.str();
+}
+
+static fs::file_time_type modificationTime(const fs::path& path) {
+	std::error_code error;
+	return fs::last_write_time(path, error);
+}
+
+Browser::~Browser(void) {
+	stopRenderer();
+}
+
+void Browser::update(float deltaTime) {
+	if (!active)
+		return;
+
+	if (!initialized) {
+		startRenderer();
+		scan();
+		initialized = true;
+	}
+
+	// Looking for new, removed and modified files from time to time
+	sinceCheck += deltaTime;
+	if (sinceCheck > 1.0f) {
+		sinceCheck = 0.0f;
+		scan();
+
+		for (auto& entry : entries) {
+			State state = entry->state;
+			if (state != State::READY && state != State::FAILED)
+				continue;
+
+			if (entry->source.wasUpdated() || entry->modTime != modificationTime(entry->path))
+				submit(entry.get());
+		}
+	}
+
+	// Missing previews go to preview thread; finished and cached ones are cheap to upload
+	bool queued = false;
+	for (auto& entry : entries) {
+		State state = entry->state;
+
+		if (state == State::DECODED) {
+			entry->image = RenderTarget(THUMB_WIDTH, THUMB_HEIGHT);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTextureSubImage2D(entry->image.getID(), 0, 0, 0, THUMB_WIDTH, THUMB_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, entry->pixels.data());
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+			entry->pixels.clear();
+			entry->pixels.shrink_to_fit();
+			entry->state = State::READY;
+		}
+		else if (state == State::RENDER) {
+			if (window == nullptr) {
+				entry->errors = "No OpenGL context for previews";
+				entry->state = State::FAILED;
+				continue;
+			}
+
+			entry->state = State::RENDERING;
+			std::lock_guard<std::mutex> lock(mtx);
+			queue.push_back(entry.get());
+			queued = true;
+		}
+	}
+
+	if (queued)
+		cv.notify_one();
+}
+
+bool Browser::isBusy(void) const {
+	if (!active)
+		return false;
+
+	for (auto& entry : entries) {
+		State state = entry->state;
+		if (state != State::READY && state != State::FAILED)
+			return true;
+	}
+	return false;
+}
+
+void Browser::showBrowser(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Browser", &active);
+	ImGui::SetWindowSize({ 700.0f, 500.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	ImGui::Text("Folder:");
+	ImGui::SameLine(0.12f * width);
+	ImGui::SetNextItemWidth(0.7f * width);
+	if (ImGui::InputText("##root", root, sizeof(root), ImGuiInputTextFlags_EnterReturnsTrue))
+		scan();
+
+	ImGui::SameLine();
+	if (ImGui::Button("Rescan"))
+		scan();
+
+	ImGui::Separator();
+	ImGui::BeginChild("##thumbnails");
+
+	const float cell = float(THUMB_WIDTH) + 10.0f;
+	const int32_t numColumns = std::max(1, int32_t(ImGui::GetContentRegionAvail().x / cell));
+	const ImVec2 size = { float(THUMB_WIDTH), float(THUMB_HEIGHT) };
+
+	for (size_t k = 0; k < entries.size(); k++) {
+		Entry& entry = *entries[k];
+		State state = entry.state;
+
+		if (k % numColumns != 0)
+			ImGui::SameLine();
+
+		ImGui::PushID(int32_t(k));
+		ImGui::BeginGroup();
+
+		if (state == State::READY) {
+			ImGui::Image((void*)(uintptr_t)entry.image.getID(), size, { 0.0f, 1.0f }, { 1.0f, 0.0f });
+			if (ImGui::IsItemClicked())
+				clicked = entry.path;
+		}
+		else if (ImGui::Button(state == State::FAILED ? "Failed" : "Rendering...", size)) {
+			clicked = entry.path;
+		}
+
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			ImGui::Text("%s", entry.path.string().c_str());
+			if (state == State::FAILED)
+				ImGui::TextColored({ 1.0f, 0.4f, 0.4f, 1.0f }, "%s", entry.errors.c_str());
+			ImGui::EndTooltip();
+		}
+
+		ImGui::Text("%s", entry.path.filename().string().c_str());
+		ImGui::EndGroup();
+		ImGui::PopID();
+	}
+
+	ImGui::EndChild();
+	ImGui::End();
+}
+
+fs::path Browser::selected(void) {
+	fs::path value = clicked;
+	clicked.clear();
+	return value;
+}
+
+void Browser::setRoot(const fs::path& folder) {
+	std::strncpy(root, folder.string().c_str(), sizeof(root) - 1);
+	if (initialized)
+		scan();
+}
+
+void Browser::open(void) {
+	active = true;
+}
+
+void Browser::close(void) {
+	active = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Browser::scan(void) {
+	std::vector<fs::path> found;
+
+	std::error_code error;
+	for (auto it = fs::recursive_directory_iterator(root, error); it != fs::recursive_directory_iterator(); it.increment(error)) {
+		if (error)
+			break;
+
+		const fs::path& path = it->path();
+		if (it->is_regular_file() && (path.extension() == ".glsl" || path.extension() == ".json"))
+			found.push_back(path);
+	}
+	std::sort(found.begin(), found.end());
+
+	// Nothing to do if every file is already known
+	bool same = found.size() == entries.size();
+	for (size_t k = 0; same && k < found.size(); k++)
+		same = found[k] == entries[k]->path;
+
+	if (same)
+		return;
+
+	// Workers hold pointers to entries, so they must be done before rebuilding the list
+	pool.wait();
+	waitRenderer();
+
+	std::vector<std::unique_ptr<Entry>> previous = std::move(entries);
+	entries.clear();
+
+	for (const fs::path& path : found) {
+		auto it = std::find_if(previous.begin(), previous.end(), [&](const std::unique_ptr<Entry>& ptr) { return ptr && ptr->path == path; });
+		if (it != previous.end()) {
+			entries.push_back(std::move(*it));
+			continue;
+		}
+
+		entries.push_back(std::make_unique<Entry>());
+		Entry* entry = entries.back().get();
+		entry->path = path;
+		entry->isConfig = path.extension() == ".json";
+		entry->source.setSilent(true);
+		submit(entry);
+	}
+}
+
+void Browser::submit(Entry* entry) {
+	entry->state = State::HASHING;
+	entry->modTime = modificationTime(entry->path);
+
+	fs::path folder = cacheDir;
+	pool.submit([entry, folder](void) {
+		// Files may change or vanish while being read, which must never take the application down
+		try {
+			process(entry, folder);
+		}
+		catch (const std::exception& error) {
+			entry->errors = error.what();
+			entry->state = State::FAILED;
+		}
+	});
+}
+
+void Browser::process(Entry* entry, const fs::path& cacheDir) {
+	GSHADER_PROFILE_SCOPE("Hash preview");
+	entry->errors.clear();
+	entry->shaderpath = entry->path;
+
+	// Configuration contents are part of the key, as they change the image as well
+	std::string config;
+	if (entry->isConfig) {
+		config = readFile(entry->path);
+		nlohmann::json data = nlohmann::json::parse(config, nullptr, false);
+		auto relative = data.is_object() ? data.find("relativePath") : data.end();
+		if (data.is_discarded() || !data.is_object() || relative == data.end() || !relative->is_string()) {
+			entry->errors = "Not a GShader configuration file";
+			entry->state = State::FAILED;
+			return;
+		}
+		entry->shaderpath = entry->path.parent_path() / relative->get<std::string>();
+	}
+
+	if (!entry->source.expand(entry->shaderpath)) {
+		entry->errors = entry->source.getErrors();
+		entry->state = State::FAILED;
+		return;
+	}
+
+	uint64_t key = fnv1a(entry->source.getSource());
+	key = fnv1a(config, key);
+	key = fnv1a(std::to_string(THUMB_WIDTH) + "x" + std::to_string(THUMB_HEIGHT), key);
+	entry->key = key;
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.ppm", static_cast<unsigned long long>(key));
+
+	Image image;
+	std::string error;
+	if (ImageReader::load(cacheDir / name, image, error) && image.width == THUMB_WIDTH && image.height == THUMB_HEIGHT && image.channels == 3) {
+		// Modification time tells when a preview was last used, for trimming the cache
+		std::error_code ignored;
+		fs::last_write_time(cacheDir / name, fs::file_time_type::clock::now(), ignored);
+
+		entry->pixels = std::move(image.pixels);
+		entry->state = State::DECODED;
+	}
+	else {
+		entry->state = State::RENDER;
+	}
+}
+
+void Browser::render(Entry& entry, DynamicShader& renderer, RenderTarget& target, uint32_t vao, const fs::path& cacheDir) {
+	GSHADER_PROFILE_SCOPE("Render preview");
+	Colors colors;
+	uniform::Uniform uniforms;
+	GRender::Camera camera;
+
+	if (entry.isConfig) {
+		ConfigFile config(entry.path);
+		config.load();
+		colors = config.get<Colors>();
+		uniforms = config.get<uniform::Uniform>();
+		camera = config.get<GRender::Camera>();
+	}
+
+	renderer.loadShader(entry.shaderpath);
+	if (renderer.hasFailed()) {
+		entry.errors = renderer.getErrors();
+		entry.state = State::FAILED;
+		return;
+	}
+
+	target.bind();
+
+	glm::vec2 zero = { 0.0f, 0.0f }, size = { float(THUMB_WIDTH), float(THUMB_HEIGHT) };
+
+	// Expression uniforms get their first frame, as when the file is opened
+	expr::scan(renderer, uniforms, colors, true);
+	expr::evaluate(uniforms, colors, { 0.0f, size.x / size.y, zero, &camera });
+
+	renderer.bind();
+	renderer.setFloat("iTime", 0.0f);
+	renderer.setFloat("iRatio", size.x / size.y);
+	renderer.setVec2f("iTileOffset", glm::value_ptr(zero));
+	renderer.setVec2f("iTileSize", glm::value_ptr(size));
+	renderer.setVec2f("iFullResolution", glm::value_ptr(size));
+	renderer.setVec3f("iCamPos", glm::value_ptr(camera.getPosition()));
+	renderer.setFloat("iCamYaw", camera.getYaw());
+	renderer.setFloat("iCamPitch", camera.getPitch());
+	renderer.setFloat("iFOV", camera.getFOV());
+	renderer.setVec2f("iMouse", glm::value_ptr(zero));
+
+	colors.submit(renderer);
+	uniforms.submit(renderer);
+
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindVertexArray(0);
+
+	// Waiting for the GPU here only holds back this thread
+	std::vector<uint8_t> rgb(3 * THUMB_WIDTH * THUMB_HEIGHT);
+	target.readRGB(0, 0, THUMB_WIDTH, THUMB_HEIGHT, rgb.data());
+	target.unbind();
+
+	// Failing to cache only means it is rendered again next time
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.ppm", static_cast<unsigned long long>(entry.key));
+
+	std::error_code error;
+	fs::create_directories(cacheDir, error);
+	ImageWriter::save(cacheDir / name, THUMB_WIDTH, THUMB_HEIGHT, rgb.data());
+
+	entry.pixels = std::move(rgb);
+	entry.state = State::DECODED;
+}
+
+void Browser::trim(const fs::path& cacheDir) {
+	struct Cached {
+		fs::path path;
+		fs::file_time_type time;
+		uintmax_t bytes;
+	};
+
+	std::error_code error;
+	std::vector<Cached> cached;
+	uintmax_t total = 0;
+	for (auto it = fs::directory_iterator(cacheDir, error); it != fs::directory_iterator(); it.increment(error)) {
+		if (error)
+			break;
+
+		if (it->path().extension() != ".ppm")
+			continue;
+
+		Cached file = { it->path(), it->last_write_time(error), it->file_size(error) };
+		if (!error) {
+			total += file.bytes;
+			cached.push_back(std::move(file));
+		}
+	}
+
+	if (total <= CACHE_LIMIT)
+		return;
+
+	// Least recently used first
+	std::sort(cached.begin(), cached.end(), [](const Cached& a, const Cached& b) { return a.time < b.time; });
+	for (const Cached& file : cached) {
+		if (total <= CACHE_LIMIT)
+			break;
+
+		if (fs::remove(file.path, error))
+			total -= file.bytes;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+bool Browser::startRenderer(void) {
+	// Windows can only be created from main thread; previews are drawn into a target of that
+	// thread's context and handed back as pixels
+	GLFWwindow* main = glfwGetCurrentContext();
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	window = glfwCreateWindow(1, 1, "GShader previews", nullptr, main);
+	glfwDefaultWindowHints();
+
+	if (window == nullptr) {
+		GRender::mailbox::CreateError("Cannot create a shared OpenGL context for previews");
+		return false;
+	}
+
+	stopping = false;
+	renderThread = std::thread(&Browser::run, this);
+	return true;
+}
+
+void Browser::stopRenderer(void) {
+	if (window == nullptr)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stopping = true;
+	}
+	cv.notify_all();
+	renderThread.join();
+
+	glfwDestroyWindow(window);
+	window = nullptr;
+}
+
+void Browser::waitRenderer(void) {
+	std::unique_lock<std::mutex> lock(mtx);
+	for (Entry* entry : queue)
+		entry->state = State::RENDER;
+	queue.clear();
+
+	cv.wait(lock, [this](void) { return current == nullptr; });
+}
+
+void Browser::run(void) {
+	glfwMakeContextCurrent(window);
+
+	{
+		// Vertex arrays and framebuffers aren't shared between contexts
+		uint32_t vao = 0;
+		glGenVertexArrays(1, &vao);
+
+		DynamicShader renderer;
+		renderer.initialize(vertexSource);
+		renderer.setSilent(true);
+		RenderTarget target(THUMB_WIDTH, THUMB_HEIGHT);
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				cv.wait(lock, [this](void) { return stopping || !queue.empty(); });
+				if (stopping)
+					break;
+
+				current = queue.front();
+				queue.pop_front();
+			}
+
+			try {
+				render(*current, renderer, target, vao, cacheDir);
+			}
+			catch (const std::exception& error) {
+				current->errors = error.what();
+				current->state = State::FAILED;
+			}
+
+			bool idle = false;
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				current = nullptr;
+				idle = queue.empty();
+			}
+			cv.notify_all();
+
+			if (idle)
+				trim(cacheDir);
+		}
+
+		glDeleteVertexArrays(1, &vao);
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,412 @@
+#include "channels.h"
+#include "threadPool.h"
+#include "profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+// Textures outlive the channels using them, up to this many bytes
+static constexpr size_t CACHE_LIMIT = size_t(512) << 20;
+
+namespace {
+
+// Finished textures by content hash, shared by every set of channels
+std::mutex cacheMutex;
+std::unordered_map<uint64_t, std::shared_ptr<Channels::Texture>> cache;
+size_t cacheBytes = 0;
+
+ThreadPool& decoders(void) {
+	static ThreadPool pool{ 2 };
+	return pool;
+}
+
+uint64_t fnv1a(const std::vector<uint8_t>& data) {
+	uint64_t hash = 14695981039346656037ull;
+	for (uint8_t ch : data) {
+		hash ^= ch;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+fs::file_time_type modificationTime(const fs::path& path) {
+	std::error_code error;
+	return fs::last_write_time(path, error);
+}
+
+// Drops textures nobody samples anymore, until cache fits again
+void evict(void) {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	for (auto it = cache.begin(); it != cache.end() && cacheBytes > CACHE_LIMIT;) {
+		if (it->second.use_count() == 1) {
+			glDeleteTextures(1, &it->second->id);
+			cacheBytes -= it->second->bytes;
+			it = cache.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+} // namespace
+
+Channels::Channel::~Channel(void) {
+	glDeleteSamplers(1, &sampler);
+	glDeleteTextures(1, &upload.id);
+}
+
+Channels::Channels(void) {
+	for (int32_t k = 0; k < NUM_CHANNELS; k++)
+		channels.push_back(std::make_unique<Channel>());
+}
+
+void Channels::clearCache(void) {
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	for (auto& [hash, texture] : cache) {
+		glDeleteTextures(1, &texture->id);
+		texture->id = 0; // channels still holding it sample nothing
+	}
+
+	cache.clear();
+	cacheBytes = 0;
+}
+
+void Channels::set(int32_t index, const Source& source) {
+	Channel& channel = *channels[index];
+	channel.source = source;
+	channel.error.clear();
+	channel.texture.reset();
+	updateSampler(channel);
+
+	glDeleteTextures(1, &channel.upload.id);
+	channel.upload = Texture();
+	channel.uploading.reset();
+
+	if (source.path.empty()) {
+		channel.job.reset();
+		return;
+	}
+
+	submit(channel);
+}
+
+void Channels::submit(Channel& channel) {
+	channel.modTime = modificationTime(channel.source.path);
+
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	channel.job = job;
+
+	// Images already on the GPU are only read and hashed, never decoded again
+	fs::path path = channel.source.path;
+	decoders().submit([job, path](void) {
+		std::vector<uint8_t> bytes = ImageReader::readFile(path);
+		job->hash = fnv1a(bytes);
+
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex);
+			job->cached = cache.find(job->hash) != cache.end();
+		}
+
+		if (bytes.empty())
+			job->error = "Cannot read '" + path.string() + "'";
+		else if (!job->cached)
+			ImageReader::decode(bytes, job->image, job->error);
+
+		job->done = true;
+	});
+}
+
+void Channels::updateSampler(Channel& channel) {
+	if (channel.sampler == 0)
+		glCreateSamplers(1, &channel.sampler);
+
+	version++;
+
+	// Samplers belong to channels, so one cached texture can be filtered differently by each
+	GLint minFilter = GL_LINEAR_MIPMAP_LINEAR, magFilter = GL_LINEAR;
+	if (channel.source.filter == Filter::LINEAR)
+		minFilter = GL_LINEAR;
+	else if (channel.source.filter == Filter::NEAREST)
+		minFilter = magFilter = GL_NEAREST;
+
+	GLint wrap = GL_REPEAT;
+	if (channel.source.wrap == Wrap::CLAMP)
+		wrap = GL_CLAMP_TO_EDGE;
+	else if (channel.source.wrap == Wrap::MIRROR)
+		wrap = GL_MIRRORED_REPEAT;
+
+	glSamplerParameteri(channel.sampler, GL_TEXTURE_MIN_FILTER, minFilter);
+	glSamplerParameteri(channel.sampler, GL_TEXTURE_MAG_FILTER, magFilter);
+	glSamplerParameteri(channel.sampler, GL_TEXTURE_WRAP_S, wrap);
+	glSamplerParameteri(channel.sampler, GL_TEXTURE_WRAP_T, wrap);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Channels::update(float deltaTime) {
+	GSHADER_PROFILE_FUNCTION();
+
+	sinceCheck += deltaTime;
+	if (sinceCheck > 0.5f) {
+		sinceCheck = 0.0f;
+		for (std::unique_ptr<Channel>& channel : channels) {
+			if (!channel->source.path.empty() && !channel->job && modificationTime(channel->source.path) != channel->modTime)
+				submit(*channel);
+		}
+	}
+
+	for (std::unique_ptr<Channel>& ptr : channels) {
+		Channel& channel = *ptr;
+		if (!channel.job || !channel.job->done)
+			continue;
+
+		std::shared_ptr<Job> job = std::move(channel.job);
+		if (!job->error.empty()) {
+			channel.error = job->error;
+			continue;
+		}
+
+		channel.error.clear();
+
+		if (job->cached) {
+			std::lock_guard<std::mutex> lock(cacheMutex);
+			auto it = cache.find(job->hash);
+			if (it != cache.end()) {
+				channel.texture = it->second;
+				version++;
+				continue;
+			}
+		}
+
+		// Evicted in the meantime, so it has to be decoded after all
+		if (job->cached) {
+			submit(channel);
+			continue;
+		}
+
+		const Image& image = job->image;
+		if (image.width == 0 || image.height == 0) {
+			channel.error = "Image is empty";
+			continue;
+		}
+
+		const GLenum internal = image.channels == 1 ? GL_R8 : (image.channels == 3 ? GL_RGB8 : GL_RGBA8);
+		const int32_t levels = 1 + int32_t(std::floor(std::log2(float(std::max(image.width, image.height)))));
+
+		glDeleteTextures(1, &channel.upload.id);
+		glCreateTextures(GL_TEXTURE_2D, 1, &channel.upload.id);
+		glTextureStorage2D(channel.upload.id, levels, internal, image.width, image.height);
+
+		// Gray images look gray instead of red
+		if (image.channels == 1) {
+			const GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+			glTextureParameteriv(channel.upload.id, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+		}
+
+		channel.upload.size = { image.width, image.height };
+		channel.upload.bytes = image.pixels.size() * 4 / 3; // with mipmaps
+		channel.uploading = std::move(job);
+		channel.nextRow = 0;
+	}
+
+	if (!isBusy())
+		return;
+
+	if (!ring)
+		ring = std::make_unique<StagingRing>();
+
+	// Bands of rows go through the staging ring until the frame budget is used
+	size_t budget = size_t(budgetMB) << 20;
+	for (std::unique_ptr<Channel>& ptr : channels) {
+		Channel& channel = *ptr;
+		if (!channel.uploading)
+			continue;
+
+		const Image& image = channel.uploading->image;
+		const size_t rowSize = size_t(image.width) * image.channels;
+		if (rowSize > ring->getSlotSize()) {
+			channel.error = "Image is too wide";
+			glDeleteTextures(1, &channel.upload.id);
+			channel.upload = Texture();
+			channel.uploading.reset();
+			continue;
+		}
+
+		const uint32_t bandRows = uint32_t(ring->getSlotSize() / rowSize);
+
+		while (channel.nextRow < image.height && budget > 0) {
+			uint8_t* slot = ring->acquire();
+			if (slot == nullptr)
+				return; // every slot still in flight, continue next frame
+
+			const uint32_t rows = std::min(bandRows, image.height - channel.nextRow);
+			const size_t bytes = rows * rowSize;
+			std::memcpy(slot, image.pixels.data() + channel.nextRow * rowSize, bytes);
+
+			const GLenum format = image.channels == 1 ? GL_RED : (image.channels == 3 ? GL_RGB : GL_RGBA);
+			ring->copyToTexture(channel.upload.id, 0, int32_t(channel.nextRow), image.width, rows, format);
+
+			channel.nextRow += rows;
+			budget -= std::min(budget, bytes);
+		}
+
+		if (channel.nextRow == image.height)
+			finish(channel);
+	}
+}
+
+void Channels::finish(Channel& channel) {
+	GSHADER_PROFILE_FUNCTION();
+	glGenerateTextureMipmap(channel.upload.id);
+
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>(channel.upload);
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		cache[channel.uploading->hash] = texture;
+		cacheBytes += texture->bytes;
+	}
+
+	channel.texture = texture;
+	channel.upload = Texture();
+	version++;
+	channel.uploading.reset();
+
+	evict();
+}
+
+bool Channels::isBusy(void) const {
+	for (const std::unique_ptr<Channel>& channel : channels) {
+		if (channel->job || channel->uploading)
+			return true;
+	}
+	return false;
+}
+
+bool Channels::isEmpty(void) const {
+	for (const std::unique_ptr<Channel>& channel : channels) {
+		if (!channel->source.path.empty())
+			return false;
+	}
+	return true;
+}
+
+void Channels::bind(const DynamicShader& program) const {
+	static const char* names[NUM_CHANNELS] = {
+		"iChannel0", "iChannel1", "iChannel2", "iChannel3",
+		"iChannel4", "iChannel5", "iChannel6", "iChannel7",
+	};
+
+	// Channels without an image keep their unit, with no texture bound
+	for (int32_t k = 0; k < NUM_CHANNELS; k++) {
+		const Channel& channel = *channels[k];
+		glBindTextureUnit(FIRST_UNIT + k, channel.texture ? channel.texture->id : 0);
+		glBindSampler(FIRST_UNIT + k, channel.sampler);
+		program.setInteger(names[k], FIRST_UNIT + k);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Channels::showChannels(void) {
+	if (!active)
+		return;
+
+	ImGui::Begin("Channels", &active);
+	ImGui::SetWindowSize({ 500.0f, 400.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	ImGui::SetNextItemWidth(0.4f * width);
+	ImGui::SliderInt("Upload budget (MB/frame)", &budgetMB, 1, 32);
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		ImGui::TextDisabled("Cache: %zu textures, %.1f MB", cache.size(), double(cacheBytes) / double(1 << 20));
+	}
+
+	ImGui::Separator();
+
+	for (int32_t k = 0; k < NUM_CHANNELS; k++) {
+		Channel& channel = *channels[k];
+		ImGui::PushID(k);
+
+		ImGui::Text("iChannel%d", k);
+		ImGui::SameLine(0.2f * width);
+		if (channel.source.path.empty())
+			ImGui::TextDisabled("(empty)");
+		else
+			ImGui::Text("%s", channel.source.path.filename().string().c_str());
+
+		ImGui::SameLine(0.65f * width);
+		if (ImGui::Button("Set...")) {
+			picking = k;
+			pickOn = true;
+		}
+
+		ImGui::SameLine();
+		if (ImGui::Button("Clear"))
+			set(k, Source());
+
+		if (!channel.source.path.empty()) {
+			int32_t filter = static_cast<int32_t>(channel.source.filter);
+			int32_t wrap = static_cast<int32_t>(channel.source.wrap);
+
+			ImGui::SetNextItemWidth(0.25f * width);
+			bool changed = ImGui::Combo("##filter", &filter, "Mipmap\0Linear\0Nearest\0");
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(0.25f * width);
+			changed |= ImGui::Combo("##wrap", &wrap, "Repeat\0Clamp\0Mirror\0");
+
+			if (changed) {
+				channel.source.filter = static_cast<Filter>(filter);
+				channel.source.wrap = static_cast<Wrap>(wrap);
+				updateSampler(channel);
+			}
+
+			ImGui::SameLine();
+			if (channel.job)
+				ImGui::TextDisabled("decoding");
+			else if (channel.uploading)
+				ImGui::TextDisabled("uploading %.0f%%", 100.0f * channel.nextRow / float(channel.upload.size.y));
+			else if (channel.texture)
+				ImGui::TextDisabled("%u x %u", channel.texture->size.x, channel.texture->size.y);
+		}
+
+		if (!channel.error.empty())
+			ImGui::TextColored({ 1.0f, 0.4f, 0.4f, 1.0f }, "%s", channel.error.c_str());
+
+		ImGui::PopID();
+	}
+
+	ImGui::End();
+}
+
+bool Channels::pickRequested(void) {
+	bool value = pickOn;
+	pickOn = false;
+	return value;
+}
+
+void Channels::setPicked(const fs::path& path) {
+	Source source = channels[picking]->source;
+	source.path = path;
+	set(picking, source);
+}
+
+void Channels::open(void) {
+	active = true;
+}
+
+void Channels::close(void) {
+	active = false;
+}
@@ -0,0 +1,273 @@
+#include "checker.h"
+#include "dynamicShader.h"
+
+#include "GLFW/glfw3.h"
+#include "json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+// Each worker owns a context, which costs memory on the driver side
+static constexpr uint32_t MAX_JOBS = 8;
+
+static bool isCandidate(const fs::path& path) {
+    return path.extension() == ".glsl" || path.extension() == ".json";
+}
+
+static std::regex globToRegex(const std::string& glob) {
+    // '**' crosses directories, '*' and '?' stay within a single name
+    std::string rgx;
+    for (size_t k = 0; k < glob.size(); k++) {
+        char ch = glob[k];
+        if (ch == '*' && k + 1 < glob.size() && glob[k + 1] == '*') {
+            rgx += ".*";
+            k++;
+        }
+        else if (ch == '*') {
+            rgx += "[^/]*";
+        }
+        else if (ch == '?') {
+            rgx += "[^/]";
+        }
+        else if (std::string("\\^$.|+()[]{}").find(ch) != std::string::npos) {
+            rgx += std::string("\\") + ch;
+        }
+        else {
+            rgx += ch;
+        }
+    }
+    return std::regex(rgx);
+}
+
+std::vector<fs::path> Checker::gather(const std::string& pattern, const fs::path& currDir) {
+    std::vector<fs::path> files;
+    fs::path path = fs::path(pattern).is_absolute() ? fs::path(pattern) : currDir / pattern;
+    path = path.lexically_normal();
+
+    if (fs::is_directory(path)) {
+        for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path)) {
+            if (entry.is_regular_file() && isCandidate(entry.path()))
+                files.push_back(entry.path());
+        }
+    }
+    else if (pattern.find_first_of("*?") != std::string::npos) {
+        // Only the part before first wildcard needs to be walked
+        std::string generic = path.generic_string();
+        size_t wild = generic.find_first_of("*?");
+        fs::path root = fs::path(generic.substr(0, generic.rfind('/', wild) + 1));
+
+        const std::regex rgx = globToRegex(generic);
+        if (fs::is_directory(root)) {
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(root)) {
+                if (entry.is_regular_file() && isCandidate(entry.path()) && std::regex_match(entry.path().generic_string(), rgx))
+                    files.push_back(entry.path());
+            }
+        }
+    }
+    else if (fs::exists(path)) {
+        files.push_back(path);
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<Checker::Error> Checker::parseErrors(const std::string& errors, const fs::path& shader) {
+    // Located lines look like "dir/file.hl => 12(5): message", relative to main shader
+    std::vector<Error> out;
+    const std::regex located("^(.+?) => ([0-9]+)(.*)$");
+
+    std::string line;
+    std::stringstream stream(errors);
+    while (std::getline(stream, line)) {
+        if (line.empty() || line == "Shader compilation error")
+            continue;
+
+        Error error;
+        std::smatch match;
+        if (line.rfind("Cannot link", 0) != 0 && std::regex_match(line, match, located)) {
+            error.file = (shader.parent_path() / match[1].str()).lexically_normal();
+            error.line = std::stoi(match[2].str());
+            error.message = match[3].str();
+        }
+        else {
+            error.message = line;
+        }
+        out.push_back(error);
+    }
+
+    return out;
+}
+
+Checker::Result Checker::check(const fs::path& file) {
+    Result result;
+    result.file = file;
+    result.shader = file;
+
+    // Configurations are checked through the shader they reference
+    if (file.extension() == ".json") {
+        json data;
+        try {
+            std::ifstream arq(file);
+            arq >> data;
+        }
+        catch (const std::exception& except) {
+            result.errors.push_back({ file, 0, except.what() });
+            return result;
+        }
+
+        if (!data.contains("relativePath") || !data["relativePath"].is_string()) {
+            result.errors.push_back({ file, 0, "Configuration doesn't reference a shader" });
+            return result;
+        }
+
+        result.shader = (file.parent_path() / data["relativePath"].get<std::string>()).lexically_normal();
+    }
+
+    if (!fs::exists(result.shader)) {
+        result.errors.push_back({ file, 0, "'" + result.shader.string() + "' doesn't exist" });
+        return result;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    DynamicShader shader;
+    shader.setSilent(true);
+    shader.initialize();
+    shader.loadShader(result.shader);
+
+    // Compiler works asynchronously on some drivers, so timing waits for it
+    glFinish();
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    result.success = !shader.hasFailed();
+    result.errors = parseErrors(shader.getErrors(), result.shader);
+    return result;
+}
+
+void Checker::write(std::ostream& out, const Result& result) {
+    json line;
+    line["file"] = result.file.generic_string();
+    line["shader"] = result.shader.generic_string();
+    line["success"] = result.success;
+    line["ms"] = result.ms;
+    line["errors"] = json::array();
+
+    for (const Error& error : result.errors) {
+        json var;
+        var["file"] = error.file.generic_string();
+        var["line"] = error.line;
+        var["message"] = error.message;
+        line["errors"].push_back(var);
+    }
+
+    out << line.dump() << std::endl;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+int32_t Checker::run(const std::vector<std::string>& args, const fs::path& currDir) {
+    uint32_t numJobs = std::min(std::max(std::thread::hardware_concurrency(), 1u), MAX_JOBS);
+    std::vector<fs::path> files;
+
+    for (size_t k = 0; k < args.size(); k++) {
+        if (args[k] == "--jobs" && k + 1 < args.size()) {
+            numJobs = uint32_t(std::clamp(std::atoi(args[++k].c_str()), 1, int32_t(MAX_JOBS)));
+            continue;
+        }
+
+        for (fs::path& path : gather(args[k], currDir))
+            files.push_back(std::move(path));
+    }
+
+    if (files.empty()) {
+        std::cerr << "No .glsl or .json files to check" << std::endl;
+        return 2;
+    }
+
+    // Windows must be created on main thread, their contexts are then handed to workers
+    if (!glfwInit()) {
+        std::cerr << "Cannot initialize GLFW" << std::endl;
+        return 2;
+    }
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    numJobs = std::min(numJobs, uint32_t(files.size()));
+    std::vector<GLFWwindow*> windows;
+    for (uint32_t k = 0; k < numJobs; k++) {
+        GLFWwindow* window = glfwCreateWindow(64, 64, "GShader check", nullptr, nullptr);
+        if (window == nullptr)
+            break;
+        windows.push_back(window);
+    }
+
+    if (windows.empty()) {
+        std::cerr << "Cannot create an OpenGL 4.5 context" << std::endl;
+        glfwTerminate();
+        return 2;
+    }
+
+    // Every context comes from the same driver, so entry points are loaded once
+    glfwMakeContextCurrent(windows.front());
+    gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    glfwMakeContextCurrent(nullptr);
+
+    std::mutex mtx;
+    std::atomic<size_t> next = { 0 };
+    std::atomic<uint32_t> failed = { 0 };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (GLFWwindow* window : windows) {
+        workers.emplace_back([&, window](void) {
+            glfwMakeContextCurrent(window);
+            for (size_t k = next++; k < files.size(); k = next++) {
+                Result result = check(files[k]);
+                if (!result.success)
+                    failed++;
+
+                // Lines are printed as files finish, so long runs show progress
+                std::lock_guard<std::mutex> lock(mtx);
+                write(std::cout, result);
+            }
+            glfwMakeContextCurrent(nullptr);
+        });
+    }
+
+    for (std::thread& worker : workers)
+        worker.join();
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    json summary;
+    summary["checked"] = files.size();
+    summary["failed"] = failed.load();
+    summary["jobs"] = windows.size();
+    summary["ms"] = ms;
+    std::cout << json{ { "summary", summary } }.dump() << std::endl;
+
+    for (GLFWwindow* window : windows)
+        glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return failed > 0 ? 1 : 0;
+}
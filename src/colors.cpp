@@ -1,13 +1,24 @@
 #include "colors.h"
+#include "profiler.h"
 
 #include "imgui.h"
 #include "GRender/mailbox.h"
 
+#include <algorithm>
+
 
 void Colors::append(const std::string& name, const glm::vec3& color) {
 	mColors.emplace("##" + name, color);
 }
 
+void Colors::set(const std::string& tag, const glm::vec3& color) {
+	mColors[tag] = color;
+}
+
+void Colors::remove(const std::string& tag) {
+	mColors.erase(tag);
+}
+
 void Colors::addColor() {
 	ImGui::Begin("New color", &addOn);
 	ImGui::SetWindowSize({ 500.0f, 140.0f });
@@ -72,6 +83,10 @@ void Colors::showColors() {
 		char local[128] = { 0 };
 		std::copy(name.begin()+2, name.end(), local);
 
+		auto issue = issues.find(name);
+		if (issue != issues.end())
+			ImGui::PushStyleColor(ImGuiCol_Text, issue->second.mismatch ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) : ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
+
 		ImGui::SetNextItemWidth(0.45f * size.x);
 		if (ImGui::InputText(name.c_str(), local, sizeof(local), ImGuiInputTextFlags_EnterReturnsTrue)) {
 			std::string tag(local);
@@ -80,6 +95,12 @@ void Colors::showColors() {
 				toRemove = name; // We remove the old color
 			}
 		}
+
+		if (issue != issues.end()) {
+			ImGui::PopStyleColor();
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("%s", issue->second.message.c_str());
+		}
 		ImGui::SameLine();
 		ImGui::SetNextItemWidth(0.45f * size.x);
 		ImGui::ColorEdit3(name.c_str(), &color[0], ImGuiColorEditFlags_Float);
@@ -100,6 +121,22 @@ void Colors::showColors() {
 		addOn = true;
 	}
 
+	if (!missing.empty()) {
+		ImGui::SameLine();
+		if (ImGui::Button(("Create missing (" + std::to_string(missing.size()) + ")").c_str())) {
+			for (const std::string& name : missing)
+				append(name, { 1.0f, 1.0f, 1.0f });
+			missing.clear();
+		}
+
+		if (ImGui::IsItemHovered()) {
+			std::string names;
+			for (const std::string& name : missing)
+				names += (names.empty() ? "" : "\n") + name;
+			ImGui::SetTooltip("vec3 uniforms nothing assigns:\n%s", names.c_str());
+		}
+	}
+
 	ImGui::SameLine();
 	if (ImGui::Button("Close")) {
 		active = false;
@@ -114,12 +151,34 @@ void Colors::showColors() {
 }
 
 void Colors::submit(const DynamicShader& shader) {
+	GSHADER_PROFILE_FUNCTION();
 	// submitting colors to shader
 	for (const auto& [name, cor] : mColors) {
 		shader.setVec3f(name.c_str() + 2, &cor[0]);
 	}
 }
 
+void Colors::reflect(const DynamicShader& shader) {
+	issues.clear();
+	missing.clear();
+	if (!active || shader.hasFailed())
+		return;
+
+	for (const auto& [name, cor] : mColors) {
+		const DynamicShader::Reflected* found = shader.findUniform(name.substr(2));
+		if (found == nullptr)
+			issues[name] = { false, "Not used by shader" };
+		else if (found->type != GL_FLOAT_VEC3 || found->size > 1)
+			issues[name] = { true, "Shader doesn't declare it as a single vec3" };
+	}
+
+	for (const auto& [name, found] : shader.getUniforms()) {
+		if (found.type == GL_FLOAT_VEC3 && found.size == 1 && !found.assigned)
+			missing.push_back(name);
+	}
+	std::sort(missing.begin(), missing.end());
+}
+
 void Colors::open() {
 	active = true;
 }
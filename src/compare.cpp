@@ -0,0 +1,496 @@
+#include "compare.h"
+
+#include "GRender/mailbox.h"
+
+#include "imgui.h"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <regex>
+#include <set>
+#include <sstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace fs = std::filesystem;
+
+// Runs git in 'folder' without a shell, so arguments are never interpreted, collecting its output
+static bool runGit(const fs::path& folder, const std::vector<std::string>& args, std::string& output) {
+	output.clear();
+
+#ifdef _WIN32
+	// Arguments are checked by callers, and Windows paths can't hold quotes
+	std::string command = "git -C \"" + folder.string() + "\"";
+	for (const std::string& arg : args)
+		command += " \"" + arg + "\"";
+
+	SECURITY_ATTRIBUTES security = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+	HANDLE readEnd = nullptr, writeEnd = nullptr;
+	if (!CreatePipe(&readEnd, &writeEnd, &security, 0))
+		return false;
+	SetHandleInformation(readEnd, HANDLE_FLAG_INHERIT, 0);
+
+	STARTUPINFOA startup = {};
+	startup.cb = sizeof(startup);
+	startup.dwFlags = STARTF_USESTDHANDLES;
+	startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+	startup.hStdOutput = writeEnd;
+	startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+	PROCESS_INFORMATION process = {};
+	BOOL created = CreateProcessA(nullptr, &command[0], nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &startup, &process);
+	CloseHandle(writeEnd);
+	if (!created) {
+		CloseHandle(readEnd);
+		return false;
+	}
+
+	char buffer[4096];
+	DWORD count = 0;
+	while (ReadFile(readEnd, buffer, sizeof(buffer), &count, nullptr) && count > 0)
+		output.append(buffer, count);
+	CloseHandle(readEnd);
+
+	DWORD status = 1;
+	WaitForSingleObject(process.hProcess, INFINITE);
+	GetExitCodeProcess(process.hProcess, &status);
+	CloseHandle(process.hProcess);
+	CloseHandle(process.hThread);
+	return status == 0;
+#else
+	std::vector<std::string> all = { "git", "-C", folder.string() };
+	all.insert(all.end(), args.begin(), args.end());
+
+	std::vector<char*> argv;
+	for (std::string& arg : all)
+		argv.push_back(&arg[0]);
+	argv.push_back(nullptr);
+
+	int fds[2];
+	if (::pipe(fds) != 0)
+		return false;
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addclose(&actions, fds[0]);
+	posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+	pid_t pid = 0;
+	int spawned = posix_spawnp(&pid, "git", &actions, nullptr, argv.data(), environ);
+	posix_spawn_file_actions_destroy(&actions);
+	::close(fds[1]);
+
+	if (spawned != 0) {
+		::close(fds[0]);
+		return false;
+	}
+
+	char buffer[4096];
+	ssize_t count;
+	while ((count = ::read(fds[0], buffer, sizeof(buffer))) > 0)
+		output.append(buffer, size_t(count));
+	::close(fds[0]);
+
+	int status = 0;
+	if (waitpid(pid, &status, 0) != pid)
+		return false;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+// Writes 'file', relative to repository root, as of 'revision' into 'temp' with the same layout,
+// followed by everything it includes. Includes git doesn't know at that revision come from disk
+static bool extract(const fs::path& root, const std::string& revision, const fs::path& file, const fs::path& temp, bool required, std::set<fs::path>& done) {
+	if (!done.insert(file).second)
+		return true;
+
+	std::string content;
+	if (!runGit(root, { "show", revision + ":" + file.generic_string() }, content)) {
+		if (required)
+			return false;
+
+		std::ifstream arq(root / file, std::ios::binary);
+		if (!arq)
+			return true; // shader loader reports it
+		std::stringstream ss;
+		ss << arq.rdbuf();
+		content = ss.str();
+	}
+
+	std::error_code error;
+	fs::create_directories((temp / file).parent_path(), error);
+	{
+		std::ofstream arq(temp / file, std::ios::binary);
+		arq << content;
+	}
+
+	// Same include syntax the shader loader reads
+	std::istringstream lines(content);
+	std::string line;
+	while (std::getline(lines, line)) {
+		size_t pos = line.find("#include");
+		if (pos == std::string::npos)
+			continue;
+
+		size_t qt1 = line.find('\"', pos), qt2 = qt1 == std::string::npos ? qt1 : line.find('\"', qt1 + 1);
+		if (qt2 == std::string::npos)
+			continue;
+
+		fs::path include = (file.parent_path() / line.substr(qt1 + 1, qt2 - qt1 - 1)).lexically_normal();
+		if (!include.empty() && *include.begin() != "..")
+			extract(root, revision, include, temp, false, done);
+	}
+
+	return true;
+}
+
+// Two-sided 95% quantile of Student's t distribution with 'dof' degrees of freedom
+static double studentQuantile(double dof) {
+	const double z = 1.959964;
+	if (dof <= 1.0)
+		return 12.706;
+
+	const double z3 = z * z * z, z5 = z3 * z * z;
+	return z + (z3 + z) / (4.0 * dof) + (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * dof * dof);
+}
+
+void Compare::setShader(const fs::path& path) {
+	if (running)
+		return;
+
+	for (Side& side : sides)
+		if (side.path[0] == '\0')
+			std::strncpy(side.path, path.string().c_str(), sizeof(side.path) - 1);
+}
+
+void Compare::showCompare(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("A/B compare", &active);
+	ImGui::SetWindowSize({ 500.0f, 420.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+	const char* names[] = { "A", "B" };
+
+	for (int32_t k = 0; k < 2; k++) {
+		Side& side = sides[k];
+		ImGui::PushID(k);
+		ImGui::Text("Shader %s:", names[k]);
+		ImGui::SameLine(0.25f * width);
+		ImGui::SetNextItemWidth(0.5f * width);
+		ImGui::InputText("##path", side.path, sizeof(side.path));
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(0.2f * width);
+		ImGui::InputText("##revision", side.revision, sizeof(side.revision));
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Git revision, empty for file on disk");
+		ImGui::PopID();
+	}
+
+	uint32_t minVal = 16, maxVal = 8192;
+	ImGui::Text("Resolution:");
+	ImGui::SameLine(0.25f * width);
+	ImGui::SetNextItemWidth(0.7f * width);
+	ImGui::DragScalarN("##resolution", ImGuiDataType_U32, glm::value_ptr(resolution), 2, 16.0f, &minVal, &maxVal);
+
+	ImGui::Text("Samples:");
+	ImGui::SameLine(0.25f * width);
+	ImGui::SetNextItemWidth(0.7f * width);
+	ImGui::SliderInt("##samples", &numSamples, 30, 5000);
+
+	if (running) {
+		size_t done = std::min(sides[0].samples.size(), sides[1].samples.size());
+		ImGui::ProgressBar(float(done) / float(numSamples), { 0.75f * width, 0.0f });
+		ImGui::SameLine();
+		if (ImGui::Button("Stop"))
+			stop();
+	}
+	else if (ImGui::Button("Start")) {
+		startOn = true;
+	}
+
+	///////////////////////////////////////////////////////
+	// Results
+
+	Stats stats[2] = { statistics(sides[0]), statistics(sides[1]) };
+
+	if (stats[0].samples > 1 && stats[1].samples > 1) {
+		ImGui::Separator();
+
+		if (ImGui::BeginTable("##timings", 3, ImGuiTableFlags_Borders)) {
+			ImGui::TableSetupColumn("");
+			ImGui::TableSetupColumn("A");
+			ImGui::TableSetupColumn("B");
+			ImGui::TableHeadersRow();
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("Mean (ms)");
+			ImGui::TableNextColumn(); ImGui::Text("%.4f", stats[0].mean);
+			ImGui::TableNextColumn(); ImGui::Text("%.4f", stats[1].mean);
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("Std. dev. (ms)");
+			ImGui::TableNextColumn(); ImGui::Text("%.4f", stats[0].stddev);
+			ImGui::TableNextColumn(); ImGui::Text("%.4f", stats[1].stddev);
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("Samples");
+			ImGui::TableNextColumn(); ImGui::Text("%zu", stats[0].samples);
+			ImGui::TableNextColumn(); ImGui::Text("%zu", stats[1].samples);
+
+			ImGui::EndTable();
+		}
+
+		// Welch's t-interval for difference of means, and its propagation to the ratio
+		const double va = stats[0].stddev * stats[0].stddev / stats[0].samples;
+		const double vb = stats[1].stddev * stats[1].stddev / stats[1].samples;
+		const double dof = (va + vb) * (va + vb) / (va * va / (stats[0].samples - 1) + vb * vb / (stats[1].samples - 1) + 1e-30);
+		const double t = studentQuantile(dof);
+
+		const double delta = stats[0].mean - stats[1].mean;
+		const double deltaErr = t * std::sqrt(va + vb);
+
+		const double speedup = stats[0].mean / stats[1].mean;
+		const double relA = va / (stats[0].mean * stats[0].mean), relB = vb / (stats[1].mean * stats[1].mean);
+		const double speedupErr = t * speedup * std::sqrt(relA + relB);
+
+		ImGui::Text("Speedup of B over A: %.3fx  [%.3f, %.3f]", speedup, speedup - speedupErr, speedup + speedupErr);
+		ImGui::Text("Time saved by B: %.4f ms +/- %.4f ms", delta, deltaErr);
+
+		if (std::abs(delta) <= deltaErr)
+			ImGui::TextColored({ 1.0f, 0.8f, 0.3f, 1.0f }, "Difference isn't significant at 95%% confidence");
+	}
+
+	if (hasDifference) {
+		ImGui::Separator();
+		ImGui::Text("Image difference:");
+		ImGui::Text("RMSE: %.3f   PSNR: %.2f dB   Max error: %u", diff.rmse, diff.psnr, diff.maxError);
+		ImGui::Text("Pixels changed: %.2f%%", 100.0 * diff.changed);
+	}
+
+	ImGui::End();
+}
+
+bool Compare::requested(void) {
+	bool value = startOn;
+	startOn = false;
+	return value;
+}
+
+bool Compare::start(float time) {
+	if (!initialized) {
+		for (Side& side : sides)
+			side.shader.initialize();
+
+		initialized = true;
+	}
+
+	for (Side& side : sides) {
+		if (!load(side))
+			return false;
+
+		if (side.target.getSize() != resolution)
+			side.target = RenderTarget(resolution.x, resolution.y);
+
+		side.timer.clear();
+		side.samples.clear();
+		side.discarded = 0;
+	}
+
+	this->time = time;
+	frame = 0;
+	hasDifference = false;
+	running = true;
+	return true;
+}
+
+void Compare::stop(void) {
+	running = false;
+	for (Side& side : sides)
+		side.timer.clear();
+}
+
+bool Compare::isRunning(void) const {
+	return running;
+}
+
+DynamicShader& Compare::begin(int32_t k) {
+	// Order is swapped every frame so neither side benefits from running second
+	current = (frame % 2 == 0) ? k : 1 - k;
+
+	Side& side = sides[current];
+	side.target.bind();
+	side.timer.begin();
+	return side.shader;
+}
+
+void Compare::end(void) {
+	Side& side = sides[current];
+	side.timer.end();
+	side.target.unbind();
+
+	// Both sides were drawn
+	if (current == ((frame % 2 == 0) ? 1 : 0)) {
+		if (frame == 0)
+			difference();
+
+		frame++;
+		collect();
+	}
+}
+
+void Compare::open(void) {
+	active = true;
+}
+
+void Compare::close(void) {
+	active = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+bool Compare::load(Side& side) {
+	const fs::path path = side.path;
+	if (!fs::exists(path)) {
+		GRender::mailbox::CreateError("'" + path.string() + "' doesn't exist!");
+		return false;
+	}
+
+	const std::string revision = side.revision;
+	if (revision.empty()) {
+		side.shader.loadShader(path);
+		return !side.shader.hasFailed();
+	}
+
+	// Revision goes to git as a single argument, but options and anything beyond plain
+	// revision syntax are refused anyway
+	static const std::regex rgxRevision(R"(^[A-Za-z0-9._/~^@{}-]+$)");
+	if (!std::regex_match(revision, rgxRevision) || revision[0] == '-') {
+		GRender::mailbox::CreateError("'" + revision + "' isn't a valid git revision");
+		return false;
+	}
+
+	const fs::path folder = fs::absolute(path).parent_path();
+	std::string root;
+	if (!runGit(folder, { "rev-parse", "--show-toplevel" }, root)) {
+		GRender::mailbox::CreateError("'" + folder.string() + "' isn't inside a git repository");
+		return false;
+	}
+
+	while (!root.empty() && (root.back() == '\n' || root.back() == '\r'))
+		root.pop_back();
+
+	std::error_code error;
+	const fs::path relative = fs::weakly_canonical(path, error).lexically_relative(fs::weakly_canonical(root, error));
+
+	std::string tag = revision;
+	for (char& ch : tag)
+		if (!std::isalnum(static_cast<unsigned char>(ch)))
+			ch = '_';
+
+	// Scene and its includes are extracted as of that revision with the repository layout,
+	// so relative includes resolve to files of the same revision
+	const fs::path temp = fs::temp_directory_path(error) / ("gshader-compare-" + tag);
+	fs::remove_all(temp, error);
+
+	std::set<fs::path> done;
+	if (relative.empty() || !extract(root, revision, relative, temp, true, done)) {
+		GRender::mailbox::CreateError("Couldn't read '" + path.filename().string() + "' at revision '" + revision + "'");
+		fs::remove_all(temp, error);
+		return false;
+	}
+
+	// Source is fully expanded while loading, so temporary files aren't needed afterwards
+	side.shader.loadShader(temp / relative);
+	fs::remove_all(temp, error);
+
+	return !side.shader.hasFailed();
+}
+
+Compare::Stats Compare::statistics(const Side& side) const {
+	Stats stats;
+	stats.samples = side.samples.size();
+	if (stats.samples == 0)
+		return stats;
+
+	for (double value : side.samples)
+		stats.mean += value;
+	stats.mean /= double(stats.samples);
+
+	if (stats.samples > 1) {
+		double sum = 0.0;
+		for (double value : side.samples)
+			sum += (value - stats.mean) * (value - stats.mean);
+		stats.stddev = std::sqrt(sum / double(stats.samples - 1));
+	}
+
+	return stats;
+}
+
+void Compare::collect(void) {
+	for (Side& side : sides) {
+		double ms;
+		while (side.timer.fetch(ms)) {
+			// First frames include shader warm-up and driver compilation
+			if (side.discarded < warmup)
+				side.discarded++;
+			else if (side.samples.size() < size_t(numSamples))
+				side.samples.push_back(ms);
+		}
+	}
+
+	if (sides[0].samples.size() >= size_t(numSamples) && sides[1].samples.size() >= size_t(numSamples)) {
+		stop();
+		GRender::mailbox::CreateInfo("A/B comparison finished!");
+	}
+}
+
+void Compare::difference(void) {
+	// Time is frozen, so first frame is representative of the whole comparison
+	const size_t numPixels = size_t(resolution.x) * resolution.y;
+	for (Side& side : sides) {
+		side.pixels.resize(3 * numPixels);
+		side.target.readRGB(0, 0, resolution.x, resolution.y, side.pixels.data());
+	}
+
+	const std::vector<uint8_t>& pa = sides[0].pixels;
+	const std::vector<uint8_t>& pb = sides[1].pixels;
+
+	double sum = 0.0;
+	size_t changed = 0;
+	diff = Difference();
+
+	for (size_t k = 0; k < numPixels; k++) {
+		bool differs = false;
+		for (size_t c = 0; c < 3; c++) {
+			int32_t error = std::abs(int32_t(pa[3 * k + c]) - int32_t(pb[3 * k + c]));
+			sum += double(error * error);
+			diff.maxError = std::max<uint32_t>(diff.maxError, error);
+			differs |= error > 0;
+		}
+		changed += differs ? 1 : 0;
+	}
+
+	diff.rmse = std::sqrt(sum / double(3 * numPixels));
+	diff.psnr = diff.rmse > 0.0 ? 20.0 * std::log10(255.0 / diff.rmse) : INFINITY;
+	diff.changed = double(changed) / double(numPixels);
+	hasDifference = true;
+}
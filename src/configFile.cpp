@@ -5,7 +5,12 @@
 
 #include "colors.h"
 #include "uniforms.h"
+#include "scheduler.h"
+#include "dataBuffers.h"
+#include "channels.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 namespace fs = std::filesystem;
@@ -138,6 +143,31 @@ void ConfigFile::insert(const uniform::Uniform& unif) {
     for (const auto& [tag, data] : unif) {
         json& var = vec[tag.substr(2)];
         var["type"] = static_cast<int32_t>(data->tp);
+        if (data->knob)
+            var["knob"] = true;
+
+        // Arrays and matrices are stored as flat lists of values, matrices column major
+        if (data->count > 1 || data->tp >= Type::MAT2) {
+            ParentData* ptr = const_cast<ParentData*>(data.get());
+            const int32_t num = numValues(ptr);
+
+            if (data->tp < Type::FLOAT) {
+                const int32_t* rg = reinterpret_cast<const int32_t*>(rangePointer(ptr));
+                const int32_t* val = reinterpret_cast<const int32_t*>(dataPointer(ptr));
+                var["range"] = { rg[0], rg[1] };
+                var["data"] = std::vector<int32_t>(val, val + num);
+            }
+            else {
+                const float* rg = reinterpret_cast<const float*>(rangePointer(ptr));
+                const float* val = reinterpret_cast<const float*>(dataPointer(ptr));
+                var["range"] = { rg[0], rg[1] };
+                var["data"] = std::vector<float>(val, val + num);
+            }
+
+            if (data->count > 1)
+                var["count"] = data->count;
+            continue;
+        }
 
         switch (data->tp) {
         case Type::INT: {
@@ -222,6 +252,29 @@ uniform::Uniform ConfigFile::get() {
         /////////////////////////////
         //Getting values
         json& val = var["data"];
+        const int32_t count = std::clamp(var.value("count", 1), 1, MAX_COUNT);
+
+        if (count > 1 || tp >= Type::MAT2) {
+            ParentData* ptr = create(tag, tp, count);
+            const size_t num = std::min(size_t(numValues(ptr)), val.size());
+
+            if (tp < Type::FLOAT) {
+                std::memcpy(rangePointer(ptr), &irg[0], sizeof(irg));
+                int32_t* values = reinterpret_cast<int32_t*>(dataPointer(ptr));
+                for (size_t k = 0; k < num; k++)
+                    values[k] = val[k].get<int32_t>();
+            }
+            else {
+                std::memcpy(rangePointer(ptr), &frg[0], sizeof(frg));
+                float* values = reinterpret_cast<float*>(dataPointer(ptr));
+                for (size_t k = 0; k < num; k++)
+                    values[k] = val[k].get<float>();
+            }
+
+            unif.append(tag, ptr);
+            continue;
+        }
+
         switch (tp) {
         case Type::INT: {
             glm::ivec1 ptr(val.get<int32_t>());
@@ -266,7 +319,136 @@ uniform::Uniform ConfigFile::get() {
             break;
         }
         } // switch
+
+        unif.find(tag)->knob = var.value("knob", false);
     }   
     
     return unif;
-}
\ No newline at end of file
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Scheduler policy
+
+template<>
+void ConfigFile::insert(const Scheduler::Policy& policy) {
+    json& aux = data["scheduler"];
+    aux["focusedFPS"] = policy.focusedFPS;
+    aux["unfocusedFPS"] = policy.unfocusedFPS;
+    aux["pausedFPS"] = policy.pausedFPS;
+    aux["renderMinimized"] = policy.renderMinimized;
+}
+
+template<>
+Scheduler::Policy ConfigFile::get() {
+    Scheduler::Policy policy;
+
+    json& aux = data["scheduler"];
+    if (aux.is_null()) {
+        return policy;
+    }
+
+    policy.focusedFPS = aux.value("focusedFPS", policy.focusedFPS);
+    policy.unfocusedFPS = aux.value("unfocusedFPS", policy.unfocusedFPS);
+    policy.pausedFPS = aux.value("pausedFPS", policy.pausedFPS);
+    policy.renderMinimized = aux.value("renderMinimized", policy.renderMinimized);
+
+    return policy;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Data buffers, with paths relative to configuration file
+
+template<>
+void ConfigFile::insert(const DataBuffers& buffers) {
+    json& vec = data["buffers"];
+    for (const DataBuffers::Source& source : buffers.getSources()) {
+        std::string relPath = fs::relative(source.path, configpath.parent_path()).string();
+        std::replace(relPath.begin(), relPath.end(), '\\', '/');
+
+        json& var = vec[source.name];
+        var["path"] = relPath;
+        var["type"] = source.kind == DataBuffers::Kind::TEXTURE ? "texture" : "storage";
+        var["binding"] = source.binding;
+        if (source.kind == DataBuffers::Kind::TEXTURE)
+            var["format"] = source.format;
+    }
+}
+
+template<>
+DataBuffers ConfigFile::get() {
+    DataBuffers buffers;
+
+    json& aux = data["buffers"];
+    if (aux.is_null()) {
+        return buffers;
+    }
+
+    for (const auto& [name, var] : aux.items()) {
+        DataBuffers::Source source;
+        source.name = name;
+        source.path = configpath.parent_path() / var["path"].get<std::string>();
+        source.kind = var.value("type", std::string("storage")) == "texture" ? DataBuffers::Kind::TEXTURE : DataBuffers::Kind::STORAGE;
+        source.binding = var.value("binding", 0);
+        source.format = var.value("format", source.format);
+        buffers.append(source);
+    }
+
+    return buffers;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Image channels, with paths relative to configuration file
+
+static const char* filterNames[] = { "mipmap", "linear", "nearest" };
+static const char* wrapNames[] = { "repeat", "clamp", "mirror" };
+
+template<>
+void ConfigFile::insert(const Channels& channels) {
+    json& vec = data["channels"];
+    for (int32_t k = 0; k < Channels::NUM_CHANNELS; k++) {
+        const Channels::Source& source = channels.get(k);
+        if (source.path.empty())
+            continue;
+
+        std::string relPath = fs::relative(source.path, configpath.parent_path()).string();
+        std::replace(relPath.begin(), relPath.end(), '\\', '/');
+
+        json& var = vec["iChannel" + std::to_string(k)];
+        var["path"] = relPath;
+        var["filter"] = filterNames[static_cast<int32_t>(source.filter)];
+        var["wrap"] = wrapNames[static_cast<int32_t>(source.wrap)];
+    }
+}
+
+template<>
+Channels ConfigFile::get() {
+    Channels channels;
+
+    json& aux = data["channels"];
+    if (aux.is_null()) {
+        return channels;
+    }
+
+    for (int32_t k = 0; k < Channels::NUM_CHANNELS; k++) {
+        std::string name = "iChannel" + std::to_string(k);
+        if (!aux.contains(name))
+            continue;
+
+        const json& var = aux[name];
+        Channels::Source source;
+        source.path = configpath.parent_path() / var["path"].get<std::string>();
+
+        std::string filter = var.value("filter", std::string("mipmap"));
+        std::string wrap = var.value("wrap", std::string("repeat"));
+        for (int32_t l = 0; l < 3; l++) {
+            if (filter == filterNames[l])
+                source.filter = static_cast<Channels::Filter>(l);
+            if (wrap == wrapNames[l])
+                source.wrap = static_cast<Channels::Wrap>(l);
+        }
+
+        channels.set(k, source);
+    }
+
+    return channels;
+}
@@ -0,0 +1,382 @@
+#include "dataBuffers.h"
+#include "mappedFile.h"
+#include "profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TexelFormat {
+	const char* name;
+	GLenum internal;
+	size_t bytes;
+};
+
+const TexelFormat formats[] = {
+	{ "r8", GL_R8, 1 },          { "rgba8", GL_RGBA8, 4 },
+	{ "r32f", GL_R32F, 4 },      { "rg32f", GL_RG32F, 8 },
+	{ "rgb32f", GL_RGB32F, 12 }, { "rgba32f", GL_RGBA32F, 16 },
+	{ "r32i", GL_R32I, 4 },      { "rgba32i", GL_RGBA32I, 16 },
+	{ "r32ui", GL_R32UI, 4 },    { "rgba32ui", GL_RGBA32UI, 16 },
+};
+
+const TexelFormat* findFormat(const std::string& name) {
+	for (const TexelFormat& format : formats) {
+		if (name == format.name)
+			return &format;
+	}
+	return nullptr;
+}
+
+fs::file_time_type modificationTime(const fs::path& path) {
+	std::error_code error;
+	return fs::last_write_time(path, error);
+}
+
+} // namespace
+
+DataBuffers::Entry::~Entry(void) {
+	glDeleteTextures(1, &textureID);
+	glDeleteBuffers(1, &bufferID);
+}
+
+void DataBuffers::append(const Source& source) {
+	entries.push_back(std::make_unique<Entry>());
+	entries.back()->source = source;
+
+	// Configurations written before bindings were reserved are moved out of the way
+	if (isReserved(source.binding))
+		entries.back()->source.binding = freeBinding();
+
+	load(*entries.back());
+}
+
+void DataBuffers::add(const fs::path& path) {
+	Source source;
+	source.name = path.stem().string();
+	source.path = path;
+	source.binding = freeBinding();
+	append(source);
+}
+
+int32_t DataBuffers::freeBinding(void) const {
+	// First binding not taken by another buffer nor reserved by tools
+	int32_t binding = 0;
+	auto taken = [&](int32_t value) -> bool {
+		for (const std::unique_ptr<Entry>& entry : entries) {
+			if (entry->source.binding == value)
+				return true;
+		}
+		return isReserved(value);
+	};
+	while (taken(binding))
+		binding++;
+	return binding;
+}
+
+std::vector<DataBuffers::Source> DataBuffers::getSources(void) const {
+	std::vector<Source> sources;
+	for (const std::unique_ptr<Entry>& entry : entries)
+		sources.push_back(entry->source);
+	return sources;
+}
+
+bool DataBuffers::isReserved(int32_t binding) {
+	return std::find(std::begin(RESERVED_BINDINGS), std::end(RESERVED_BINDINGS), binding) != std::end(RESERVED_BINDINGS);
+}
+
+uint64_t DataBuffers::hashBlock(const uint8_t* data, size_t size) {
+	// FNV-1a over 64 bit words, fast enough to rehash large files on every change
+	uint64_t hash = 14695981039346656037ull;
+	size_t k = 0;
+	for (; k + 8 <= size; k += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + k, 8);
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+	for (; k < size; k++)
+		hash = (hash ^ data[k]) * 1099511628211ull;
+
+	return hash;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void DataBuffers::load(Entry& entry) {
+	GSHADER_PROFILE_FUNCTION();
+	entry.error.clear();
+	entry.modTime = modificationTime(entry.source.path);
+
+	// Only mapped while this function runs, so a rewrite can't fault in the middle of an upload
+	MappedFile file(entry.source.path);
+	if (!file.isOpen()) {
+		entry.error = "Cannot map '" + entry.source.path.string() + "'";
+		entry.size = 0;
+		entry.pending.clear();
+		entry.pendingBytes = 0;
+		return;
+	}
+
+	const size_t size = file.getSize();
+	const size_t numBlocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	const bool sameSize = entry.bufferID != 0 && entry.size == size;
+	entry.size = size;
+
+	// Blocks can only be compared against a complete upload of a file of same size
+	if (!sameSize || entry.pendingBytes > 0) {
+		allocate(entry);
+		entry.hashes.assign(numBlocks, 0);
+		entry.pending.clear();
+		entry.pendingBytes = 0;
+		queue(entry, 0, size);
+		return;
+	}
+
+	const uint8_t* data = file.getData();
+	for (size_t k = 0; k < numBlocks; k++) {
+		size_t offset = k * BLOCK_SIZE;
+		size_t bytes = std::min(BLOCK_SIZE, size - offset);
+		if (hashBlock(data + offset, bytes) != entry.hashes[k])
+			queue(entry, offset, bytes);
+	}
+}
+
+void DataBuffers::allocate(Entry& entry) {
+	// Immutable storage, so a new buffer is created whenever the size changes
+	glDeleteBuffers(1, &entry.bufferID);
+	glCreateBuffers(1, &entry.bufferID);
+	glNamedBufferStorage(entry.bufferID, GLsizeiptr(entry.size), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	entry.capacity = entry.size;
+
+	createTexture(entry);
+}
+
+void DataBuffers::createTexture(Entry& entry) {
+	glDeleteTextures(1, &entry.textureID);
+	entry.textureID = 0;
+
+	if (entry.source.kind != Kind::TEXTURE || entry.bufferID == 0)
+		return;
+
+	const TexelFormat* format = findFormat(entry.source.format);
+	if (format == nullptr) {
+		entry.error = "Unknown texel format '" + entry.source.format + "'";
+		return;
+	}
+
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	if (entry.capacity / format->bytes > size_t(maxTexels)) {
+		entry.error = "Too large for a buffer texture, use a storage buffer";
+		return;
+	}
+
+	glCreateTextures(GL_TEXTURE_BUFFER, 1, &entry.textureID);
+	glTextureBuffer(entry.textureID, format->internal, entry.bufferID);
+}
+
+void DataBuffers::queue(Entry& entry, size_t offset, size_t size) {
+	// Adjacent blocks are merged into a single range
+	if (!entry.pending.empty()) {
+		auto& [lastOffset, lastSize] = entry.pending.back();
+		if (lastOffset + lastSize == offset) {
+			lastSize += size;
+			entry.pendingBytes += size;
+			return;
+		}
+	}
+
+	entry.pending.emplace_back(offset, size);
+	entry.pendingBytes += size;
+}
+
+void DataBuffers::update(float deltaTime) {
+	GSHADER_PROFILE_FUNCTION();
+
+	sinceCheck += deltaTime;
+	if (sinceCheck > 0.5f) {
+		sinceCheck = 0.0f;
+		for (std::unique_ptr<Entry>& entry : entries) {
+			if (modificationTime(entry->source.path) != entry->modTime)
+				load(*entry);
+		}
+	}
+
+	if (!isUploading())
+		return;
+
+	if (!ring)
+		ring = std::make_unique<StagingRing>();
+
+	// Chunks always cover whole blocks, so their hashes are known once uploaded
+	const size_t chunkSize = ring->getSlotSize() - ring->getSlotSize() % BLOCK_SIZE;
+	size_t budget = size_t(budgetMB) << 20;
+
+	for (std::unique_ptr<Entry>& entry : entries) {
+		if (entry->pending.empty() || budget == 0)
+			continue;
+
+		// Read as it goes up rather than mapped, so a file rewritten meanwhile can't fault
+		std::ifstream arq(entry->source.path, std::ios::binary);
+
+		while (!entry->pending.empty() && budget > 0) {
+			uint8_t* slot = ring->acquire();
+			if (slot == nullptr)
+				return; // every slot still in flight, continue next frame
+
+			auto& [offset, size] = entry->pending.front();
+			size_t bytes = std::min({ size, chunkSize, std::max(budget, BLOCK_SIZE) });
+
+			// A file shrunk meanwhile uploads zeros; its new time reloads it on next check
+			chunk.resize(bytes);
+			arq.seekg(std::streamoff(offset));
+			arq.read(reinterpret_cast<char*>(chunk.data()), std::streamsize(bytes));
+			const size_t got = arq ? bytes : size_t(std::max<std::streamsize>(arq.gcount(), 0));
+			std::fill(chunk.begin() + got, chunk.end(), uint8_t(0));
+			arq.clear();
+
+			std::memcpy(slot, chunk.data(), bytes);
+			ring->copyToBuffer(entry->bufferID, offset, bytes);
+
+			for (size_t k = 0; k < bytes; k += BLOCK_SIZE)
+				entry->hashes[(offset + k) / BLOCK_SIZE] = hashBlock(chunk.data() + k, std::min(BLOCK_SIZE, bytes - k));
+
+			offset += bytes;
+			size -= bytes;
+			entry->pendingBytes -= bytes;
+			budget -= std::min(budget, bytes);
+
+			if (size == 0)
+				entry->pending.erase(entry->pending.begin());
+		}
+	}
+}
+
+bool DataBuffers::isUploading(void) const {
+	for (const std::unique_ptr<Entry>& entry : entries) {
+		if (entry->pendingBytes > 0)
+			return true;
+	}
+	return false;
+}
+
+void DataBuffers::bind(void) const {
+	for (const std::unique_ptr<Entry>& entry : entries) {
+		if (entry->source.kind == Kind::STORAGE && entry->bufferID != 0)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, entry->source.binding, entry->bufferID);
+		else if (entry->source.kind == Kind::TEXTURE && entry->textureID != 0)
+			glBindTextureUnit(entry->source.binding, entry->textureID);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void DataBuffers::showBuffers(void) {
+	if (!active)
+		return;
+
+	ImGui::Begin("Data buffers", &active);
+	ImGui::SetWindowSize({ 500.0f, 350.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	ImGui::SetNextItemWidth(0.4f * width);
+	ImGui::SliderInt("Upload budget (MB/frame)", &budgetMB, 1, 32);
+
+	if (ImGui::Button("Add..."))
+		addOn = true;
+
+	ImGui::Separator();
+
+	Entry* toRemove = nullptr;
+	for (std::unique_ptr<Entry>& ptr : entries) {
+		Entry& entry = *ptr;
+		Source& source = entry.source;
+		ImGui::PushID(ptr.get());
+
+		ImGui::Text("%s", source.name.c_str());
+		ImGui::SameLine(0.3f * width);
+		ImGui::TextDisabled("%s, %.2f MB", source.path.filename().string().c_str(), double(entry.size) / double(1 << 20));
+
+		int32_t kind = static_cast<int32_t>(source.kind);
+		ImGui::SetNextItemWidth(0.25f * width);
+		if (ImGui::Combo("##kind", &kind, "Storage\0Texture\0")) {
+			source.kind = static_cast<Kind>(kind);
+			createTexture(entry);
+		}
+
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(0.2f * width);
+		int32_t binding = source.binding;
+		if (ImGui::InputInt("Binding", &binding)) {
+			// Reserved bindings are skipped in the direction of the change
+			const int32_t step = binding < source.binding ? -1 : 1;
+			while (isReserved(binding))
+				binding += step;
+			if (binding < 0) {
+				binding = 0;
+				while (isReserved(binding))
+					binding++;
+			}
+			source.binding = binding;
+		}
+
+		if (source.kind == Kind::TEXTURE) {
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(0.2f * width);
+			if (ImGui::BeginCombo("##format", source.format.c_str())) {
+				for (const TexelFormat& format : formats) {
+					if (ImGui::Selectable(format.name, source.format == format.name)) {
+						source.format = format.name;
+						entry.error.clear();
+						createTexture(entry);
+					}
+				}
+				ImGui::EndCombo();
+			}
+		}
+
+		ImGui::SameLine();
+		if (ImGui::Button("Remove"))
+			toRemove = ptr.get();
+
+		if (entry.pendingBytes > 0) {
+			float done = 1.0f - float(entry.pendingBytes) / float(std::max<size_t>(entry.size, 1));
+			ImGui::ProgressBar(done, { width, 0.0f });
+		}
+
+		if (!entry.error.empty())
+			ImGui::TextColored({ 1.0f, 0.4f, 0.4f, 1.0f }, "%s", entry.error.c_str());
+
+		ImGui::PopID();
+	}
+
+	if (toRemove) {
+		auto it = std::find_if(entries.begin(), entries.end(), [&](const std::unique_ptr<Entry>& entry) { return entry.get() == toRemove; });
+		entries.erase(it);
+	}
+
+	ImGui::End();
+}
+
+bool DataBuffers::addRequested(void) {
+	bool value = addOn;
+	addOn = false;
+	return value;
+}
+
+void DataBuffers::open(void) {
+	active = true;
+}
+
+void DataBuffers::close(void) {
+	active = false;
+}
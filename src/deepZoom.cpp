@@ -0,0 +1,347 @@
+#include "deepZoom.h"
+#include "profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Third order term may reach this fraction of first order one for pixels farthest away
+static const double SERIES_TOLERANCE = std::log2(1e-6);
+
+// Complex number with double mantissas and a shared binary exponent. Series coefficients at
+// deep zooms go far below what doubles can hold
+struct ComplexExp {
+	glm::dvec2 m = { 0.0, 0.0 };
+	int64_t e = 0;
+};
+
+static ComplexExp normalize(const glm::dvec2& m, int64_t e) {
+	double largest = std::max(std::abs(m.x), std::abs(m.y));
+	if (largest == 0.0)
+		return ComplexExp();
+
+	int32_t shift = 0;
+	std::frexp(largest, &shift);
+	return { { std::ldexp(m.x, -shift), std::ldexp(m.y, -shift) }, e + shift };
+}
+
+static glm::dvec2 cmul(const glm::dvec2& a, const glm::dvec2& b) {
+	return { a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x };
+}
+
+static ComplexExp mul(const ComplexExp& a, const ComplexExp& b) {
+	return normalize(cmul(a.m, b.m), a.e + b.e);
+}
+
+static ComplexExp mul(const ComplexExp& a, const glm::dvec2& b) {
+	return normalize(cmul(a.m, b), a.e);
+}
+
+static ComplexExp add(const ComplexExp& a, const ComplexExp& b) {
+	if (b.m.x == 0.0 && b.m.y == 0.0)
+		return a;
+	if (a.m.x == 0.0 && a.m.y == 0.0)
+		return b;
+
+	const ComplexExp& big = a.e >= b.e ? a : b;
+	const ComplexExp& small = a.e >= b.e ? b : a;
+	int32_t shift = int32_t(std::max<int64_t>(small.e - big.e, -1100));
+	return normalize(big.m + glm::dvec2(std::ldexp(small.m.x, shift), std::ldexp(small.m.y, shift)), big.e);
+}
+
+static double log2Abs(const ComplexExp& a) {
+	return std::log2(glm::length(a.m)) + double(a.e);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+DeepZoom::DeepZoom(void) : pool(std::clamp(std::thread::hardware_concurrency(), 1u, 8u)) {
+	setCenter("-0.5", "0.0");
+}
+
+DeepZoom::~DeepZoom(void) {
+	if (job)
+		job->cancel = true;
+
+	glDeleteTextures(1, &texture);
+}
+
+void DeepZoom::setCenter(const std::string& real, const std::string& imag) {
+	const uint32_t limbs = BigFloat::limbsFor(scale);
+	re = BigFloat::fromString(real, limbs);
+	im = BigFloat::fromString(imag, limbs);
+
+	std::snprintf(textRe, sizeof(textRe), "%s", real.c_str());
+	std::snprintf(textIm, sizeof(textIm), "%s", imag.c_str());
+	dirty = true;
+	seriesValid = false;
+}
+
+bool DeepZoom::update(const DynamicShader& shader) {
+	inUse = !shader.hasFailed() && shader.findUniform("iDeepOrbit") != nullptr;
+	if (!inUse)
+		return false;
+
+	bool changed = false;
+	if (job && job->done) {
+		upload(*job);
+		job.reset();
+		changed = true;
+	}
+
+	if (!job && dirty) {
+		submit();
+		dirty = false;
+	}
+
+	// Offset follows the view every frame, so panning works while next orbit is computed
+	if (length > 0)
+		offset = { float((re - refRe).toDouble() / scale), float((im - refIm).toDouble() / scale) };
+
+	return changed;
+}
+
+bool DeepZoom::navigate(const glm::vec2& cursor, const glm::vec2& size, bool hovered) {
+	if (!inUse || size.x <= 0.0f || size.y <= 0.0f)
+		return false;
+
+	ratio = size.x / size.y;
+	if (!hovered)
+		return false;
+
+	const ImGuiIO& io = ImGui::GetIO();
+	const uint32_t limbs = BigFloat::limbsFor(scale);
+	bool moved = false;
+
+	if (io.MouseWheel != 0.0f) {
+		// Point under cursor stays in place
+		const glm::dvec2 view = { (2.0 * cursor.x - 1.0) * ratio, 2.0 * cursor.y - 1.0 };
+		const double next = std::clamp(scale / std::pow(1.25, double(io.MouseWheel)), 1e-290, 4.0);
+		const glm::dvec2 shift = view * (scale - next);
+
+		scale = next;
+		const uint32_t deeper = BigFloat::limbsFor(scale);
+		re.setLimbs(deeper);
+		im.setLimbs(deeper);
+		re = re + BigFloat::fromDouble(shift.x, deeper);
+		im = im + BigFloat::fromDouble(shift.y, deeper);
+		moved = true;
+	}
+
+	if (ImGui::IsMouseDown(0) && (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f)) {
+		const double step = 2.0 * scale / double(size.y);
+		re = re - BigFloat::fromDouble(step * io.MouseDelta.x, limbs);
+		im = im + BigFloat::fromDouble(step * io.MouseDelta.y, limbs);
+		moved = true;
+	}
+
+	if (moved) {
+		// Enough digits to tell apart neighboring pixels
+		const uint32_t digits = std::min(uint32_t(std::max(-std::log10(scale), 0.0)) + 6, uint32_t(sizeof(textRe)) - 8);
+		std::snprintf(textRe, sizeof(textRe), "%s", re.toString(digits).c_str());
+		std::snprintf(textIm, sizeof(textIm), "%s", im.toString(digits).c_str());
+		dirty = true;
+		seriesValid = false;
+	}
+
+	return moved;
+}
+
+void DeepZoom::bind(const DynamicShader& program) const {
+	// Shaders without an orbit still get the uniforms, with nothing bound to the unit
+	glBindTextureUnit(UNIT, inUse ? texture : 0);
+	program.setInteger("iDeepOrbit", UNIT);
+	program.setInteger("iDeepOrbitLength", length);
+	program.setInteger("iDeepMaxIter", maxIter);
+
+	int32_t exponent = 0;
+	float mantissa = float(std::frexp(scale, &exponent));
+	program.setFloat("iDeepScale", mantissa);
+	program.setInteger("iDeepScaleExp", exponent);
+	program.setVec2f("iDeepOffset", &offset.x);
+
+	// Coefficients only hold for the view they were computed for
+	program.setInteger("iDeepSkip", seriesValid ? series.skip : 0);
+	program.setVec2f("iDeepSeries", &series.coefs[0].x, 3);
+	program.setVec3i("iDeepSeriesExp", &series.exponents.x);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void DeepZoom::submit(void) {
+	job = std::make_shared<Job>();
+	job->re = re;
+	job->im = im;
+	job->scale = scale;
+	job->radius = std::sqrt(double(ratio * ratio) + 1.0);
+	job->maxIter = maxIter;
+
+	// Minibrots rarely sit at the exact center, so a ring of candidates halfway to the border
+	// is tried as well. The longest orbit serves the most pixels before they need rebasing
+	const int32_t num = int32_t(pool.size());
+	const uint32_t limbs = re.getLimbs();
+	job->candidates.resize(num);
+	for (int32_t k = 0; k < num; k++) {
+		glm::dvec2 shift = { 0.0, 0.0 };
+		if (k > 0) {
+			double angle = 6.283185307179586 * double(k - 1) / double(num - 1);
+			shift = 0.5 * scale * glm::dvec2(ratio * std::cos(angle), std::sin(angle));
+		}
+
+		job->candidates[k].re = re + BigFloat::fromDouble(shift.x, limbs);
+		job->candidates[k].im = im + BigFloat::fromDouble(shift.y, limbs);
+	}
+
+	job->remaining = num;
+	for (int32_t k = 0; k < num; k++) {
+		std::shared_ptr<Job> current = job;
+		pool.submit([current, k](void) {
+			iterate(*current, current->candidates[k]);
+			if (--current->remaining == 0)
+				finish(*current);
+		});
+	}
+}
+
+void DeepZoom::iterate(Job& job, Candidate& cand) {
+	GSHADER_PROFILE_FUNCTION();
+	const uint32_t limbs = cand.re.getLimbs();
+	BigFloat x(limbs), y(limbs);
+
+	cand.orbit.push_back({ 0.0, 0.0 });
+	for (int32_t k = 0; k < job.maxIter && !job.cancel; k++) {
+		BigFloat xx = x * x, yy = y * y, xy = x * y;
+		x = xx - yy + cand.re;
+		y = xy + xy + cand.im;
+
+		glm::dvec2 z = { x.toDouble(), y.toDouble() };
+		cand.orbit.push_back(z);
+		if (z.x * z.x + z.y * z.y > BAILOUT)
+			break;
+	}
+}
+
+void DeepZoom::finish(Job& job) {
+	GSHADER_PROFILE_FUNCTION();
+	for (int32_t k = 1; k < int32_t(job.candidates.size()); k++) {
+		if (job.candidates[k].orbit.size() > job.candidates[job.best].orbit.size())
+			job.best = k;
+	}
+
+	const Candidate& ref = job.candidates[job.best];
+	job.offset = { (job.re - ref.re).toDouble() / job.scale, (job.im - ref.im).toDouble() / job.scale };
+
+	// Pixel deltas are 'scale' times their view position, so coefficients absorb powers of scale.
+	// Terms are extended while the third order stays negligible for the farthest pixel
+	const double logRadius = std::log2(glm::length(job.offset) + job.radius);
+	const ComplexExp step = normalize({ job.scale, 0.0 }, 0);
+
+	ComplexExp a, b, c;
+	for (size_t n = 0; n + 1 < ref.orbit.size() && !job.cancel; n++) {
+		const glm::dvec2 twoZ = 2.0 * ref.orbit[n];
+		ComplexExp na = add(mul(a, twoZ), step);
+		ComplexExp nb = add(mul(b, twoZ), mul(a, a));
+		ComplexExp nc = add(mul(c, twoZ), mul(mul(a, b), glm::dvec2(2.0, 0.0)));
+
+		if (log2Abs(nc) + 2.0 * logRadius > log2Abs(na) + SERIES_TOLERANCE)
+			break;
+
+		a = na;
+		b = nb;
+		c = nc;
+		job.series.skip = int32_t(n + 1);
+	}
+
+	const ComplexExp* terms[3] = { &a, &b, &c };
+	for (int32_t k = 0; k < 3; k++) {
+		job.series.coefs[k] = glm::vec2(terms[k]->m);
+		job.series.exponents[k] = int32_t(std::clamp<int64_t>(terms[k]->e, -1000000, 1000000));
+	}
+
+	job.done = true;
+}
+
+void DeepZoom::upload(Job& job) {
+	const Candidate& ref = job.candidates[job.best];
+	refRe = ref.re;
+	refIm = ref.im;
+	length = int32_t(ref.orbit.size());
+	series = job.series;
+	seriesValid = !dirty; // view hasn't moved since orbit was started
+
+	const glm::ivec2 size = { ORBIT_WIDTH, (length + ORBIT_WIDTH - 1) / ORBIT_WIDTH };
+	std::vector<glm::vec2> texels(size_t(size.x) * size_t(size.y), glm::vec2(0.0f));
+	for (int32_t k = 0; k < length; k++)
+		texels[k] = glm::vec2(ref.orbit[k]);
+
+	if (texSize != size) {
+		glDeleteTextures(1, &texture);
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, 1, GL_RG32F, size.x, size.y);
+		glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		texSize = size;
+	}
+
+	glTextureSubImage2D(texture, 0, 0, 0, size.x, size.y, GL_RG, GL_FLOAT, texels.data());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void DeepZoom::showDeepZoom(void) {
+	if (!active)
+		return;
+
+	ImGui::Begin("Deep zoom", &active);
+
+	if (!inUse)
+		ImGui::TextDisabled("Current shader doesn't declare 'iDeepOrbit'");
+
+	// Coordinates are kept as text, doubles would lose every digit that matters
+	bool enter = ImGui::InputText("Real", textRe, sizeof(textRe), ImGuiInputTextFlags_EnterReturnsTrue);
+	enter |= ImGui::InputText("Imaginary", textIm, sizeof(textIm), ImGuiInputTextFlags_EnterReturnsTrue);
+	if (enter)
+		setCenter(textRe, textIm);
+
+	float logScale = float(std::log10(scale));
+	if (ImGui::SliderFloat("Scale (log10)", &logScale, -290.0f, 0.5f, "%.2f")) {
+		scale = std::pow(10.0, double(logScale));
+		re.setLimbs(BigFloat::limbsFor(scale));
+		im.setLimbs(BigFloat::limbsFor(scale));
+		dirty = true;
+		seriesValid = false;
+	}
+
+	if (ImGui::InputInt("Max iterations", &maxIter, 100, 1000)) {
+		maxIter = std::clamp(maxIter, 1, ORBIT_WIDTH * 16384 - 1);
+		dirty = true;
+		seriesValid = false;
+	}
+
+	if (ImGui::Button("Reset")) {
+		scale = 1.5;
+		setCenter("-0.5", "0.0");
+	}
+
+	ImGui::Separator();
+	ImGui::Text("Precision: %u bits", 32 * re.getLimbs());
+	ImGui::Text("Reference orbit: %d iterations", std::max(length - 1, 0));
+	ImGui::Text("Series approximation skips: %d", seriesValid ? series.skip : 0);
+	if (job)
+		ImGui::TextColored({ 1.0f, 0.8f, 0.3f, 1.0f }, "Computing reference orbit...");
+
+	ImGui::End();
+}
+
+void DeepZoom::open(void) {
+	active = true;
+}
+
+void DeepZoom::close(void) {
+	active = false;
+}
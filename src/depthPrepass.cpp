@@ -0,0 +1,39 @@
+#include "depthPrepass.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DepthPrepass::setBlockSize(int32_t value) {
+    blockSize = std::clamp(value, 2, 32);
+}
+
+glm::uvec2 DepthPrepass::beginCoarse(const glm::uvec2& res, float fov) {
+    glm::uvec2 low = (res + glm::uvec2(blockSize - 1)) / glm::uvec2(blockSize);
+    low = glm::max(low, glm::uvec2(1, 1));
+    if (target.getSize() != low)
+        target = RenderTarget(low.x, low.y, GL_R32F);
+
+    // Cone is as wide as a whole coarse pixel, so it covers every ray of its block
+    cone = 2.0f * std::tan(0.5f * fov) / float(low.y);
+
+    target.bind();
+    stage = Stage::WRITING;
+    return low;
+}
+
+void DepthPrepass::endCoarse(void) {
+    target.unbind();
+    stage = Stage::READING;
+}
+
+void DepthPrepass::finish(void) {
+    stage = Stage::OFF;
+}
+
+void DepthPrepass::bind(const DynamicShader& program) const {
+    // Target is only bound once coarse pass is done drawing to it
+    glBindTextureUnit(UNIT, stage == Stage::READING ? target.getID() : 0);
+    program.setInteger("iDepthPrepass", UNIT);
+    program.setInteger("iPrepass", static_cast<int32_t>(stage));
+    program.setFloat("iPrepassCone", cone);
+}
@@ -1,63 +1,133 @@
 #include "dynamicShader.h"
+#include "glsl.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
 
 namespace fs = std::filesystem;
 
+// Compiled module, deleted once no shader links it anymore
+struct DynamicShader::ModuleObject {
+    uint32_t id = 0;
+    ~ModuleObject(void) { glDeleteShader(id); }
+};
+
+// Module objects shared by all shaders, recompiled only when their source changes. Shaders
+// are loaded from interface and render threads, whose contexts share these objects
+struct Module {
+    size_t hash = 0;
+    std::weak_ptr<DynamicShader::ModuleObject> object;
+};
+static std::mutex moduleMutex;
+static std::unordered_map<std::string, Module> moduleCache;
+
 DynamicShader::~DynamicShader(void) {
     glDeleteShader(vtxID);
     glDeleteProgram(programID);
 }
 
 DynamicShader::DynamicShader(DynamicShader&& rhs) noexcept {
-    std::swap(programID, rhs.programID);
-    std::swap(vtxID, rhs.vtxID);
+    swap(rhs);
 }
 
-
 DynamicShader& DynamicShader::operator=(DynamicShader&& rhs) noexcept {
-    if (&rhs != this){
-        new(this) DynamicShader(std::move(rhs));
+    // Previous state goes with the temporary, deleting its GL objects right away
+    if (&rhs != this) {
+        DynamicShader moved(std::move(rhs));
+        swap(moved);
     }
     return *this;
 }
 
-void DynamicShader::initialize() {
+void DynamicShader::swap(DynamicShader& rhs) noexcept {
+    std::swap(success, rhs.success);
+    std::swap(silent, rhs.silent);
+    std::swap(errors, rhs.errors);
+    std::swap(programID, rhs.programID);
+    std::swap(vtxID, rhs.vtxID);
+    std::swap(uniforms, rhs.uniforms);
+    std::swap(useModules, rhs.useModules);
+    std::swap(usePruning, rhs.usePruning);
+    std::swap(modules, rhs.modules);
+
+    std::swap(numLines, rhs.numLines);
+    std::swap(program, rhs.program);
+    std::swap(origins, rhs.origins);
+    std::swap(moduleFiles, rhs.moduleFiles);
+    std::swap(location, rhs.location);
+    std::swap(pass, rhs.pass);
+    std::swap(fileMap, rhs.fileMap);
+}
+
+void DynamicShader::setPass(Pass pass) {
+    this->pass = std::move(pass);
+}
+
+void DynamicShader::initialize(const std::string& vertexSource) {
+    // Initializing again replaces vertex stage, which only takes effect on next load
+    glDeleteShader(vtxID);
+    vtxID = 0;
+
+    if (!vertexSource.empty()) {
+        vtxID = createShader(vertexSource, GL_VERTEX_SHADER);
+        return;
+    }
+
+    // fragCoord is remapped to the full image, so tiled rendering is transparent to shaders
     const std::string shader =
-        "#version 450 core                      \n"
-        "layout(location = 0) in vec3 vPos;     \n"
-        "layout(location = 2) in vec2 vTexCoord;\n"
-        "out vec2 fragCoord;                    \n"
-        "void main() {                          \n"
-        "    fragCoord = vTexCoord;             \n"
-        "    gl_Position = vec4(vPos, 1.0);     \n"
-        "}                                      \n";
+        "#version 450 core                                                  \n"
+        "layout(location = 0) in vec3 vPos;                                 \n"
+        "layout(location = 2) in vec2 vTexCoord;                            \n"
+        "uniform vec2 iTileOffset;                                          \n"
+        "uniform vec2 iTileSize;                                            \n"
+        "uniform vec2 iFullResolution;                                      \n"
+        "out vec2 fragCoord;                                                \n"
+        "void main() {                                                      \n"
+        "    fragCoord = vTexCoord;                                         \n"
+        "    if (iFullResolution.x > 0.0)                                   \n"
+        "        fragCoord = (iTileOffset + vTexCoord * iTileSize) / iFullResolution;\n"
+        "    gl_Position = vec4(vPos, 1.0);                                 \n"
+        "}                                                                  \n";
 
     vtxID = createShader(shader, GL_VERTEX_SHADER); // this shader is well tested and should be fine
 }
 
 void DynamicShader::loadShader(const fs::path& frgPath) {
+    GSHADER_PROFILE_FUNCTION();
     GRender::ASSERT(vtxID > 0, "DynamicShader was not initialized!");
     GRender::ASSERT(fs::exists(frgPath), "Shader not found! => " + frgPath.string());
 
     uint32_t frg = createShaderFromFile(frgPath, GL_FRAGMENT_SHADER);
     
     if (hasFailed()) {  // no point to continue
+        glDeleteShader(frg);
         return;
     }
 
-    // Create program
+    // Create program, replacing previous one
+    glDeleteProgram(programID);
     programID = glCreateProgram();
     glAttachShader(programID, vtxID);
     glAttachShader(programID, frg);
+    for (const auto& module : modules)
+        glAttachShader(programID, module->id);
 
     // Link shaders to program
-    glLinkProgram(programID);
+    {
+        GSHADER_PROFILE_SCOPE("Link");
+        glLinkProgram(programID);
+    }
 
     checkProgram(programID, GL_LINK_STATUS);
+    reflect();
 
     glDeleteShader(frg);
 }
 
-bool DynamicShader::hasFailed() {
+bool DynamicShader::hasFailed() const {
     return !success;
 }
 
@@ -69,7 +139,8 @@ void DynamicShader::bind() {
 bool DynamicShader::wasUpdated() {
     // if any file was touched since last check
     for (auto& [filepath, data] : fileMap) {
-        if (data.modTime != fs::last_write_time(filepath))
+        std::error_code error; // removed files count as modified
+        if (data.modTime != fs::last_write_time(filepath, error))
             return true;
     }
     return false;
@@ -78,51 +149,175 @@ bool DynamicShader::wasUpdated() {
 /////////////////////////////
 
 void DynamicShader::setInteger(const char* name, int val) const {
-    int32_t loc = glGetUniformLocation(programID, name);
+    int32_t loc = uniformLocation(name);
+    if (loc < 0)
+        return;
     glUniform1i(loc, val);
 }
 
-void DynamicShader::setVec2i(const char* name, const int32_t* v) const {
-    int32_t loc = glGetUniformLocation(programID, name);
-    glUniform2i(loc, v[0], v[1]);
+void DynamicShader::setInteger(const char* name, const int32_t* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform1iv(loc, count, v);
 }
 
-void DynamicShader::setVec3i(const char* name, const int32_t* v) const {
-    int32_t loc = glGetUniformLocation(programID, name);
-    glUniform3i(loc, v[0], v[1], v[2]);
+void DynamicShader::setVec2i(const char* name, const int32_t* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform2iv(loc, count, v);
+}
+
+void DynamicShader::setVec3i(const char* name, const int32_t* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform3iv(loc, count, v);
 }
 
-void DynamicShader::setVec4i(const char* name, const int32_t* v) const {
-    int32_t loc = glGetUniformLocation(programID, name);
-    glUniform4i(loc, v[0], v[1], v[2], v[3]);
+void DynamicShader::setVec4i(const char* name, const int32_t* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform4iv(loc, count, v);
 }
 
 /////////////////////////////
 
 void DynamicShader::setFloat(const char* name, float val) const {
-    int32_t loc = glGetUniformLocation(programID, name);
+    int32_t loc = uniformLocation(name);
+    if (loc < 0)
+        return;
     glUniform1f(loc, val);
 }
 
-void DynamicShader::setVec2f(const char* name, const float* v) const {
-    int32_t loc = glGetUniformLocation(programID, name);
-    glUniform2f(loc, v[0], v[1]);
+void DynamicShader::setFloat(const char* name, const float* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform1fv(loc, count, v);
 }
 
-void DynamicShader::setVec3f(const char* name, const float* v) const {
-    int32_t loc = glGetUniformLocation(programID, name);
-    glUniform3f(loc, v[0], v[1], v[2]);
+void DynamicShader::setVec2f(const char* name, const float* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform2fv(loc, count, v);
 }
 
-void DynamicShader::setVec4f(const char* name, const float* v) const {
-    int32_t loc = glGetUniformLocation(programID, name);
-    glUniform4f(loc, v[0], v[1], v[2], v[3]);
+void DynamicShader::setVec3f(const char* name, const float* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform3fv(loc, count, v);
+}
+
+void DynamicShader::setVec4f(const char* name, const float* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniform4fv(loc, count, v);
+}
+
+/////////////////////////////
+
+void DynamicShader::setMat2f(const char* name, const float* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniformMatrix2fv(loc, count, GL_FALSE, v);
+}
+
+void DynamicShader::setMat3f(const char* name, const float* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniformMatrix3fv(loc, count, GL_FALSE, v);
+}
+
+void DynamicShader::setMat4f(const char* name, const float* v, int32_t count) const {
+    int32_t loc = uniformLocation(name, count);
+    if (loc < 0)
+        return;
+    glUniformMatrix4fv(loc, count, GL_FALSE, v);
+}
+
+const DynamicShader::Reflected* DynamicShader::findUniform(const std::string& name) const {
+    auto it = uniforms.find(name);
+    return it == uniforms.end() ? nullptr : &it->second;
+}
+
+int32_t DynamicShader::uniformLocation(const char* name) const {
+    auto it = uniforms.find(name);
+    if (it != uniforms.end()) {
+        it->second.assigned = true;
+        return it->second.location;
+    }
+
+    // Single elements of arrays aren't in the table
+    if (std::strchr(name, '[') != nullptr)
+        return glGetUniformLocation(programID, name);
+
+    return -1;
+}
+
+int32_t DynamicShader::uniformLocation(const char* name, int32_t& count) const {
+    // Elements past the end of an array would make the whole call fail
+    const char* bracket = std::strchr(name, '[');
+    auto it = uniforms.find(bracket != nullptr ? std::string(name, bracket) : std::string(name));
+    if (it != uniforms.end()) {
+        int32_t first = bracket != nullptr ? std::atoi(bracket + 1) : 0;
+        count = std::min(count, it->second.size - first);
+    }
+
+    return count > 0 ? uniformLocation(name) : -1;
+}
+
+void DynamicShader::reflect(void) {
+    uniforms.clear();
+    if (hasFailed())
+        return;
+
+    int32_t count = 0;
+    glGetProgramInterfaceiv(programID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+    const GLenum props[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+    for (int32_t k = 0; k < count; k++) {
+        GLint values[5] = { 0 };
+        glGetProgramResourceiv(programID, GL_UNIFORM, k, 5, props, 5, nullptr, values);
+
+        // Members of uniform blocks are set through buffers, not locations
+        if (values[4] != -1 || values[2] < 0)
+            continue;
+
+        std::string name(values[0], '\0');
+        glGetProgramResourceName(programID, GL_UNIFORM, k, values[0], nullptr, name.data());
+        name.resize(std::strlen(name.c_str()));
+
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos)
+            name.resize(bracket);
+
+        uniforms[name] = { values[2], GLenum(values[1]), values[3] };
+    }
+}
+
+std::string DynamicShader::locate(int32_t num) const {
+    for (auto& [name, data] : fileMap) {
+        if (num >= data.range.first && num <= data.range.second) {
+            size_t size = location.string().size()+1;
+            return name.substr(size) + " => " + std::to_string(num - data.range.first);
+        }
+    }
+    return "";
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////
 
 bool DynamicShader::recurseFiles(const fs::path& shadername) {
+    GSHADER_PROFILE_FUNCTION();
     fs::path shaderpath = location / shadername;
 
     fs::path fLocation(location); // storing location, in case we need to move to another folder
@@ -130,7 +325,7 @@ bool DynamicShader::recurseFiles(const fs::path& shadername) {
 
     // the first file is always guaranteed to exist when using the dialog box
     if (!fs::exists(shaderpath)) {
-        GRender::mailbox::CreateError( "\"" + shadername.string() + "\" doesn't exist!");
+        report("\"" + shadername.string() + "\" doesn't exist!");
         return false;
     }
 
@@ -157,13 +352,14 @@ bool DynamicShader::recurseFiles(const fs::path& shadername) {
                 std::string error = shadername.string() + " => " + std::to_string(numLines - lineZero+2)
                                   + "(9) Header file not found: '" + line + "'";
 
-                GRender::mailbox::CreateError(error);
+                report(error);
                 return false;
             }
 
             // If the header was already included, no need to do another time
             if (fileMap.find((location / newPath).string()) != fileMap.end()) {
                 program += "\n";
+                origins.push_back(shaderpath.string());
                 // numLines++;
             } 
             // passing header to be recursed
@@ -177,7 +373,12 @@ bool DynamicShader::recurseFiles(const fs::path& shadername) {
         // normal program
         else {
             program += line + "\n";
+            origins.push_back(shaderpath.string());
             numLines++;
+
+            size_t first = line.find_first_not_of(" \t");
+            if (first < line.size() && line.compare(first, 14, "#pragma module") == 0)
+                moduleFiles.push_back(shaderpath.string());
         }
     }
     arq.close();
@@ -191,20 +392,112 @@ bool DynamicShader::recurseFiles(const fs::path& shadername) {
     return true;
 }
 
-uint32_t DynamicShader::createShaderFromFile(const fs::path& shaderPath, GLenum shaderType) {
+bool DynamicShader::expand(const fs::path& frgPath) {
     numLines = 0;
+    errors.clear();
     program.clear();
+    origins.clear();
+    moduleFiles.clear();
     fileMap.clear();
-    location = shaderPath.parent_path();
+    location = frgPath.parent_path();
 
-    success = recurseFiles(shaderPath.filename());
-    if (!success)
+    success = recurseFiles(frgPath.filename());
+    return success;
+}
+
+uint32_t DynamicShader::createShaderFromFile(const fs::path& shaderPath, GLenum shaderType) {
+    // Held until new modules are looked up, so unchanged ones stay in cache
+    std::vector<std::shared_ptr<const ModuleObject>> previous;
+    previous.swap(modules);
+
+    if (!expand(shaderPath))
         return 0;
 
-    return createShader(program, shaderType);
+    if (pass)
+        return createShader(pass(pruned(program)), shaderType);
+
+    if (useModules && !moduleFiles.empty())
+        return createModules(shaderType);
+
+    return createShader(pruned(program), shaderType);
+}
+
+std::string DynamicShader::pruned(const std::string& source) const {
+    if (!usePruning)
+        return source;
+
+    GSHADER_PROFILE_FUNCTION();
+    return glsl::prune(source);
+}
+
+std::string DynamicShader::keepBodies(const std::function<bool(const std::string&)>& keep) const {
+    std::string out = program;
+    const std::string clean = glsl::stripComments(program);
+
+    for (const glsl::Function& fn : glsl::findFunctions(clean)) {
+        size_t line = glsl::lineOf(clean, fn.begin);
+        if (line > origins.size() || !keep(origins[line - 1]))
+            glsl::blankBody(out, fn);
+    }
+
+    return out;
+}
+
+uint32_t DynamicShader::createModules(GLenum shaderType) {
+    GSHADER_PROFILE_FUNCTION();
+
+    for (const std::string& file : moduleFiles) {
+        // Each module is expanded on its own, so its errors are located correctly
+        DynamicShader module;
+        module.setSilent(true);
+        if (!module.expand(file)) {
+            success = false;
+            report(module.getErrors());
+            return 0;
+        }
+
+        // Only functions defined in the module itself are compiled into its object
+        const std::string source = module.keepBodies([&](const std::string& origin) { return origin == file; });
+        const size_t hash = std::hash<std::string>{}(source);
+
+        std::shared_ptr<ModuleObject> object;
+        {
+            std::lock_guard<std::mutex> lock(moduleMutex);
+            Module& cached = moduleCache[file];
+            if (cached.hash == hash)
+                object = cached.object.lock();
+        }
+
+        // Compiled without holding the lock; at worst both threads compile the same module once
+        if (!object) {
+            uint32_t id = module.createShader(source, shaderType);
+            if (module.hasFailed()) {
+                glDeleteShader(id);
+                success = false;
+                report(module.getErrors());
+                return 0;
+            }
+
+            object = std::make_shared<ModuleObject>();
+            object->id = id;
+
+            std::lock_guard<std::mutex> lock(moduleMutex);
+            moduleCache[file] = { hash, object };
+        }
+
+        modules.push_back(object);
+    }
+
+    // Main object only declares what modules define
+    const auto isModule = [this](const std::string& origin) {
+        return std::find(moduleFiles.begin(), moduleFiles.end(), origin) != moduleFiles.end();
+    };
+
+    return createShader(pruned(keepBodies([&](const std::string& origin) { return !isModule(origin); })), shaderType);
 }
 
 uint32_t DynamicShader::createShader(const std::string& shaderData, GLenum shaderType) {
+    GSHADER_PROFILE_SCOPE("Compile");
     // Creating shader from data
     uint32_t shader = glCreateShader(shaderType);
     GRender::ASSERT(shader != 0, "Failed to create shader!");
@@ -237,17 +530,12 @@ void DynamicShader::checkShader(uint32_t shader, uint32_t flag) {
             size_t pos = line.find_first_of('(');
             int32_t num = atoi(line.substr(2, pos - 2).c_str());
 
-            for (auto& [name, data] : fileMap) {
-                if (num >= data.range.first && num <= data.range.second) {
-                    size_t size = location.string().size()+1;
-                    errorMessage += name.substr(size) + " => " + std::to_string(num - data.range.first);
-                    errorMessage += line.substr(pos) + "\n";
-                    break;
-                }
-            }
+            std::string where = locate(num);
+            if (!where.empty())
+                errorMessage += where + line.substr(pos) + "\n";
         }
 
-        GRender::mailbox::CreateError(errorMessage);
+        report(errorMessage);
     } 
     else {
         success = true;
@@ -263,10 +551,16 @@ void DynamicShader::checkProgram(uint32_t id, uint32_t flag) {
         glGetProgramInfoLog(id, sizeof(error), NULL, error);
 
         success = false;
-        GRender::mailbox::CreateError("Cannot link shader program => " + std::string(error));
+        report("Cannot link shader program => " + std::string(error));
     } 
     else {
         success = true;
     }
 }
 
+void DynamicShader::report(const std::string& message) {
+    if (silent)
+        errors += message + "\n";
+    else
+        GRender::mailbox::CreateError(message);
+}
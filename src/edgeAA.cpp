@@ -0,0 +1,316 @@
+#include "edgeAA.h"
+#include "profiler.h"
+
+#include "GRender/mailbox.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <regex>
+#include <string>
+
+// Full screen quad without vertex buffers
+static const char* vertexSource =
+    "#version 450 core\n"
+    "void main() {\n"
+    "    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "    gl_Position = vec4(2.0 * corner - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+// Pixels differing from a neighbor in object, distance or brightness are kept, the rest discarded
+static const char* detectSource =
+    "#version 450 core\n"
+    "layout(location = 0) out vec4 mark;\n"
+    "layout(binding = 18) uniform sampler2D base;\n"
+    "layout(binding = 19) uniform sampler2D keys;\n"
+    "uniform int useKeys;\n"
+    "uniform float depthThreshold;\n"
+    "uniform float lumaThreshold;\n"
+    "float luma(ivec2 p) { return dot(texelFetch(base, p, 0).rgb, vec3(0.299, 0.587, 0.114)); }\n"
+    "bool differs(ivec2 p, ivec2 q) {\n"
+    "    q = clamp(q, ivec2(0), textureSize(base, 0) - 1);\n"
+    "    if (abs(luma(p) - luma(q)) > lumaThreshold)\n"
+    "        return true;\n"
+    "    if (useKeys == 0)\n"
+    "        return false;\n"
+    "    vec2 a = texelFetch(keys, p, 0).xy, b = texelFetch(keys, q, 0).xy;\n"
+    "    return a.y != b.y || abs(a.x - b.x) > depthThreshold * max(min(abs(a.x), abs(b.x)), 1e-3);\n"
+    "}\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    if (!(differs(p, p + ivec2(1, 0)) || differs(p, p - ivec2(1, 0)) || differs(p, p + ivec2(0, 1)) || differs(p, p - ivec2(0, 1))))\n"
+    "        discard;\n"
+    "    mark = vec4(0.0, 0.0, 0.0, 1.0);\n"
+    "}\n";
+
+// Marked pixels average first pass with extra samples, others keep first pass
+static const char* resolveSource =
+    "#version 450 core\n"
+    "layout(location = 0) out vec4 fragColor;\n"
+    "layout(binding = 18) uniform sampler2D base;\n"
+    "layout(binding = 19) uniform sampler2D accum;\n"
+    "uniform float numSamples;\n"
+    "uniform int showEdges;\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    vec4 color = texelFetch(base, p, 0);\n"
+    "    vec4 acc = texelFetch(accum, p, 0);\n"
+    "    if (acc.a > 0.0) {\n"
+    "        color.rgb = (color.rgb + acc.rgb) / (numSamples + 1.0);\n"
+    "        if (showEdges == 1)\n"
+    "            color.rgb = mix(color.rgb, vec3(1.0, 0.0, 0.0), 0.5);\n"
+    "    }\n"
+    "    fragColor = color;\n"
+    "}\n";
+
+static uint32_t compile(const char* source, GLenum type) {
+    uint32_t id = glCreateShader(type);
+    glShaderSource(id, 1, &source, nullptr);
+    glCompileShader(id);
+
+    int tag = 0;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &tag);
+    if (tag == GL_FALSE) {
+        char error[1024] = { 0 };
+        glGetShaderInfoLog(id, sizeof(error), NULL, error);
+        GRender::mailbox::CreateError("Edge anti-aliasing shader failed => " + std::string(error));
+    }
+    return id;
+}
+
+static uint32_t createProgram(const char* fragment) {
+    uint32_t vtx = compile(vertexSource, GL_VERTEX_SHADER);
+    uint32_t frg = compile(fragment, GL_FRAGMENT_SHADER);
+
+    uint32_t id = glCreateProgram();
+    glAttachShader(id, vtx);
+    glAttachShader(id, frg);
+    glLinkProgram(id);
+    glDeleteShader(vtx);
+    glDeleteShader(frg);
+
+    int tag = 0;
+    glGetProgramiv(id, GL_LINK_STATUS, &tag);
+    if (tag == GL_FALSE) {
+        char error[1024] = { 0 };
+        glGetProgramInfoLog(id, sizeof(error), NULL, error);
+        GRender::mailbox::CreateError("Cannot link edge anti-aliasing program => " + std::string(error));
+    }
+    return id;
+}
+
+static uint32_t createTexture(const glm::uvec2& size, GLenum format) {
+    uint32_t id = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &id);
+    glTextureStorage2D(id, 1, format, size.x, size.y);
+    glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return id;
+}
+
+EdgeAA::~EdgeAA(void) {
+    release();
+    glDeleteProgram(detectProgram);
+    glDeleteProgram(resolveProgram);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteQueries(1, &query);
+}
+
+void EdgeAA::setSamples(int32_t value) {
+    numSamples = std::clamp(value, 1, MAX_SAMPLES);
+}
+
+void EdgeAA::scan(const DynamicShader& program) {
+    // Only an assignment counts; header declares 'fragKey' for every shader
+    static const std::regex rgxKey(R"(\bfragKey\s*(\.\w+\s*)?=[^=])");
+    useKeys = std::regex_search(program.getSource(), rgxKey);
+}
+
+void EdgeAA::initialize(void) {
+    detectProgram = createProgram(detectSource);
+    resolveProgram = createProgram(resolveSource);
+    glCreateVertexArrays(1, &vao);
+    glCreateQueries(GL_SAMPLES_PASSED, 1, &query);
+}
+
+void EdgeAA::release(void) {
+    glDeleteFramebuffers(1, &baseFBO);
+    glDeleteFramebuffers(1, &accumFBO);
+    glDeleteTextures(1, &baseTex);
+    glDeleteTextures(1, &keyTex);
+    glDeleteTextures(1, &accumTex);
+    glDeleteRenderbuffers(1, &stencilRB);
+
+    baseFBO = accumFBO = baseTex = keyTex = accumTex = stencilRB = 0;
+    size = { 0, 0 };
+}
+
+void EdgeAA::beginBase(const glm::uvec2& res) {
+    GSHADER_PROFILE_FUNCTION();
+    if (vao == 0)
+        initialize();
+
+    if (size != res) {
+        release();
+        size = res;
+
+        baseTex = createTexture(size, GL_RGBA8);
+        keyTex = createTexture(size, GL_RG32F);
+        accumTex = createTexture(size, GL_RGBA16F);
+
+        glCreateRenderbuffers(1, &stencilRB);
+        glNamedRenderbufferStorage(stencilRB, GL_STENCIL_INDEX8, size.x, size.y);
+
+        // First pass keeps color and keys, extra samples add up where the stencil marks an edge
+        const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glCreateFramebuffers(1, &baseFBO);
+        glNamedFramebufferTexture(baseFBO, GL_COLOR_ATTACHMENT0, baseTex, 0);
+        glNamedFramebufferTexture(baseFBO, GL_COLOR_ATTACHMENT1, keyTex, 0);
+        glNamedFramebufferDrawBuffers(baseFBO, 2, buffers);
+
+        glCreateFramebuffers(1, &accumFBO);
+        glNamedFramebufferTexture(accumFBO, GL_COLOR_ATTACHMENT0, accumTex, 0);
+        glNamedFramebufferRenderbuffer(accumFBO, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencilRB);
+
+        GRender::ASSERT(glCheckNamedFramebufferStatus(baseFBO, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "EdgeAA base target is incomplete!");
+        GRender::ASSERT(glCheckNamedFramebufferStatus(accumFBO, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "EdgeAA sample target is incomplete!");
+    }
+
+    // Pixels a shader leaves without key read as their own object
+    const float noColor[] = { 0.0f, 0.0f, 0.0f, 0.0f }, noKey[] = { -1.0f, -1.0f, 0.0f, 0.0f };
+    glClearNamedFramebufferfv(baseFBO, GL_COLOR, 0, noColor);
+    glClearNamedFramebufferfv(baseFBO, GL_COLOR, 1, noKey);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, baseFBO);
+    glViewport(0, 0, size.x, size.y);
+}
+
+void EdgeAA::detect(void) {
+    GSHADER_PROFILE_FUNCTION();
+
+    // Coverage of an older frame is read once available, so this never waits on the GPU
+    if (queryPending) {
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 passed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &passed);
+            coverage = float(passed) / float(std::max(size.x * size.y, 1u));
+            queryPending = false;
+        }
+    }
+
+    const float zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLint noMark = 0;
+    glClearNamedFramebufferfv(accumFBO, GL_COLOR, 0, zero);
+    glClearNamedFramebufferiv(accumFBO, GL_STENCIL, 0, &noMark);
+    glBindFramebuffer(GL_FRAMEBUFFER, accumFBO);
+
+    // Application state is kept as it was, as samples need their own blending
+    blendWasOn = glIsEnabled(GL_BLEND);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+    glDisable(GL_BLEND);
+
+    glEnable(GL_STENCIL_TEST);
+    glStencilFunc(GL_ALWAYS, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+    glBindTextureUnit(UNIT, baseTex);
+    glBindTextureUnit(UNIT + 1, keyTex);
+
+    glUseProgram(detectProgram);
+    glUniform1i(glGetUniformLocation(detectProgram, "useKeys"), useKeys ? 1 : 0);
+    glUniform1f(glGetUniformLocation(detectProgram, "depthThreshold"), depthThreshold);
+    glUniform1f(glGetUniformLocation(detectProgram, "lumaThreshold"), lumaThreshold);
+
+    if (!queryPending)
+        glBeginQuery(GL_SAMPLES_PASSED, query);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+
+    if (!queryPending) {
+        glEndQuery(GL_SAMPLES_PASSED);
+        queryPending = true;
+    }
+
+    glBindTextureUnit(UNIT, 0);
+    glBindTextureUnit(UNIT + 1, 0);
+
+    // Unmarked pixels fail the stencil test before the scene's fragment shader runs
+    glStencilFunc(GL_EQUAL, 1, 0xFF);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glColorMaski(0, GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE); // alpha keeps the mark
+}
+
+glm::vec2 EdgeAA::beginSample(int32_t k) {
+    // R2 sequence spreads any number of samples evenly over the pixel
+    constexpr float g = 1.32471795724474602596f;
+    const float n = float(k + 1);
+    glm::vec2 jitter = glm::fract(glm::vec2(0.5f) + n * glm::vec2(1.0f / g, 1.0f / (g * g)));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, accumFBO);
+    return jitter - 0.5f;
+}
+
+void EdgeAA::endSamples(void) {
+    glColorMaski(0, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_STENCIL_TEST);
+
+    glBlendFuncSeparate(blendSrc, blendDst, blendSrcAlpha, blendDstAlpha);
+    if (!blendWasOn)
+        glDisable(GL_BLEND);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void EdgeAA::resolve(void) {
+    GSHADER_PROFILE_FUNCTION();
+    glBindTextureUnit(UNIT, baseTex);
+    glBindTextureUnit(UNIT + 1, accumTex);
+
+    glUseProgram(resolveProgram);
+    glUniform1f(glGetUniformLocation(resolveProgram, "numSamples"), float(numSamples));
+    glUniform1i(glGetUniformLocation(resolveProgram, "showEdges"), showEdges ? 1 : 0);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+
+    glBindTextureUnit(UNIT, 0);
+    glBindTextureUnit(UNIT + 1, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void EdgeAA::showMenu(void) {
+    if (!ImGui::BeginMenu("Edge anti-aliasing"))
+        return;
+
+    ImGui::Checkbox("Enabled", &enabled);
+
+    if (ImGui::SliderInt("Samples", &numSamples, 1, MAX_SAMPLES))
+        setSamples(numSamples);
+
+    ImGui::SliderFloat("Luma threshold", &lumaThreshold, 0.01f, 1.0f);
+    if (useKeys)
+        ImGui::SliderFloat("Depth threshold", &depthThreshold, 0.001f, 0.5f, "%.3f");
+    else
+        ImGui::TextDisabled("Shader doesn't write fragKey, only brightness is compared");
+
+    ImGui::Checkbox("Show edges", &showEdges);
+
+    if (enabled)
+        ImGui::Text("Supersampled: %.1f%% of pixels", 100.0f * coverage);
+
+    ImGui::EndMenu();
+}
@@ -0,0 +1,690 @@
+#include "expression.h"
+#include "profiler.h"
+
+#include "GRender/mailbox.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace expr {
+
+using uniform::Type;
+
+enum Function : int32_t {
+	SIN, COS, TAN, ASIN, ACOS, ATAN, SQRT, INVERSESQRT, ABS, SIGN, FLOOR, CEIL, FRACT,
+	EXP, EXP2, LOG, LOG2, RADIANS, DEGREES,
+	POW, MIN, MAX, MOD, STEP, CLAMP, MIX, SMOOTHSTEP,
+	LENGTH, DISTANCE, DOT, CROSS, NORMALIZE,
+	FLOAT, VEC2, VEC3, VEC4, MAT2, MAT3, MAT4,
+	NUM_FUNCTIONS
+};
+
+struct FunctionInfo {
+	const char* name;
+	int32_t minArgs, maxArgs;
+};
+
+// Same order as enum above
+static const FunctionInfo functions[NUM_FUNCTIONS] = {
+	{ "sin", 1, 1 }, { "cos", 1, 1 }, { "tan", 1, 1 }, { "asin", 1, 1 }, { "acos", 1, 1 }, { "atan", 1, 2 },
+	{ "sqrt", 1, 1 }, { "inversesqrt", 1, 1 }, { "abs", 1, 1 }, { "sign", 1, 1 }, { "floor", 1, 1 },
+	{ "ceil", 1, 1 }, { "fract", 1, 1 }, { "exp", 1, 1 }, { "exp2", 1, 1 }, { "log", 1, 1 }, { "log2", 1, 1 },
+	{ "radians", 1, 1 }, { "degrees", 1, 1 },
+	{ "pow", 2, 2 }, { "min", 2, 2 }, { "max", 2, 2 }, { "mod", 2, 2 }, { "step", 2, 2 },
+	{ "clamp", 3, 3 }, { "mix", 3, 3 }, { "smoothstep", 3, 3 },
+	{ "length", 1, 1 }, { "distance", 2, 2 }, { "dot", 2, 2 }, { "cross", 2, 2 }, { "normalize", 1, 1 },
+	{ "float", 1, 1 }, { "vec2", 1, 2 }, { "vec3", 1, 3 }, { "vec4", 1, 4 },
+	{ "mat2", 1, 4 }, { "mat3", 1, 9 }, { "mat4", 1, 16 },
+};
+
+static int32_t size(const Value& val) {
+	return val.tp == Type::NONE ? 0 : uniform::numComponents(val.tp);
+}
+
+static bool isMatrix(Type tp) {
+	return tp >= Type::MAT2 && tp <= Type::MAT4;
+}
+
+static int32_t dimension(Type tp) {
+	return static_cast<int32_t>(tp) - static_cast<int32_t>(Type::MAT2) + 2;
+}
+
+static Type vectorType(int32_t components) {
+	return static_cast<Type>(static_cast<int32_t>(Type::FLOAT) + components - 1);
+}
+
+static Value scalar(float x) {
+	Value out;
+	out.tp = Type::FLOAT;
+	out.v[0] = x;
+	return out;
+}
+
+// Component wise, with scalars spread over the other operand as glsl does
+template<typename F>
+static Value zip(const Value& a, const Value& b, F func) {
+	const int32_t na = size(a), nb = size(b);
+	if (na == 0 || nb == 0 || (a.tp != b.tp && na != 1 && nb != 1))
+		return Value();
+
+	Value out;
+	out.tp = na == 1 ? b.tp : a.tp;
+	for (int32_t k = 0; k < std::max(na, nb); k++)
+		out.v[k] = func(a.v[na == 1 ? 0 : k], b.v[nb == 1 ? 0 : k]);
+	return out;
+}
+
+template<typename F>
+static Value zip(const Value& a, const Value& b, const Value& c, F func) {
+	const Value* args[3] = { &a, &b, &c };
+	Type tp = Type::FLOAT;
+	for (const Value* arg : args) {
+		if (arg->tp == Type::NONE || (arg->tp != Type::FLOAT && tp != Type::FLOAT && arg->tp != tp))
+			return Value();
+		if (arg->tp != Type::FLOAT)
+			tp = arg->tp;
+	}
+
+	Value out;
+	out.tp = tp;
+	for (int32_t k = 0; k < uniform::numComponents(tp); k++)
+		out.v[k] = func(a.v[size(a) == 1 ? 0 : k], b.v[size(b) == 1 ? 0 : k], c.v[size(c) == 1 ? 0 : k]);
+	return out;
+}
+
+template<typename F>
+static Value each(const Value& a, F func) {
+	Value out = a;
+	for (int32_t k = 0; k < size(a); k++)
+		out.v[k] = func(a.v[k]);
+	return out;
+}
+
+// Matrix products, with matrices stored column major like glsl
+static Value product(const Value& a, const Value& b) {
+	Value out;
+	if (isMatrix(a.tp) && a.tp == b.tp) {
+		const int32_t n = dimension(a.tp);
+		out.tp = a.tp;
+		for (int32_t col = 0; col < n; col++)
+			for (int32_t row = 0; row < n; row++)
+				for (int32_t k = 0; k < n; k++)
+					out.v[col * n + row] += a.v[k * n + row] * b.v[col * n + k];
+	}
+	else if (isMatrix(a.tp) && !isMatrix(b.tp) && size(b) == dimension(a.tp)) {
+		const int32_t n = dimension(a.tp);
+		out.tp = b.tp;
+		for (int32_t row = 0; row < n; row++)
+			for (int32_t k = 0; k < n; k++)
+				out.v[row] += a.v[k * n + row] * b.v[k];
+	}
+	else if (isMatrix(b.tp) && !isMatrix(a.tp) && size(a) == dimension(b.tp)) {
+		const int32_t n = dimension(b.tp);
+		out.tp = a.tp;
+		for (int32_t col = 0; col < n; col++)
+			for (int32_t k = 0; k < n; k++)
+				out.v[col] += a.v[k] * b.v[col * n + k];
+	}
+	return out;
+}
+
+static float dotProduct(const Value& a, const Value& b) {
+	float sum = 0.0f;
+	for (int32_t k = 0; k < size(a); k++)
+		sum += a.v[k] * b.v[k];
+	return sum;
+}
+
+static Value construct(Type tp, const Value* args, int32_t count) {
+	Value out;
+	out.tp = tp;
+	const int32_t total = uniform::numComponents(tp);
+
+	// A single scalar fills vectors and the diagonal of matrices
+	if (count == 1 && args[0].tp == Type::FLOAT) {
+		for (int32_t k = 0; k < total; k++)
+			out.v[k] = isMatrix(tp) ? (k % (dimension(tp) + 1) == 0 ? args[0].v[0] : 0.0f) : args[0].v[0];
+		return out;
+	}
+
+	// Matrices from matrices keep the upper left part, completed with identity
+	if (count == 1 && isMatrix(tp) && isMatrix(args[0].tp)) {
+		const int32_t n = dimension(tp), m = dimension(args[0].tp);
+		for (int32_t col = 0; col < n; col++)
+			for (int32_t row = 0; row < n; row++)
+				out.v[col * n + row] = col < m && row < m ? args[0].v[col * m + row] : (col == row ? 1.0f : 0.0f);
+		return out;
+	}
+
+	int32_t filled = 0;
+	for (int32_t k = 0; k < count; k++) {
+		if (args[k].tp == Type::NONE)
+			return Value();
+		for (int32_t i = 0; i < size(args[k]) && filled < total; i++)
+			out.v[filled++] = args[k].v[i];
+	}
+
+	return filled == total ? out : Value();
+}
+
+static Value call(int32_t func, const Value* args, int32_t count) {
+	const Value& a = args[0];
+	switch (func) {
+	case SIN: return each(a, [](float x) { return std::sin(x); });
+	case COS: return each(a, [](float x) { return std::cos(x); });
+	case TAN: return each(a, [](float x) { return std::tan(x); });
+	case ASIN: return each(a, [](float x) { return std::asin(x); });
+	case ACOS: return each(a, [](float x) { return std::acos(x); });
+	case ATAN:
+		if (count == 2)
+			return zip(a, args[1], [](float y, float x) { return std::atan2(y, x); });
+		return each(a, [](float x) { return std::atan(x); });
+	case SQRT: return each(a, [](float x) { return std::sqrt(x); });
+	case INVERSESQRT: return each(a, [](float x) { return 1.0f / std::sqrt(x); });
+	case ABS: return each(a, [](float x) { return std::abs(x); });
+	case SIGN: return each(a, [](float x) { return float((x > 0.0f) - (x < 0.0f)); });
+	case FLOOR: return each(a, [](float x) { return std::floor(x); });
+	case CEIL: return each(a, [](float x) { return std::ceil(x); });
+	case FRACT: return each(a, [](float x) { return x - std::floor(x); });
+	case EXP: return each(a, [](float x) { return std::exp(x); });
+	case EXP2: return each(a, [](float x) { return std::exp2(x); });
+	case LOG: return each(a, [](float x) { return std::log(x); });
+	case LOG2: return each(a, [](float x) { return std::log2(x); });
+	case RADIANS: return each(a, [](float x) { return 0.01745329252f * x; });
+	case DEGREES: return each(a, [](float x) { return 57.29577951f * x; });
+
+	case POW: return zip(a, args[1], [](float x, float y) { return std::pow(x, y); });
+	case MIN: return zip(a, args[1], [](float x, float y) { return std::min(x, y); });
+	case MAX: return zip(a, args[1], [](float x, float y) { return std::max(x, y); });
+	case MOD: return zip(a, args[1], [](float x, float y) { return x - y * std::floor(x / y); });
+	case STEP: return zip(a, args[1], [](float edge, float x) { return x < edge ? 0.0f : 1.0f; });
+	case CLAMP: return zip(a, args[1], args[2], [](float x, float lo, float hi) { return std::min(std::max(x, lo), hi); });
+	case MIX: return zip(a, args[1], args[2], [](float x, float y, float t) { return x + t * (y - x); });
+	case SMOOTHSTEP:
+		return zip(a, args[1], args[2], [](float e0, float e1, float x) {
+			float t = std::min(std::max((x - e0) / (e1 - e0), 0.0f), 1.0f);
+			return t * t * (3.0f - 2.0f * t);
+		});
+
+	case LENGTH:
+		return isMatrix(a.tp) || a.tp == Type::NONE ? Value() : scalar(std::sqrt(dotProduct(a, a)));
+	case DISTANCE: {
+		Value diff = zip(a, args[1], [](float x, float y) { return x - y; });
+		return isMatrix(diff.tp) || diff.tp == Type::NONE ? Value() : scalar(std::sqrt(dotProduct(diff, diff)));
+	}
+	case DOT:
+		return a.tp == args[1].tp && !isMatrix(a.tp) && a.tp != Type::NONE ? scalar(dotProduct(a, args[1])) : Value();
+	case CROSS: {
+		const Value& b = args[1];
+		if (a.tp != Type::VEC3 || b.tp != Type::VEC3)
+			return Value();
+
+		Value out;
+		out.tp = Type::VEC3;
+		out.v[0] = a.v[1] * b.v[2] - a.v[2] * b.v[1];
+		out.v[1] = a.v[2] * b.v[0] - a.v[0] * b.v[2];
+		out.v[2] = a.v[0] * b.v[1] - a.v[1] * b.v[0];
+		return out;
+	}
+	case NORMALIZE: {
+		if (isMatrix(a.tp) || a.tp == Type::NONE)
+			return Value();
+		float len = std::sqrt(dotProduct(a, a));
+		return each(a, [len](float x) { return x / len; });
+	}
+
+	case FLOAT: return a.tp == Type::NONE ? Value() : scalar(a.v[0]);
+	case VEC2: return construct(Type::VEC2, args, count);
+	case VEC3: return construct(Type::VEC3, args, count);
+	case VEC4: return construct(Type::VEC4, args, count);
+	case MAT2: return construct(Type::MAT2, args, count);
+	case MAT3: return construct(Type::MAT3, args, count);
+	case MAT4: return construct(Type::MAT4, args, count);
+	default: return Value();
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+struct Program::Parser {
+	Program& prog;
+	const std::string& src;
+	size_t pos = 0;
+	int32_t depth = 0; // stack size at this point of the program
+	std::string error;
+
+	Parser(Program& prog, const std::string& src) : prog(prog), src(src) {}
+
+	void skip(void) {
+		while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos])))
+			pos++;
+	}
+
+	bool accept(char ch) {
+		skip();
+		if (pos < src.size() && src[pos] == ch) {
+			pos++;
+			return true;
+		}
+		return false;
+	}
+
+	bool fail(const std::string& message) {
+		if (error.empty())
+			error = message + " at column " + std::to_string(pos + 1);
+		return false;
+	}
+
+	std::string identifier(void) {
+		skip();
+		size_t begin = pos;
+		if (pos < src.size() && (std::isalpha(static_cast<unsigned char>(src[pos])) || src[pos] == '_')) {
+			while (pos < src.size() && (std::isalnum(static_cast<unsigned char>(src[pos])) || src[pos] == '_'))
+				pos++;
+		}
+		return src.substr(begin, pos - begin);
+	}
+
+	// Instructions pop 'pops' values and push one
+	bool emit(Op op, int32_t arg, int32_t count, int32_t pops) {
+		prog.code.push_back({ op, arg, count });
+		depth += 1 - pops;
+		if (depth > MAX_DEPTH)
+			return fail("Expression is nested too deeply");
+		return true;
+	}
+
+	bool expression(void) {
+		if (!term())
+			return false;
+
+		while (true) {
+			if (accept('+')) {
+				if (!term() || !emit(Op::ADD, 0, 0, 2))
+					return false;
+			}
+			else if (accept('-')) {
+				if (!term() || !emit(Op::SUBTRACT, 0, 0, 2))
+					return false;
+			}
+			else
+				return true;
+		}
+	}
+
+	bool term(void) {
+		if (!unary())
+			return false;
+
+		while (true) {
+			if (accept('*')) {
+				if (!unary() || !emit(Op::MULTIPLY, 0, 0, 2))
+					return false;
+			}
+			else if (accept('/')) {
+				if (!unary() || !emit(Op::DIVIDE, 0, 0, 2))
+					return false;
+			}
+			else
+				return true;
+		}
+	}
+
+	bool unary(void) {
+		if (accept('-'))
+			return unary() && emit(Op::NEGATE, 0, 0, 1);
+		if (accept('+'))
+			return unary();
+		return postfix();
+	}
+
+	bool postfix(void) {
+		if (!primary())
+			return false;
+
+		while (accept('.')) {
+			const std::string mask = identifier();
+			if (mask.empty() || mask.size() > 4)
+				return fail("Invalid swizzle '" + mask + "'");
+
+			int32_t packed = 0;
+			for (size_t k = 0; k < mask.size(); k++) {
+				int32_t index = -1;
+				for (const char* set : { "xyzw", "rgba", "stpq" }) {
+					const char* found = std::strchr(set, mask[k]);
+					if (found != nullptr)
+						index = int32_t(found - set);
+				}
+
+				if (index < 0)
+					return fail("Invalid swizzle '" + mask + "'");
+				packed |= index << (2 * k);
+			}
+
+			if (!emit(Op::SWIZZLE, packed, int32_t(mask.size()), 1))
+				return false;
+		}
+		return true;
+	}
+
+	bool primary(void) {
+		skip();
+		if (pos >= src.size())
+			return fail("Unexpected end of expression");
+
+		const char ch = src[pos];
+		if (std::isdigit(static_cast<unsigned char>(ch)) || ch == '.') {
+			char* end = nullptr;
+			float value = std::strtof(src.c_str() + pos, &end);
+			if (end == src.c_str() + pos)
+				return fail("Invalid number");
+
+			pos = size_t(end - src.c_str());
+			if (pos < src.size() && (src[pos] == 'f' || src[pos] == 'F'))
+				pos++;
+
+			prog.constants.push_back(value);
+			return emit(Op::CONSTANT, int32_t(prog.constants.size()) - 1, 0, 0);
+		}
+
+		if (accept('(')) {
+			if (!expression())
+				return false;
+			return accept(')') || fail("Expected ')'");
+		}
+
+		const std::string name = identifier();
+		if (name.empty())
+			return fail(std::string("Unexpected '") + ch + "'");
+
+		if (accept('(')) {
+			int32_t func = 0;
+			while (func < NUM_FUNCTIONS && name != functions[func].name)
+				func++;
+			if (func == NUM_FUNCTIONS)
+				return fail("Unknown function '" + name + "'");
+
+			int32_t count = 0;
+			if (!accept(')')) {
+				do {
+					if (!expression())
+						return false;
+					count++;
+				} while (accept(','));
+
+				if (!accept(')'))
+					return fail("Expected ')'");
+			}
+
+			if (count < functions[func].minArgs || count > functions[func].maxArgs)
+				return fail("Wrong number of arguments for '" + name + "'");
+
+			return emit(Op::CALL, func, count, count);
+		}
+
+		// Values of names are provided by the caller on every run
+		auto it = std::find(prog.names.begin(), prog.names.end(), name);
+		if (it == prog.names.end())
+			it = prog.names.insert(prog.names.end(), name);
+
+		return emit(Op::LOAD, int32_t(it - prog.names.begin()), 0, 0);
+	}
+};
+
+bool Program::compile(const std::string& source, std::string& error) {
+	text = source;
+	code.clear();
+	constants.clear();
+	names.clear();
+
+	Parser parser(*this, text);
+	if (parser.expression()) {
+		parser.skip();
+		if (parser.pos < text.size())
+			parser.fail("Unexpected '" + text.substr(parser.pos, 1) + "'");
+	}
+
+	error = parser.error;
+	if (!error.empty())
+		code.clear();
+
+	return error.empty();
+}
+
+Value Program::run(const std::vector<Value>& values) const {
+	Value stack[MAX_DEPTH];
+	int32_t top = 0;
+
+	for (const Instruction& ins : code) {
+		switch (ins.op) {
+		case Op::CONSTANT:
+			stack[top++] = scalar(constants[ins.arg]);
+			break;
+		case Op::LOAD:
+			stack[top++] = values[ins.arg];
+			break;
+		case Op::NEGATE:
+			stack[top - 1] = each(stack[top - 1], [](float x) { return -x; });
+			break;
+		case Op::ADD:
+			top--;
+			stack[top - 1] = zip(stack[top - 1], stack[top], [](float x, float y) { return x + y; });
+			break;
+		case Op::SUBTRACT:
+			top--;
+			stack[top - 1] = zip(stack[top - 1], stack[top], [](float x, float y) { return x - y; });
+			break;
+		case Op::MULTIPLY: {
+			top--;
+			const Value &a = stack[top - 1], &b = stack[top];
+			if ((isMatrix(a.tp) || isMatrix(b.tp)) && a.tp != Type::FLOAT && b.tp != Type::FLOAT)
+				stack[top - 1] = product(a, b);
+			else
+				stack[top - 1] = zip(a, b, [](float x, float y) { return x * y; });
+			break;
+		}
+		case Op::DIVIDE:
+			top--;
+			stack[top - 1] = zip(stack[top - 1], stack[top], [](float x, float y) { return x / y; });
+			break;
+		case Op::CALL:
+			top -= ins.count;
+			stack[top] = call(ins.arg, stack + top, ins.count);
+			top++;
+			break;
+		case Op::SWIZZLE: {
+			const Value source = stack[top - 1];
+			Value& out = stack[top - 1];
+			out.tp = isMatrix(source.tp) ? Type::NONE : vectorType(ins.count);
+			for (int32_t k = 0; k < ins.count && out.tp != Type::NONE; k++) {
+				const int32_t index = (ins.arg >> (2 * k)) & 3;
+				if (index >= size(source))
+					out.tp = Type::NONE;
+				else
+					out.v[k] = source.v[index];
+			}
+			break;
+		}
+		}
+
+		if (stack[top - 1].tp == Type::NONE)
+			return Value();
+	}
+
+	return top == 1 ? stack[0] : Value();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+static bool isBuiltin(const std::string& name) {
+	for (const char* builtin : { "iTime", "iRatio", "iMouse", "iCamPos", "iCamYaw", "iCamPitch", "iFOV" })
+		if (name == builtin)
+			return true;
+	return false;
+}
+
+void scan(const DynamicShader& shader, uniform::Uniform& uniforms, const Colors& colors, bool silent) {
+	auto report = [silent](const std::string& message, bool warning) {
+		if (silent)
+			return;
+		if (warning)
+			GRender::mailbox::CreateWarn(message);
+		else
+			GRender::mailbox::CreateError(message);
+	};
+
+	// Annotations that went away leave their uniforms editable again
+	for (const auto& [name, data] : uniforms)
+		data->expression.reset();
+
+	for (const uniform::Annotation& note : uniform::findAnnotations(shader.getSource(), "expr")) {
+		const std::string& name = note.name;
+		const std::string tag = "##" + name;
+
+		Type tp = Type::NONE;
+		for (int32_t k = 1; k < static_cast<int32_t>(Type::TOTAL); k++)
+			if (note.type == uniform::glslName(static_cast<Type>(k)))
+				tp = static_cast<Type>(k);
+
+		if (tp == Type::NONE) {
+			report("Expression for '" + name + "': type '" + note.type + "' isn't supported", false);
+			continue;
+		}
+
+		std::shared_ptr<Program> program = std::make_shared<Program>();
+		std::string error;
+		if (!program->compile(note.args, error)) {
+			report("Expression for '" + name + "': " + error, false);
+			continue;
+		}
+
+		uniform::ParentData* data = uniforms.find(tag);
+		if (data == nullptr) {
+			data = uniform::create(tag, tp);
+			uniforms.append(tag, data);
+		}
+
+		if (data->tp != tp || data->count != 1) {
+			report("Expression for '" + name + "': uniform is already defined as another type", false);
+			continue;
+		}
+
+		// Names without a value read as zero, like unset uniforms in glsl
+		for (const std::string& var : program->getNames()) {
+			const bool known = isBuiltin(var) || uniforms.find("##" + var) != nullptr
+				|| std::any_of(colors.begin(), colors.end(), [&var](const auto& color) { return color.first == "##" + var; });
+			if (!known)
+				report("Expression for '" + name + "': '" + var + "' isn't defined", true);
+		}
+
+		data->expression = program;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+struct Context {
+	uniform::Uniform& uniforms;
+	const Colors& colors;
+	const Inputs& inputs;
+	std::map<const uniform::ParentData*, bool> visited; // false while evaluating, to break cycles
+};
+
+static void update(Context& ctx, uniform::ParentData* data);
+
+static Value lookup(Context& ctx, const std::string& name) {
+	Value out;
+	const GRender::Camera* cam = ctx.inputs.camera;
+
+	if (name == "iTime")
+		return scalar(ctx.inputs.time);
+	if (name == "iRatio")
+		return scalar(ctx.inputs.ratio);
+	if (name == "iMouse") {
+		out.tp = Type::VEC2;
+		out.v[0] = ctx.inputs.mouse.x;
+		out.v[1] = ctx.inputs.mouse.y;
+		return out;
+	}
+
+	if (cam != nullptr) {
+		if (name == "iCamPos") {
+			out.tp = Type::VEC3;
+			std::copy_n(&cam->getPosition().x, 3, out.v);
+			return out;
+		}
+		if (name == "iCamYaw")
+			return scalar(cam->getYaw());
+		if (name == "iCamPitch")
+			return scalar(cam->getPitch());
+		if (name == "iFOV")
+			return scalar(cam->getFOV());
+	}
+
+	uniform::ParentData* data = ctx.uniforms.find("##" + name);
+	if (data != nullptr && data->count == 1) {
+		if (data->expression && ctx.visited.count(data) == 0)
+			update(ctx, data);
+
+		out.tp = data->tp < Type::FLOAT ? vectorType(uniform::numComponents(data->tp)) : data->tp;
+		const void* ptr = uniform::dataPointer(data);
+		for (int32_t k = 0; k < uniform::numComponents(data->tp); k++)
+			out.v[k] = data->tp < Type::FLOAT ? float(reinterpret_cast<const int32_t*>(ptr)[k]) : reinterpret_cast<const float*>(ptr)[k];
+		return out;
+	}
+
+	for (const auto& [tag, color] : ctx.colors) {
+		if (tag.compare(2, std::string::npos, name) == 0) {
+			out.tp = Type::VEC3;
+			std::copy_n(&color.x, 3, out.v);
+			return out;
+		}
+	}
+
+	return scalar(0.0f);
+}
+
+static void update(Context& ctx, uniform::ParentData* data) {
+	ctx.visited[data] = false;
+
+	const Program& program = *data->expression;
+	std::vector<Value> values;
+	values.reserve(program.getNames().size());
+	for (const std::string& name : program.getNames())
+		values.push_back(lookup(ctx, name));
+
+	// Results of another shape leave the previous value in place; scalars fill vectors
+	Value result = program.run(values);
+	const int32_t num = uniform::numComponents(data->tp);
+	const Type expected = data->tp < Type::FLOAT ? vectorType(num) : data->tp;
+	if (result.tp == expected || (result.tp == Type::FLOAT && !isMatrix(expected))) {
+		void* ptr = uniform::dataPointer(data);
+		for (int32_t k = 0; k < num; k++) {
+			const float value = result.v[result.tp == Type::FLOAT ? 0 : k];
+			if (data->tp < Type::FLOAT)
+				reinterpret_cast<int32_t*>(ptr)[k] = int32_t(std::round(value));
+			else
+				reinterpret_cast<float*>(ptr)[k] = value;
+		}
+	}
+
+	ctx.visited[data] = true;
+}
+
+void evaluate(uniform::Uniform& uniforms, const Colors& colors, const Inputs& inputs) {
+	GSHADER_PROFILE_FUNCTION();
+	Context ctx = { uniforms, colors, inputs, {} };
+	for (const auto& [name, data] : uniforms) {
+		if (data->expression && ctx.visited.count(data.get()) == 0)
+			update(ctx, data.get());
+	}
+}
+
+} // namespace expr
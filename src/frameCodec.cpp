@@ -0,0 +1,147 @@
+#include "frameCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace codec {
+
+// Sequences start with a token holding literal count in its high nibble and match length minus
+// MIN_MATCH in its low one; 15 means more bytes follow, each adding up to 255. Then come literals,
+// and for every sequence but the last, a 16 bits offset back to the match
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr uint32_t HASH_BITS = 16;
+
+static uint32_t read32(const uint8_t* ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static void writeLength(std::vector<uint8_t>& out, size_t length) {
+    for (; length >= 255; length -= 255)
+        out.push_back(255);
+    out.push_back(uint8_t(length));
+}
+
+static void writeSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength) {
+    const size_t extra = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+    out.push_back(uint8_t((numLiterals < 15 ? numLiterals : 15) << 4 | (extra < 15 ? extra : 15)));
+
+    if (numLiterals >= 15)
+        writeLength(out, numLiterals - 15);
+    out.insert(out.end(), literals, literals + numLiterals);
+
+    if (matchLength == 0)
+        return;
+
+    out.push_back(uint8_t(offset & 0xFF));
+    out.push_back(uint8_t(offset >> 8));
+    if (extra >= 15)
+        writeLength(out, extra - 15);
+}
+
+void compress(const uint8_t* data, size_t size, uint32_t stride, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> delta(size);
+    for (size_t k = 0; k < size; k++)
+        delta[k] = uint8_t(data[k] - (k >= stride ? data[k - stride] : 0));
+
+    out.clear();
+    out.reserve(size / 4);
+
+    const uint8_t* src = delta.data();
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0); // position + 1 of last sequence with this hash
+
+    size_t anchor = 0, pos = 0;
+    while (pos + MIN_MATCH <= size) {
+        const uint32_t seq = read32(src + pos);
+        const uint32_t hash = (seq * 2654435761u) >> (32 - HASH_BITS);
+        const size_t candidate = table[hash];
+        table[hash] = uint32_t(pos + 1);
+
+        if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || read32(src + candidate - 1) != seq) {
+            // Searches get sparser through data that doesn't compress
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+
+        const size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (pos + length < size && src[match + length] == src[pos + length])
+            length++;
+
+        writeSequence(out, src + anchor, pos - anchor, pos - match, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+static bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length) {
+    uint8_t byte = 255;
+    while (byte == 255) {
+        if (ip == end)
+            return false;
+        byte = *ip++;
+        length += byte;
+    }
+    return true;
+}
+
+bool decompress(const std::vector<uint8_t>& data, size_t size, uint32_t stride, std::vector<uint8_t>& out) {
+    out.resize(size);
+    const uint8_t* ip = data.data();
+    const uint8_t* end = ip + data.size();
+    uint8_t* dst = out.data();
+    size_t pos = 0;
+
+    while (ip < end) {
+        const uint8_t token = *ip++;
+
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !readLength(ip, end, numLiterals))
+            return false;
+        if (numLiterals > size_t(end - ip) || numLiterals > size - pos)
+            return false;
+
+        std::memcpy(dst + pos, ip, numLiterals);
+        ip += numLiterals;
+        pos += numLiterals;
+
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return false;
+        const size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+        ip += 2;
+
+        size_t length = token & 15;
+        if (length == 15 && !readLength(ip, end, length))
+            return false;
+        length += MIN_MATCH;
+
+        if (offset == 0 || offset > pos || length > size - pos)
+            return false;
+
+        // Matches may overlap what they produce, repeating the last 'offset' bytes. Each copy
+        // takes everything written so far from start of match, so copies double in size
+        for (size_t copied = 0; copied < length;) {
+            const size_t count = std::min(copied + offset, length - copied);
+            std::memcpy(dst + pos + copied, dst + pos - offset, count);
+            copied += count;
+        }
+        pos += length;
+    }
+
+    if (pos != size)
+        return false;
+
+    for (size_t k = stride; k < size; k++)
+        out[k] = uint8_t(out[k] + out[k - stride]);
+
+    return true;
+}
+
+} // namespace codec
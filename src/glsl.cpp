@@ -0,0 +1,338 @@
+#include "glsl.h"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace glsl {
+
+bool isIdentifierChar(char ch) {
+	return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+}
+
+size_t lineOf(const std::string& src, size_t pos) {
+	return 1 + std::count(src.begin(), src.begin() + std::min(pos, src.size()), '\n');
+}
+
+std::string stripComments(const std::string& src) {
+	std::string out(src);
+
+	for (size_t k = 0; k + 1 < out.size(); k++) {
+		if (out[k] == '/' && out[k + 1] == '/') {
+			for (; k < out.size() && out[k] != '\n'; k++)
+				out[k] = ' ';
+		}
+		else if (out[k] == '/' && out[k + 1] == '*') {
+			out[k] = out[k + 1] = ' ';
+			for (k += 2; k < out.size(); k++) {
+				if (k + 1 < out.size() && out[k] == '*' && out[k + 1] == '/') {
+					out[k] = out[k + 1] = ' ';
+					k++;
+					break;
+				}
+				if (out[k] != '\n')
+					out[k] = ' ';
+			}
+		}
+	}
+
+	return out;
+}
+
+size_t matchBracket(const std::string& src, size_t pos) {
+	const char open = src[pos];
+	const char close = open == '(' ? ')' : open == '{' ? '}' : ']';
+
+	int32_t depth = 0;
+	for (size_t k = pos; k < src.size(); k++) {
+		if (src[k] == open)
+			depth++;
+		else if (src[k] == close && --depth == 0)
+			return k;
+	}
+	return std::string::npos;
+}
+
+size_t skipSpaces(const std::string& src, size_t pos) {
+	while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos])))
+		pos++;
+	return pos;
+}
+
+// Returns [begin, end) of identifier ending right before 'pos', ignoring spaces
+static std::pair<size_t, size_t> identifierBefore(const std::string& src, size_t pos) {
+	size_t end = pos;
+	while (end > 0 && std::isspace(static_cast<unsigned char>(src[end - 1])))
+		end--;
+
+	size_t begin = end;
+	while (begin > 0 && isIdentifierChar(src[begin - 1]))
+		begin--;
+
+	return { begin, end };
+}
+
+// If 'pos' lies on a preprocessor line, like the word 'module' of '#pragma module'
+static bool inDirective(const std::string& src, size_t pos) {
+	size_t line = src.rfind('\n', pos);
+	line = line == std::string::npos ? 0 : line + 1;
+
+	size_t first = src.find_first_not_of(" \t", line);
+	return first < src.size() && src[first] == '#';
+}
+
+std::vector<std::string> splitArguments(const std::string& src, size_t open, size_t close) {
+	std::vector<std::string> args;
+	int32_t depth = 0;
+	size_t start = open + 1;
+
+	for (size_t k = open + 1; k < close; k++) {
+		char ch = src[k];
+		if (ch == '(' || ch == '[' || ch == '{')
+			depth++;
+		else if (ch == ')' || ch == ']' || ch == '}')
+			depth--;
+		else if (ch == ',' && depth == 0) {
+			args.push_back(src.substr(start, k - start));
+			start = k + 1;
+		}
+	}
+
+	std::string last = src.substr(start, close - start);
+	if (last.find_first_not_of(" \t\r\n") != std::string::npos || !args.empty())
+		args.push_back(last);
+
+	return args;
+}
+
+std::vector<Function> findFunctions(const std::string& src) {
+	std::vector<Function> functions;
+
+	int32_t depth = 0;
+	for (size_t k = 0; k < src.size(); k++) {
+		const char ch = src[k];
+
+		// Preprocessor directives are skipped entirely
+		if (ch == '#') {
+			k = src.find('\n', k);
+			if (k == std::string::npos)
+				break;
+			continue;
+		}
+
+		if (ch == '{' || ch == '}') {
+			depth += ch == '{' ? 1 : -1;
+			continue;
+		}
+
+		if (ch != '(' || depth != 0)
+			continue;
+
+		// A function looks like 'type name(...)' followed by '{' or ';'
+		auto [nameBegin, nameEnd] = identifierBefore(src, k);
+		auto [typeBegin, typeEnd] = identifierBefore(src, nameBegin);
+		if (nameBegin == nameEnd || typeBegin == typeEnd)
+			continue;
+
+		size_t close = matchBracket(src, k);
+		if (close == std::string::npos)
+			break;
+
+		size_t next = skipSpaces(src, close + 1);
+		if (next >= src.size() || (src[next] != '{' && src[next] != ';')) {
+			continue;
+		}
+
+		Function fn;
+		fn.name = src.substr(nameBegin, nameEnd - nameBegin);
+		fn.returnType = src.substr(typeBegin, typeEnd - typeBegin);
+
+		// Qualifiers before return type belong to the declaration as well
+		fn.begin = typeBegin;
+		for (auto qual = identifierBefore(src, fn.begin); qual.first != qual.second && !inDirective(src, qual.first); qual = identifierBefore(src, fn.begin))
+			fn.begin = qual.first;
+
+		for (const std::string& arg : splitArguments(src, k, close)) {
+			std::string param = arg.substr(0, arg.find('['));
+			auto [pBegin, pEnd] = identifierBefore(param, param.size());
+			std::string name = param.substr(pBegin, pEnd - pBegin);
+			if (!name.empty() && name != "void")
+				fn.params.push_back(name);
+		}
+
+		fn.bodyBegin = next;
+		fn.prototype = src[next] == ';';
+		fn.end = fn.prototype ? next + 1 : matchBracket(src, next) + 1;
+
+		if (fn.end == 0) // unbalanced brackets
+			break;
+
+		functions.push_back(std::move(fn));
+		k = functions.back().end - 1;
+	}
+
+	return functions;
+}
+
+void blankBody(std::string& src, const Function& fn) {
+	if (fn.prototype)
+		return;
+
+	src[fn.bodyBegin] = ';';
+	for (size_t k = fn.bodyBegin + 1; k < fn.end; k++) {
+		if (src[k] != '\n')
+			src[k] = ' ';
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Something that can be dropped, spanning [begin, end) of source
+struct Symbol {
+	std::string name;
+	size_t begin, end;
+};
+
+// Macro definitions, with their whole lines including continuations
+static void findDefines(const std::string& src, std::vector<Symbol>& symbols) {
+	for (size_t k = 0; k < src.size();) {
+		size_t end = std::min(src.find('\n', k), src.size());
+
+		size_t pos = src.find_first_not_of(" \t", k);
+		if (pos < end && src[pos] == '#') {
+			pos = src.find_first_not_of(" \t", pos + 1);
+			if (pos < end && src.compare(pos, 6, "define") == 0 && !isIdentifierChar(src[pos + 6])) {
+				size_t nameBegin = src.find_first_not_of(" \t", pos + 6), nameEnd = nameBegin;
+				while (nameEnd < end && isIdentifierChar(src[nameEnd]))
+					nameEnd++;
+
+				while (end < src.size() && src[end - 1] == '\\')
+					end = std::min(src.find('\n', end + 1), src.size());
+
+				if (nameBegin < nameEnd)
+					symbols.push_back({ src.substr(nameBegin, nameEnd - nameBegin), k, end });
+			}
+		}
+
+		k = end + 1;
+	}
+}
+
+// Top level 'struct Name { ... };'. Structs declaring variables as well are always kept
+static void findStructs(const std::string& src, std::vector<Symbol>& symbols) {
+	int32_t depth = 0;
+	for (size_t k = 0; k < src.size(); k++) {
+		const char ch = src[k];
+		if (ch == '#') {
+			k = src.find('\n', k);
+			if (k == std::string::npos)
+				break;
+			continue;
+		}
+
+		if (ch == '{' || ch == '}') {
+			depth += ch == '{' ? 1 : -1;
+			continue;
+		}
+
+		if (depth != 0 || src.compare(k, 6, "struct") != 0 || (k > 0 && isIdentifierChar(src[k - 1]))
+			|| k + 6 >= src.size() || isIdentifierChar(src[k + 6]))
+			continue;
+
+		size_t nameBegin = skipSpaces(src, k + 6), nameEnd = nameBegin;
+		while (nameEnd < src.size() && isIdentifierChar(src[nameEnd]))
+			nameEnd++;
+
+		size_t open = skipSpaces(src, nameEnd);
+		if (nameEnd == nameBegin || open >= src.size() || src[open] != '{')
+			continue;
+
+		size_t close = matchBracket(src, open);
+		if (close == std::string::npos)
+			break;
+
+		size_t semicolon = skipSpaces(src, close + 1);
+		if (semicolon < src.size() && src[semicolon] == ';')
+			symbols.push_back({ src.substr(nameBegin, nameEnd - nameBegin), k, semicolon + 1 });
+
+		k = close;
+	}
+}
+
+// Calls every identifier found in [begin, end)
+template <typename FN>
+static void forIdentifiers(const std::string& src, size_t begin, size_t end, FN&& fn) {
+	for (size_t k = begin; k < end; k++) {
+		if (!isIdentifierChar(src[k]))
+			continue;
+
+		size_t first = k;
+		while (k < end && isIdentifierChar(src[k]))
+			k++;
+
+		if (!std::isdigit(static_cast<unsigned char>(src[first])))
+			fn(src.substr(first, k - first));
+	}
+}
+
+std::string prune(const std::string& src) {
+	const std::string clean = stripComments(src);
+
+	std::vector<Symbol> symbols;
+	for (const Function& fn : findFunctions(clean))
+		symbols.push_back({ fn.name, fn.begin, fn.end });
+	findStructs(clean, symbols);
+	findDefines(clean, symbols);
+
+	// Macros inside bodies go along with their function
+	std::sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) { return a.begin < b.begin; });
+	std::vector<Symbol> outer;
+	for (Symbol& sym : symbols) {
+		if (outer.empty() || sym.begin >= outer.back().end)
+			outer.push_back(std::move(sym));
+	}
+
+	std::unordered_map<std::string, std::vector<const Symbol*>> byName;
+	for (const Symbol& sym : outer)
+		byName[sym.name].push_back(&sym);
+
+	std::unordered_set<std::string> reached;
+	std::vector<std::string> pending;
+	auto reach = [&](const std::string& name) {
+		if (byName.count(name) > 0 && reached.insert(name).second)
+			pending.push_back(name);
+	};
+
+	// Everything that isn't a symbol is kept, so it may reference any of them
+	reach("main");
+	size_t last = 0;
+	for (const Symbol& sym : outer) {
+		forIdentifiers(clean, last, sym.begin, reach);
+		last = sym.end;
+	}
+	forIdentifiers(clean, last, clean.size(), reach);
+
+	while (!pending.empty()) {
+		std::string name = std::move(pending.back());
+		pending.pop_back();
+		for (const Symbol* sym : byName[name])
+			forIdentifiers(clean, sym->begin, sym->end, reach);
+	}
+
+	std::string out(src);
+	for (const Symbol& sym : outer) {
+		if (reached.count(sym.name) > 0)
+			continue;
+
+		for (size_t k = sym.begin; k < sym.end; k++) {
+			if (out[k] != '\n')
+				out[k] = ' ';
+		}
+	}
+
+	return out;
+}
+
+} // namespace glsl
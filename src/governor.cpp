@@ -0,0 +1,200 @@
+#include "governor.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <regex>
+
+using namespace uniform;
+
+void Governor::scan(const DynamicShader& shader, Uniform& uniforms) {
+	const std::regex range("^(-?[0-9.]+)[ \\t]+(-?[0-9.]+)");
+
+	for (const Annotation& note : findAnnotations(shader.getSource(), "quality")) {
+		if (note.type != "int" && note.type != "float")
+			continue;
+
+		const std::string tag = "##" + note.name;
+		const Type tp = note.type == "int" ? Type::INT : Type::FLOAT;
+		std::smatch match;
+
+		ParentData* data = uniforms.find(tag);
+		if (data == nullptr) {
+			// New knobs start at full quality, the top of the annotated range
+			data = create(tag, tp);
+			uniforms.append(tag, data);
+
+			if (std::regex_search(note.args, match, range)) {
+				float low = std::stof(match[1].str()), high = std::stof(match[2].str());
+				if (tp == Type::INT) {
+					reinterpret_cast<DataInt*>(data)->range = { int32_t(low), int32_t(high) };
+					reinterpret_cast<DataInt*>(data)->data.x = int32_t(high);
+				}
+				else {
+					reinterpret_cast<DataFloat*>(data)->range = { low, high };
+					reinterpret_cast<DataFloat*>(data)->data.x = high;
+				}
+			}
+		}
+
+		if (data->tp == tp && data->count == 1)
+			data->knob = true;
+	}
+}
+
+void Governor::update(float deltaTime, const GRender::Camera& camera) {
+	double ms = 0.0;
+	while (timer.fetch(ms))
+		gpuTime = gpuTime > 0.0 ? 0.8 * gpuTime + 0.2 * ms : ms;
+
+	const bool moving = camera.getPosition() != lastPosition || camera.getYaw() != lastYaw
+		|| camera.getPitch() != lastPitch || camera.getFOV() != lastFOV;
+
+	lastPosition = camera.getPosition();
+	lastYaw = camera.getYaw();
+	lastPitch = camera.getPitch();
+	lastFOV = camera.getFOV();
+
+	if (!enabled) {
+		quality = 1.0f;
+		return;
+	}
+
+	still = moving ? 0.0f : still + deltaTime;
+
+	// Lowest of what motion and measured cost ask for. Cost is taken as proportional to quality,
+	// so the same estimate lowers an expensive view and keeps recovery from overshooting budget
+	float target = moving ? movingQuality : 1.0f;
+	if (gpuTime > 0.0)
+		target = std::min(target, quality * float(double(budget) / gpuTime));
+
+	// Drops are immediate, recovery is gradual and only once the view is settled
+	const float previous = quality;
+	if (target < quality)
+		quality = target;
+	else if (still >= settleTime)
+		quality = std::min(target, quality + deltaTime / std::max(rampTime, 0.01f));
+
+	quality = std::clamp(quality, minQuality, 1.0f);
+
+	// Measurements arrive a few frames late, so the estimate follows the change right away
+	if (gpuTime > 0.0 && previous > 0.0f)
+		gpuTime *= double(quality / previous);
+}
+
+void Governor::lower(Uniform& uniforms) {
+	saved.clear();
+	if (quality >= 1.0f)
+		return;
+
+	// Values go from the chosen one towards bottom of the range
+	for (const auto& [name, ptr] : uniforms) {
+		ParentData* data = ptr.get();
+		if (!data->knob || data->count != 1)
+			continue;
+
+		if (data->tp == Type::INT) {
+			DataInt* knob = reinterpret_cast<DataInt*>(data);
+			saved.push_back({ data, float(knob->data.x) });
+
+			float low = float(std::min(knob->range.x, knob->data.x));
+			knob->data.x = int32_t(std::round(low + quality * (float(knob->data.x) - low)));
+		}
+		else if (data->tp == Type::FLOAT) {
+			DataFloat* knob = reinterpret_cast<DataFloat*>(data);
+			saved.push_back({ data, knob->data.x });
+
+			float low = std::min(knob->range.x, knob->data.x);
+			knob->data.x = low + quality * (knob->data.x - low);
+		}
+	}
+}
+
+void Governor::restore(void) {
+	for (const Saved& entry : saved) {
+		if (entry.data->tp == Type::INT)
+			reinterpret_cast<DataInt*>(entry.data)->data.x = int32_t(entry.value);
+		else
+			reinterpret_cast<DataFloat*>(entry.data)->data.x = entry.value;
+	}
+	saved.clear();
+}
+
+void Governor::beginTiming(void) {
+	timer.begin();
+}
+
+void Governor::endTiming(void) {
+	timer.end();
+}
+
+void Governor::reset(void) {
+	quality = 1.0f;
+	still = 0.0f;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Governor::showGovernor(const Uniform& uniforms) {
+	if (!active)
+		return;
+
+	ImGui::Begin("Quality governor", &active);
+	ImGui::SetWindowSize({ 450.0f, 350.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	ImGui::Checkbox("Enabled", &enabled);
+
+	ImGui::SetNextItemWidth(0.5f * width);
+	ImGui::SliderFloat("GPU budget (ms)", &budget, 1.0f, 100.0f, "%.1f");
+	ImGui::SetNextItemWidth(0.5f * width);
+	ImGui::SliderFloat("While moving", &movingQuality, 0.0f, 1.0f, "%.2f");
+	ImGui::SetNextItemWidth(0.5f * width);
+	ImGui::SliderFloat("Minimum quality", &minQuality, 0.0f, 1.0f, "%.2f");
+	ImGui::SetNextItemWidth(0.5f * width);
+	ImGui::SliderFloat("Ramp up (s)", &rampTime, 0.0f, 5.0f, "%.2f");
+
+	ImGui::Separator();
+	ImGui::Text("Quality: %.0f%%", 100.0f * quality);
+	ImGui::SameLine(0.5f * width);
+	ImGui::TextDisabled("GPU: %.2f ms", gpuTime);
+
+	ImGui::Separator();
+
+	// Knobs with the value used at current quality
+	bool any = false;
+	for (const auto& [name, ptr] : uniforms) {
+		if (!ptr->knob || ptr->count != 1)
+			continue;
+
+		any = true;
+		ImGui::Text("%s", name.c_str() + 2);
+		ImGui::SameLine(0.5f * width);
+		if (ptr->tp == Type::INT) {
+			const DataInt* knob = reinterpret_cast<const DataInt*>(ptr.get());
+			float low = float(std::min(knob->range.x, knob->data.x));
+			ImGui::TextDisabled("%d -> %d", knob->data.x, int32_t(std::round(low + quality * (float(knob->data.x) - low))));
+		}
+		else if (ptr->tp == Type::FLOAT) {
+			const DataFloat* knob = reinterpret_cast<const DataFloat*>(ptr.get());
+			float low = std::min(knob->range.x, knob->data.x);
+			ImGui::TextDisabled("%.3f -> %.3f", knob->data.x, low + quality * (knob->data.x - low));
+		}
+	}
+
+	if (!any)
+		ImGui::TextDisabled("No knobs. Right click a uniform or annotate it with '// @quality'");
+
+	ImGui::End();
+}
+
+void Governor::open(void) {
+	active = true;
+}
+
+void Governor::close(void) {
+	active = false;
+}
@@ -0,0 +1,55 @@
+#include "gpuTimer.h"
+
+GpuTimer::~GpuTimer(void) {
+    if (queries[0] != 0)
+        glDeleteQueries(GLsizei(queries.size()), queries.data());
+}
+
+bool GpuTimer::begin(void) {
+    if (queries[0] == 0)
+        glGenQueries(GLsizei(queries.size()), queries.data());
+
+    if (running || count == queries.size())
+        return false;
+
+    uint32_t id = queries[(head + count) % queries.size()];
+    glBeginQuery(GL_TIME_ELAPSED, id);
+    running = true;
+    return true;
+}
+
+void GpuTimer::end(void) {
+    if (!running)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    running = false;
+    count++;
+}
+
+bool GpuTimer::fetch(double& ms) {
+    if (count == 0)
+        return false;
+
+    GLint available = 0;
+    glGetQueryObjectiv(queries[head], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(queries[head], GL_QUERY_RESULT, &elapsed);
+    ms = 1e-6 * double(elapsed);
+
+    head = (head + 1) % queries.size();
+    count--;
+    return true;
+}
+
+void GpuTimer::clear(void) {
+    // Pending results are simply forgotten, queries get reused once they finish
+    if (running)
+        end();
+
+    head = (head + count) % queries.size();
+    count = 0;
+}
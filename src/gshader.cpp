@@ -1,4 +1,5 @@
 #include "gshader.h"
+#include "checker.h"
 
 #include "GRender/entryPoint.h"
 namespace mouse = mouse;
@@ -14,6 +15,20 @@ GRender::Application* GRender::createApplication(int argc, char** argv) {
 	if (fs::exists(exe))
 		fs::current_path(exe);
 
+	// Headless replay of a recorded session, used for repeatable performance runs
+	if (argc == 3 && std::string(argv[1]) == "--replay") {
+		fs::path logpath = fs::absolute(currDir / argv[2]);
+		GShader* app = new GShader("../examples/basic.glsl");
+		app->replay(logpath, true);
+		return app;
+	}
+
+	// Batch validation never opens the interface, it prints results and exits
+	if (argc >= 3 && std::string(argv[1]) == "--check") {
+		std::vector<std::string> args(argv + 2, argv + argc);
+		std::exit(Checker::run(args, currDir));
+	}
+
 	if (argc == 1)
 		return new GShader("../examples/basic.glsl");
 	else {
@@ -25,6 +40,38 @@ GRender::Application* GRender::createApplication(int argc, char** argv) {
 	}
 }
 
+// FNV-1a over everything besides time that changes the main view. Expression uniforms
+// follow time and the values hashed here, so they are left out
+static uint64_t sceneKey(const Camera& camera, const Colors& colors, const Uniform& uniforms, uint32_t channels) {
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](const void* data, size_t size) -> void {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+		for (size_t k = 0; k < size; k++)
+			hash = (hash ^ bytes[k]) * 1099511628211ull;
+	};
+
+	const glm::vec3& position = camera.getPosition();
+	const float angles[] = { camera.getYaw(), camera.getPitch(), camera.getFOV() };
+	add(&position, sizeof(position));
+	add(angles, sizeof(angles));
+
+	for (const auto& [tag, color] : colors) {
+		add(tag.data(), tag.size());
+		add(&color, sizeof(color));
+	}
+
+	for (const auto& [name, data] : uniforms) {
+		if (data->expression)
+			continue;
+
+		add(name.data(), name.size());
+		add(uniform::dataPointer(data.get()), sizeof(float) * uniform::numValues(data.get()));
+	}
+
+	add(&channels, sizeof(channels));
+	return hash;
+}
+
 
 GShader::GShader(const fs::path& filepath) : Application("GShader", 1200, 800, "layout.ini") {
 	quad = quad::Quad(1);
@@ -33,6 +80,13 @@ GShader::GShader(const fs::path& filepath) : Application("GShader", 1200, 800, "
 	*fbuffer = Framebuffer(1200, 800);
 	shader.initialize();
 
+	// Frame rate policies are a property of the machine, not of the shader
+	if (fs::exists("scheduler.json")) {
+		ConfigFile config("scheduler.json");
+		config.load();
+		scheduler.setPolicy(config.get<Scheduler::Policy>());
+	}
+
 	if (!fs::exists(filepath)) {
 		importShader("../examples/basic.glsl");
 		mailbox::CreateError("File doesn't exist: " + filepath.string());
@@ -49,9 +103,26 @@ GShader::GShader(const fs::path& filepath) : Application("GShader", 1200, 800, "
 	}
 }
 
+GShader::~GShader(void) {
+	// Shared textures outlive every set of channels, but not the context
+	Channels::clearCache();
+}
+
 
 
 void GShader::onUserUpdate(float deltaTime) {
+	GSHADER_PROFILE_FRAME();
+	GSHADER_PROFILE_SCOPE("onUserUpdate");
+
+	// Replayed sessions take every input from the log and are never throttled
+	Recorder::Frame frame;
+	const bool replaying = recorder.next(frame);
+	if (replaying)
+		deltaTime = frame.deltaTime;
+
+	// Throttling according to window state. This might block until an event arrives
+	bool render = replaying ? frame.render : scheduler.wait(ctrlPlay || ctrlStep || poster.isRendering() || compare.isRunning() || browser.isBusy() || buffers.isUploading() || channels.isBusy() || history.isBusy());
+
 	bool ctrl = keyboard::IsDown(Key::LEFT_CONTROL) || keyboard::IsDown(Key::RIGHT_CONTROL);
 	bool alt = keyboard::IsDown(Key::LEFT_ALT) || keyboard::IsDown(Key::RIGHT_ALT);
 	bool shift = keyboard::IsDown(Key::LEFT_SHIFT) || keyboard::IsDown(Key::RIGHT_SHIFT);
@@ -83,16 +154,32 @@ void GShader::onUserUpdate(float deltaTime) {
         dialog::SaveFile("Save configurations...", {"json"}, function, this);
     }
 
+    if (ctrl && keyboard::IsPressed('B'))
+        browser.open();
+
 	///////////////////////////////////////////////////////
 	// Control
-	if (!shift && keyboard::IsPressed(Key::SPACE)) { ctrlPlay = !ctrlPlay; }
+	bool reset = false;
+	if (replaying) {
+		ctrlPlay = frame.play;
+		ctrlStep = frame.step;
+		reset = frame.reset;
+	}
+	else {
+		if (!shift && keyboard::IsPressed(Key::SPACE)) { ctrlPlay = !ctrlPlay; }
 
-	if (shift && keyboard::IsPressed(Key::SPACE)) {
-		ctrlStep = true;
-		ctrlPlay = false;
+		if (shift && keyboard::IsPressed(Key::SPACE)) {
+			ctrlStep = true;
+			ctrlPlay = false;
+		}
+
+		reset = ctrlReset || (shift && keyboard::IsPressed('R'));
+		frame.play = ctrlPlay;
+		frame.step = ctrlStep;
+		frame.reset = reset;
 	}
 
-	if (ctrlReset || (shift && keyboard::IsPressed('R'))) {
+	if (reset) {
 		ctrlReset = false;
 
 		elapsedTime = 0.0f;
@@ -116,14 +203,218 @@ void GShader::onUserUpdate(float deltaTime) {
 		alt ? camera.close() : camera.open();
 
 	// Automatic controls for camera
-	if (fbuffer.active && ctrlPlay)
+	if (replaying)
+		Recorder::apply(frame, uniforms, colors, camera);
+	else if (fbuffer.active && ctrlPlay)
 		camera.controls(deltaTime);
 
+	// Replays keep every knob as recorded, and a paused view is always left at full quality
+	if (replaying)
+		governor.reset();
+	else
+		governor.update(deltaTime, camera);
+
+	if (!ctrlPlay && governor.isLowered()) {
+		governor.reset();
+		ctrlStep = true;
+	}
+
+	glm::vec2 cursor = { 0.0f, 0.0f };
+	if (replaying) {
+		cursor = frame.cursor;
+	}
+	else if (fbuffer.active) {
+		glm::uvec2 fpos = fbuffer->getPosition();
+		glm::uvec2 size = fbuffer->getSize();
+		glm::vec2 mpos = mouse::Position();
+		cursor.x = (mpos.x - fpos.x) / float(size.x);
+		cursor.y = 1.0f - (mpos.y - fpos.y) / float(size.y);
+	}
+
+	if (recorder.isRecording()) {
+		frame.deltaTime = deltaTime;
+		frame.render = render;
+		frame.position = camera.getPosition();
+		frame.yaw = camera.getYaw();
+		frame.pitch = camera.getPitch();
+		frame.fov = camera.getFOV();
+		frame.cursor = cursor;
+		recorder.record(frame, uniforms, colors);
+	}
+
 	// Update shader if it was modified
 	elapsedTime += deltaTime;
 	if (shader.wasUpdated())
 		importShader(currentShader);
 
+	// Stored frames show right away, other times are drawn again from there
+	if (history.isEnabled() && history.setScene(sceneKey(camera, colors, uniforms, channels.getVersion())))
+		ctrlStep = true;
+
+	history.update();
+	float scrubTime = 0.0f;
+	if (history.scrubRequested(scrubTime)) {
+		ctrlPlay = false;
+		elapsedTime = scrubTime;
+		if (!history.display(scrubTime))
+			ctrlStep = true;
+	}
+
+	if (ctrlPlay || ctrlStep)
+		history.resume();
+
+	if (analyzer.requested())
+		analyzer.analyze(shader);
+
+	if (deepZoom.update(shader)) {
+		history.clear();
+		ctrlStep = true;
+	}
+
+	if (heat.wasToggled())
+		heat.load(currentShader);
+
+	if (compare.requested())
+		compare.start(elapsedTime);
+
+	if (viewports.addRequested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			reinterpret_cast<GShader*>(ptr)->viewports.add(path);
+		};
+		dialog::OpenFile("Add viewport...", { "json", "glsl" }, function, this);
+	}
+
+	if (buffers.addRequested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			reinterpret_cast<GShader*>(ptr)->buffers.add(path);
+		};
+		dialog::OpenFile("Add data buffer...", { "bin", "raw", "dat" }, function, this);
+	}
+
+	if (channels.pickRequested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			reinterpret_cast<GShader*>(ptr)->channels.setPicked(path);
+		};
+		dialog::OpenFile("Set channel...", { "png", "jpg", "jpeg", "ppm", "pgm" }, function, this);
+	}
+
+	if (viewports.duplicateRequested())
+		viewports.add(currentShader, colors, uniforms, camera);
+
+	viewports.update(deltaTime, ctrlPlay, camera);
+
+	if (profiler.exportRequested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			if (!reinterpret_cast<GShader*>(ptr)->profiler.exportTrace(path))
+				mailbox::CreateError("Cannot write to '" + path.string() + "'");
+		};
+		dialog::SaveFile("Export trace...", { "json" }, function, this);
+	}
+
+	if (recorder.recordRequested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			GShader* gs = reinterpret_cast<GShader*>(ptr);
+			gs->recorder.startRecording(path, gs->currentShader, gs->elapsedTime, gs->ctrlPlay);
+		};
+		dialog::SaveFile("Record session...", { "gsrec" }, function, this);
+	}
+
+	if (recorder.replayRequested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			reinterpret_cast<GShader*>(ptr)->replay(path, false);
+		};
+		dialog::OpenFile("Replay session...", { "gsrec" }, function, this);
+	}
+
+	if (sweep.saveRequested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			reinterpret_cast<GShader*>(ptr)->sweep.save(path);
+		};
+		dialog::SaveFile("Save contact sheet...", { "ppm" }, function, this);
+	}
+
+	if (poster.requested()) {
+		auto function = [](const fs::path& path, void* ptr) -> void {
+			GShader* gs = reinterpret_cast<GShader*>(ptr);
+			gs->poster.start(path, gs->elapsedTime);
+		};
+		dialog::SaveFile("Save poster...", { "ppm" }, function, this);
+	}
+
+	//////////////////////////////////////////////////////////
+	// Poster tiles are rendered a few at a time to keep interface responsive
+
+	if (scheduler.wasModified()) {
+		ConfigFile config("scheduler.json");
+		config.insert(scheduler.getPolicy());
+		config.save();
+	}
+
+	// Data files and images are streamed a few megabytes per frame, even while paused
+	buffers.update(deltaTime);
+	channels.update(deltaTime);
+
+	if (!render)
+		return;
+
+	// Previews are produced in the background, opening them works as with the dialog
+	browser.update(deltaTime);
+	{
+		fs::path chosen = browser.selected();
+		if (chosen.extension() == ".json")
+			loadConfig(chosen);
+		else if (!chosen.empty())
+			importShader(chosen);
+	}
+
+#ifdef GSHADER_PREVIEW_SERVER
+	// Frames captured in previous iterations are handed to the encoders once ready
+	{
+		glm::uvec2 size;
+		std::vector<uint8_t> rgb;
+		if (readback.fetch(rgb, size))
+			server.publish(std::move(rgb), size);
+	}
+#endif
+
+	if (poster.isRendering() && !shader.hasFailed()) {
+		evaluate(camera, colors, uniforms, poster.getResolution(), poster.getTime(), { 0.0f, 0.0f });
+		for (int32_t k = 0; k < poster.getTilesPerFrame() && poster.isRendering(); k++) {
+			glm::ivec2 offset = poster.beginTile();
+			drawShader(shader, offset, poster.getTileSize(), poster.getResolution(), poster.getTime(), { 0.0f, 0.0f });
+			poster.endTile();
+		}
+	}
+
+	// Whole contact sheet comes from a single instanced draw
+	if (sweep.requested() && sweep.begin(currentShader, uniforms, colors)) {
+		const glm::uvec2& tile = sweep.getTileSize();
+		evaluate(camera, colors, uniforms, tile, elapsedTime, { 0.0f, 0.0f });
+		setupShader(sweep.getShader(), { 0, 0 }, tile, tile, elapsedTime, { 0.0f, 0.0f });
+		sweep.end();
+	}
+
+	// Both sides of a comparison are drawn every frame with the same inputs
+	if (compare.isRunning()) {
+		const glm::uvec2& size = compare.getResolution();
+		evaluate(camera, colors, uniforms, size, compare.getTime(), { 0.0f, 0.0f });
+		for (int32_t k = 0; k < 2; k++) {
+			DynamicShader& program = compare.begin(k);
+			drawShader(program, { 0, 0 }, size, size, compare.getTime(), { 0.0f, 0.0f });
+			compare.end();
+		}
+	}
+
+	// Extra viewports share a GPU budget, so background ones may skip this frame
+	if (ctrlPlay || ctrlStep) {
+		for (Viewports::View* view : viewports.schedule(ctrlStep)) {
+			glm::uvec2 res = viewports.begin(*view);
+			evaluate(view->camera, view->colors, view->uniforms, res, elapsedTime, view->cursor);
+			drawShader(view->shader, view->camera, view->colors, view->uniforms, { 0, 0 }, res, res, elapsedTime, view->cursor);
+			viewports.end(*view);
+		}
+	}
+
 	//////////////////////////////////////////////////////////
 	// Drawing to framebuffer
 
@@ -131,50 +422,183 @@ void GShader::onUserUpdate(float deltaTime) {
 		return;
 
 	glm::uvec2 res = fbuffer->getSize();
-	float aRatio = float(res.x) / float(res.y);
+
+	// Render thread only gets parameters; tools instrumenting or reading the main view, and
+	// textures streamed by this thread, keep drawing here
+	bool threaded = renderer.isRunning() && !replaying && !recorder.isRecording() && !heat.isEnabled()
+		&& !prepass.isEnabled() && channels.isEmpty() && buffers.getSources().empty() && !deepZoom.isActive()
+		&& !history.isEnabled() && !edgeAA.isEnabled();
+#ifdef GSHADER_PREVIEW_SERVER
+	threaded = threaded && !server.wantsFrames();
+#endif
+
+	threadedView = threaded;
+	if (threaded) {
+		RenderThread::Snapshot& snap = renderer.snapshot();
+		snap.shaderpath = currentShader;
+		snap.modules = moduleMode;
+		snap.pruning = pruneMode;
+		snap.resolution = res;
+		snap.time = elapsedTime;
+		snap.cursor = cursor;
+		snap.camera = camera;
+		snap.colors = colors;
+
+		governor.lower(uniforms);
+		evaluate(camera, colors, uniforms, res, elapsedTime, cursor);
+		snap.uniforms = uniforms.clone();
+		governor.restore();
+
+		// Values still go to interface copy without drawing, so its reflection knows what is assigned
+		setupShader(shader, { 0, 0 }, res, res, elapsedTime, cursor);
+
+		renderer.submit();
+		ctrlStep = false;
+		return;
+	}
+
+	// Coarse and full passes must see the same scene, so both use the lowered knobs.
+	// Heat map measures actual cost, so it always gets the chosen values
+	if (!heat.isEnabled())
+		governor.lower(uniforms);
+
+	evaluate(camera, colors, uniforms, res, elapsedTime, cursor);
+
+	// Heat map draws from the pre-pass too, so its step counts show what the pre-pass saves
+	if (prepass.isEnabled()) {
+		glm::uvec2 low = prepass.beginCoarse(res, camera.getFOV());
+		drawShader(shader, { 0, 0 }, low, low, elapsedTime, cursor);
+		prepass.endCoarse();
+	}
 
 	fbuffer->bind();
 
+	if (heat.isEnabled()) {
+		// Instrumented copy replaces the regular image while heat map is on
+		glm::ivec2 pixel = { -1, -1 };
+		if (fbuffer.active)
+			pixel = glm::ivec2(cursor * glm::vec2(res));
+
+		DynamicShader& program = heat.begin(res);
+		drawShader(program, { 0, 0 }, res, res, elapsedTime, cursor);
+		heat.end(pixel);
+	}
+	else {
+		// A single time query can run at once, replays are measured by recorder
+		if (!replaying)
+			governor.beginTiming();
+
+		recorder.beginTiming();
+		if (edgeAA.isEnabled()) {
+			// Extra samples only shade pixels marked as edges, and are averaged into the view
+			edgeAA.beginBase(res);
+			drawShader(shader, { 0, 0 }, res, res, elapsedTime, cursor);
+			edgeAA.detect();
+
+			for (int32_t k = 0; k < edgeAA.getSamples(); k++)
+				drawShader(shader, edgeAA.beginSample(k), res, res, elapsedTime, cursor);
+
+			edgeAA.endSamples();
+			fbuffer->bind();
+			edgeAA.resolve();
+		}
+		else {
+			drawShader(shader, { 0, 0 }, res, res, elapsedTime, cursor);
+		}
+		recorder.endTiming();
+
+		if (!replaying)
+			governor.endTiming();
+	}
+
+	// Frames at lowered quality would be shown as final ones when scrubbing
+	if (!heat.isEnabled() && !governor.isLowered())
+		history.capture(elapsedTime, res);
+
+#ifdef GSHADER_PREVIEW_SERVER
+	if (server.wantsFrames())
+		readback.capture(res.x, res.y);
+#endif
+
+	fbuffer->unbind();
+
+	governor.restore();
+	prepass.finish();
+
+	// Resetting step controller, so no more updates are made
+	ctrlStep = false;
+}
+
+void GShader::setupShader(DynamicShader& program, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor) {
+	// Sampler uniforms go to the bound program, so it is bound first. Tools assign their samplers
+	// a fixed unit even when unused, as unassigned ones read unit 0 with the data buffers
+	program.bind();
+	buffers.bind();
+	channels.bind(program);
+	prepass.bind(program);
+	deepZoom.bind(program);
+	setupShader(program, camera, colors, uniforms, offset, size, fullRes, time, cursor);
+}
+
+void GShader::setupShader(DynamicShader& program, Camera& cam, Colors& cols, Uniform& unis, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor) {
+	GSHADER_PROFILE_SCOPE("Submit uniforms");
+	float aRatio = float(fullRes.x) / float(fullRes.y);
+
 	// Setup shader
-	shader.bind();
-	shader.setFloat("iTime", elapsedTime);
-	shader.setFloat("iRatio", aRatio);
+	program.bind();
+	program.setFloat("iTime", time);
+	program.setFloat("iRatio", aRatio);
 
-	shader.setVec3f("iCamPos", glm::value_ptr(camera.getPosition()));
-	shader.setFloat("iCamYaw", camera.getYaw());
-	shader.setFloat("iCamPitch", camera.getPitch());
-	shader.setFloat("iFOV", camera.getFOV());
+	glm::vec2 tileOffset = offset, tileSize = size, resolution = fullRes;
+	program.setVec2f("iTileOffset", glm::value_ptr(tileOffset));
+	program.setVec2f("iTileSize", glm::value_ptr(tileSize));
+	program.setVec2f("iFullResolution", glm::value_ptr(resolution));
 
+	program.setVec3f("iCamPos", glm::value_ptr(cam.getPosition()));
+	program.setFloat("iCamYaw", cam.getYaw());
+	program.setFloat("iCamPitch", cam.getPitch());
+	program.setFloat("iFOV", cam.getFOV());
 
-	float vec[2] = { 0.0f, 0.0f };
-	if (fbuffer.active) {
-		glm::uvec2 fpos = fbuffer->getPosition();
-		glm::uvec2 size = fbuffer->getSize();
-		glm::vec2 mpos = mouse::Position();
-		vec[0] = (mpos.x - fpos.x) / float(size.x);
-		vec[1] = 1.0f - (mpos.y - fpos.y) / float(size.y);
-	}
-	shader.setVec2f("iMouse", vec);
+	program.setVec2f("iMouse", glm::value_ptr(cursor));
 
 	// Submit data to shader
-	colors.submit(shader);
-	uniforms.submit(shader);
+	cols.submit(program);
+	unis.submit(program);
+}
+
+void GShader::evaluate(Camera& cam, Colors& cols, Uniform& unis, const glm::uvec2& fullRes, float time, const glm::vec2& cursor) {
+	GSHADER_PROFILE_SCOPE("Evaluate expressions");
+	expr::Inputs inputs = { time, float(fullRes.x) / float(fullRes.y), cursor, &cam };
+	expr::evaluate(unis, cols, inputs);
+}
+
+void GShader::drawShader(DynamicShader& program, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor) {
+	GSHADER_PROFILE_FUNCTION();
+	setupShader(program, offset, size, fullRes, time, cursor);
 
 	// Drawing quad
 	quad.draw(specs);
 	quad.submit();
+}
 
-	fbuffer->unbind();
+void GShader::drawShader(DynamicShader& program, Camera& cam, Colors& cols, Uniform& unis, const glm::vec2& offset, const glm::uvec2& size, const glm::uvec2& fullRes, float time, const glm::vec2& cursor) {
+	GSHADER_PROFILE_FUNCTION();
+	setupShader(program, cam, cols, unis, offset, size, fullRes, time, cursor);
 
-	// Resetting step controller, so no more updates are made
-	ctrlStep = false;
+	// Drawing quad
+	quad.draw(specs);
+	quad.submit();
 }
 
 void GShader::ImGuiLayer(void) {
+	GSHADER_PROFILE_FUNCTION();
+
 	if (view_specs) {
 		ImGui::Begin("Specs", &view_specs);
 		ImGui::Text("FT: %.3f ms", 1000.0f * ImGui::GetIO().DeltaTime);
 		ImGui::Text("FPS: %.0f", ImGui::GetIO().Framerate);
+		if (renderer.isRunning())
+			ImGui::Text("Render thread: %.3f ms", renderer.getFrameTime());
 		ImGui::Text("Vendor: %s", glGetString(GL_VENDOR));
 		ImGui::Text("Graphics card: %s", glGetString(GL_RENDERER));
 		ImGui::Text("OpenGL version: %s", glGetString(GL_VERSION));
@@ -183,9 +607,30 @@ void GShader::ImGuiLayer(void) {
 	}
 
 	// External utility to edit colors on the fly
+	colors.reflect(shader);
 	colors.showColors();
+	uniforms.reflect(shader);
 	uniforms.showUniforms();
 	camera.display();
+	poster.showPoster();
+	scheduler.showScheduler();
+	analyzer.showAnalysis();
+	heat.showHeatMap();
+	compare.showCompare();
+	sweep.showSweep(uniforms, colors);
+	browser.showBrowser();
+	recorder.showRecorder();
+	profiler.showProfiler();
+	viewports.showViewports();
+	buffers.showBuffers();
+	channels.showChannels();
+	governor.showGovernor(uniforms);
+	deepZoom.showDeepZoom();
+	history.showHistory(elapsedTime);
+
+#ifdef GSHADER_PREVIEW_SERVER
+	server.showServer();
+#endif
 
 	{
 		// Hidden feature to help development
@@ -205,7 +650,12 @@ void GShader::ImGuiLayer(void) {
 
 	// Check if it needs to resize
 	ImVec2 port = ImGui::GetContentRegionAvail();
-	ImGui::Image((void *)(uintptr_t)fbuffer->getID(), port, {0.0f, 1.0f}, {1.0f, 0.0f});
+	uint32_t texture = fbuffer->getID();
+	if (history.isDisplaying() && history.getTexture() > 0)
+		texture = history.getTexture();
+	else if (threadedView && renderer.getTexture() > 0)
+		texture = renderer.getTexture();
+	ImGui::Image((void *)(uintptr_t)texture, port, {0.0f, 1.0f}, {1.0f, 0.0f});
 
 	glm::uvec2 view = fbuffer->getSize();
 	glm::uvec2 uport = { port.x, port.y };
@@ -216,6 +666,14 @@ void GShader::ImGuiLayer(void) {
 	ImVec2 ps = ImGui::GetWindowPos();
 	fbuffer->setPosition(ps.x, ps.y);
 
+	// Wheel and drag move the fractal instead of camera while deep zoom is in use
+	ImVec2 pointer = ImGui::GetMousePos();
+	glm::vec2 cursor = { (pointer.x - ps.x) / port.x, 1.0f - (pointer.y - ps.y) / port.y };
+	if (deepZoom.navigate(cursor, { port.x, port.y }, fbuffer.active)) {
+		history.clear();
+		ctrlStep = true;
+	}
+
 	ImGui::End();
 	ImGui::PopStyleVar();
 
@@ -251,6 +709,8 @@ void GShader::ImGuiLayer(void) {
 }
 
 void GShader::ImGuiMenuLayer(void) {
+	GSHADER_PROFILE_FUNCTION();
+
 	if (ImGui::BeginMenu("File")) {
 
         if (ImGui::MenuItem("Open shader...", "Ctrl+O")) {
@@ -264,6 +724,17 @@ void GShader::ImGuiMenuLayer(void) {
 			dialog::OpenFile("Open shader...", { "json", "glsl" }, function, this);
 		}
 
+		if (ImGui::MenuItem("Add viewport...")) {
+			auto function = [](const fs::path& path, void* ptr) -> void {
+				reinterpret_cast<GShader*>(ptr)->viewports.add(path);
+			};
+			dialog::OpenFile("Add viewport...", { "json", "glsl" }, function, this);
+		}
+
+		if (ImGui::MenuItem("Browse shaders...", "Ctrl+B")) {
+			browser.open();
+		}
+
         if (ImGui::MenuItem("Save configurations...", "Ctrl+S")) {
             auto function = [](const fs::path& path, void* ptr) -> void {
                 reinterpret_cast<GShader*>(ptr)->saveConfig(path);
@@ -271,6 +742,10 @@ void GShader::ImGuiMenuLayer(void) {
             dialog::SaveFile("Save configurations...", {"json"}, function, this);
         }
 
+		if (ImGui::MenuItem("Render poster...")) {
+			poster.open();
+		}
+
 		if (ImGui::MenuItem("Exit"))
 			closeApp();
 
@@ -293,11 +768,103 @@ void GShader::ImGuiMenuLayer(void) {
 			camera.open();
 		}
 
+		if (ImGui::MenuItem("Quality governor...")) {
+			governor.open();
+		}
+
+		if (ImGui::MenuItem("Data buffers...")) {
+			buffers.open();
+		}
+
+		if (ImGui::MenuItem("Channels...")) {
+			channels.open();
+		}
+
+		if (ImGui::MenuItem("Cost analysis...")) {
+			analyzer.open();
+		}
+
+		if (ImGui::MenuItem("Heat map...")) {
+			heat.open();
+		}
+
+		if (ImGui::MenuItem("Parameter sweep...")) {
+			sweep.open();
+		}
+
+		if (ImGui::MenuItem("A/B compare...")) {
+			compare.setShader(currentShader);
+			compare.open();
+		}
+
+		if (ImGui::MenuItem("Recorder...")) {
+			recorder.open();
+		}
+
+		if (ImGui::MenuItem("Profiler...")) {
+			profiler.open();
+		}
+
+		if (ImGui::MenuItem("Scheduler...")) {
+			scheduler.open();
+		}
+
+		if (ImGui::MenuItem("Viewports...")) {
+			viewports.open();
+		}
+
+		if (ImGui::MenuItem("Deep zoom...")) {
+			deepZoom.open();
+		}
+
+		if (ImGui::MenuItem("Frame history...")) {
+			history.open();
+		}
+
+		bool useThread = renderer.isRunning();
+		if (ImGui::MenuItem("Render thread", nullptr, &useThread)) {
+			if (useThread) {
+				renderer.start([this](DynamicShader& program, RenderThread::Snapshot& snap) {
+					setupShader(program, snap.camera, snap.colors, snap.uniforms, { 0, 0 }, snap.resolution, snap.resolution, snap.time, snap.cursor);
+				});
+			}
+			else {
+				renderer.stop();
+				threadedView = false;
+			}
+		}
+
+		bool usePrepass = prepass.isEnabled();
+		if (ImGui::MenuItem("Depth pre-pass", nullptr, &usePrepass))
+			prepass.setEnabled(usePrepass);
+
+		edgeAA.showMenu();
+
+		if (ImGui::MenuItem("Module mode", nullptr, &moduleMode)) {
+			shader.setModules(moduleMode);
+			viewports.setModules(moduleMode);
+			if (!currentShader.empty())
+				importShader(currentShader);
+		}
+
+		if (ImGui::MenuItem("Prune unused code", nullptr, &pruneMode)) {
+			shader.setPruning(pruneMode);
+			if (!currentShader.empty())
+				importShader(currentShader);
+		}
+
+#ifdef GSHADER_PREVIEW_SERVER
+		if (ImGui::MenuItem("Preview server...")) {
+			server.open();
+		}
+#endif
+
 		ImGui::EndMenu();
 	}
 }
 
 void GShader::importShader(const fs::path& shaderpath) {
+	GSHADER_PROFILE_FUNCTION();
 	mailbox::Clear();
 	mailbox::Close();
 	elapsedTime = 0.0f;
@@ -309,12 +876,29 @@ void GShader::importShader(const fs::path& shaderpath) {
 		currentShader = shaderpath;
 		colors = Colors();
 		camera = Camera();
+		buffers = DataBuffers();
+		channels = Channels();
 	}
 
 	shader.loadShader(shaderpath);
+	history.clear();
+	edgeAA.scan(shader);
+	governor.scan(shader, uniforms);
+	expr::scan(shader, uniforms, colors);
+	analyzer.invalidate();
+	heat.load(shaderpath);
 	setAppTitle("GShader :: " + shaderpath.filename().string());
 }
 
+void GShader::replay(const fs::path& logpath, bool headless) {
+	if (!recorder.startReplay(logpath, headless))
+		return;
+
+	importShader(recorder.getShader());
+	elapsedTime = recorder.getStartTime();
+	ctrlPlay = recorder.getStartPlaying();
+}
+
 void GShader::loadConfig(const fs::path& configpath) {
 	//ASSERT(fs::exists(configpath), "'" + configpath.string() + "' doesn't exist!");
 	
@@ -329,6 +913,8 @@ void GShader::loadConfig(const fs::path& configpath) {
 	colors = config.get<Colors>();
 	uniforms = config.get<uniform::Uniform>();
 	camera = config.get<Camera>();
+	buffers = config.get<DataBuffers>();
+	channels = config.get<Channels>();
 
 	importShader(currentShader);
 }
@@ -341,5 +927,7 @@ void GShader::saveConfig(const fs::path& configpath) {
 	config.insert(colors);
 	config.insert(camera);
 	config.insert(uniforms);
+	config.insert(buffers);
+	config.insert(channels);
 	config.save();
 }
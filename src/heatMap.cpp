@@ -0,0 +1,320 @@
+#include "heatMap.h"
+#include "glsl.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <regex>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Binding points reserved for instrumentation
+static constexpr uint32_t COUNTS_UNIT = 0;
+static constexpr uint32_t HISTOGRAM_BINDING = 7;
+
+// Last histogram entry holds the largest value in the frame
+static constexpr GLsizeiptr HISTOGRAM_BYTES = (HeatMap::NUM_BINS + 1) * sizeof(uint32_t);
+
+HeatMap::~HeatMap(void) {
+	for (Slot& slot : slots) {
+		glDeleteSync(slot.fence);
+		glDeleteBuffers(1, &slot.bufferID);
+	}
+}
+
+void HeatMap::load(const fs::path& shaderpath) {
+	if (!enabled)
+		return;
+
+	if (!initialized) {
+		shader.initialize();
+		shader.setPass([this](const std::string& src) -> std::string { return instrument(src, marchName, distName); });
+		initialized = true;
+	}
+
+	shader.loadShader(shaderpath);
+}
+
+bool HeatMap::isEnabled(void) const {
+	return enabled && initialized && !shader.hasFailed();
+}
+
+DynamicShader& HeatMap::begin(const glm::uvec2& size) {
+	if (counts.getSize() != size)
+		counts = RenderTarget(size.x, size.y, GL_RGBA32UI);
+
+	Slot& slot = slots[head];
+	if (slot.bufferID == 0) {
+		glCreateBuffers(1, &slot.bufferID);
+		glNamedBufferData(slot.bufferID, HISTOGRAM_BYTES + sizeof(hovered), nullptr, GL_DYNAMIC_READ);
+	}
+
+	// With every slot in flight, oldest frame is dropped
+	if (slot.fence != nullptr) {
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+
+	uint32_t zero = 0;
+	glClearNamedBufferData(slot.bufferID, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, HISTOGRAM_BINDING, slot.bufferID);
+	glBindImageTexture(COUNTS_UNIT, counts.getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32UI);
+
+	shader.bind();
+	shader.setInteger("gsHeatMode", static_cast<int32_t>(mode));
+	shader.setFloat("gsHeatMax", std::max(maxValue, 1.0f));
+	shader.setFloat("gsHeatBlend", blend);
+
+	return shader;
+}
+
+void HeatMap::end(const glm::ivec2& hoveredPixel) {
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	// Hovered counters are copied next to the histogram, so both arrive with the same fence
+	Slot& slot = slots[head];
+	const glm::uvec2& size = counts.getSize();
+	slot.hovered = hoveredPixel.x >= 0 && hoveredPixel.y >= 0 && uint32_t(hoveredPixel.x) < size.x && uint32_t(hoveredPixel.y) < size.y;
+	if (slot.hovered) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.bufferID);
+		glGetTextureSubImage(counts.getID(), 0, hoveredPixel.x, hoveredPixel.y, 0, 1, 1, 1,
+			GL_RGBA_INTEGER, GL_UNSIGNED_INT, sizeof(hovered), reinterpret_cast<void*>(HISTOGRAM_BYTES));
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	head = (head + 1) % slots.size();
+
+	// Frames finish in order, so checking stops at the first one still running
+	for (size_t k = 0; k < slots.size(); k++) {
+		Slot& done = slots[(head + k) % slots.size()];
+		if (done.fence == nullptr)
+			continue;
+
+		GLenum status = glClientWaitSync(done.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		glDeleteSync(done.fence);
+		done.fence = nullptr;
+		collect(done);
+	}
+}
+
+void HeatMap::collect(Slot& slot) {
+	std::array<uint32_t, NUM_BINS + 1> data;
+	glGetNamedBufferSubData(slot.bufferID, 0, HISTOGRAM_BYTES, data.data());
+
+	// Mean is estimated from the histogram, as a per pixel sum would easily overflow
+	double total = 0.0, sum = 0.0;
+	const float scale = std::max(maxValue, 1.0f) / NUM_BINS;
+	for (uint32_t k = 0; k < NUM_BINS; k++) {
+		bins[k] = float(data[k]);
+		total += data[k];
+		sum += data[k] * (k + 0.5) * scale;
+	}
+
+	frameMax = data[NUM_BINS];
+	frameMean = total > 0.0 ? sum / total : 0.0;
+
+	if (autoScale)
+		maxValue = std::max(1.0f, float(frameMax));
+
+	isHovered = slot.hovered;
+	if (isHovered)
+		glGetNamedBufferSubData(slot.bufferID, HISTOGRAM_BYTES, sizeof(hovered), &hovered[0]);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+std::string HeatMap::instrument(const std::string& src, const std::string& march, const std::string& dist) {
+	struct Edit {
+		size_t pos, erase;
+		std::string text;
+	};
+
+	const std::string clean = glsl::stripComments(src);
+
+	std::vector<Edit> edits;
+	size_t firstDefinition = std::string::npos;
+
+	// Wraps a single statement starting at 'pos' into a block beginning with 'text'
+	auto wrapStatement = [&](size_t pos, const std::string& text) -> void {
+		int32_t depth = 0;
+		for (size_t k = pos; k < clean.size(); k++) {
+			char ch = clean[k];
+			depth += (ch == '(' || ch == '{') ? 1 : (ch == ')' || ch == '}') ? -1 : 0;
+			if (ch == ';' && depth == 0) {
+				edits.push_back({ pos, 0, "{ " + text });
+				edits.push_back({ k + 1, 0, " }" });
+				return;
+			}
+		}
+	};
+
+	for (const glsl::Function& fn : glsl::findFunctions(clean)) {
+		if (fn.prototype)
+			continue;
+
+		firstDefinition = std::min(firstDefinition, fn.begin);
+
+		if (fn.name == "main") {
+			size_t pos = clean.find("main", fn.begin);
+			edits.push_back({ pos, 4, "gsMain" });
+		}
+
+		if (fn.name == dist)
+			edits.push_back({ fn.bodyBegin + 1, 0, " gsCalls++;" });
+
+		if (fn.name != march)
+			continue;
+
+		// Counting loop iterations and breaks out of them
+		for (size_t k = fn.bodyBegin + 1; k + 1 < fn.end; k++) {
+			if (!glsl::isIdentifierChar(clean[k]) || glsl::isIdentifierChar(clean[k - 1]))
+				continue;
+
+			size_t end = k;
+			while (glsl::isIdentifierChar(clean[end]))
+				end++;
+
+			const std::string word = clean.substr(k, end - k);
+			size_t next = clean.find_first_not_of(" \t\r\n", end);
+
+			if ((word == "for" || word == "while") && clean[next] == '(') {
+				size_t close = glsl::matchBracket(clean, next);
+				size_t body = clean.find_first_not_of(" \t\r\n", close + 1);
+
+				if (clean[body] == '{')
+					edits.push_back({ body + 1, 0, " gsSteps++;" });
+				else if (clean[body] != ';') // ';' closes a do-while loop
+					wrapStatement(body, "gsSteps++; ");
+
+				end = close + 1;
+			}
+			else if (word == "do" && clean[next] == '{') {
+				edits.push_back({ next + 1, 0, " gsSteps++;" });
+			}
+			else if (word == "break") {
+				wrapStatement(k, "gsExits++; ");
+			}
+
+			k = end - 1;
+		}
+	}
+
+	if (firstDefinition == std::string::npos)
+		return src;
+
+	// Declared on the same line as first function, so no line is shifted
+	edits.push_back({ firstDefinition, 0, "uint gsSteps = 0u; uint gsCalls = 0u; uint gsExits = 0u; " });
+
+	std::string out = src;
+	std::stable_sort(edits.begin(), edits.end(), [](const Edit& a, const Edit& b) { return a.pos > b.pos; });
+	for (const Edit& edit : edits)
+		out.replace(edit.pos, edit.erase, edit.text);
+
+	// Output variable used by the shader
+	std::smatch match;
+	static const std::regex rgxOut(R"(\bout\s+vec4\s+(\w+)\s*;)");
+	const std::string color = std::regex_search(clean, match, rgxOut) ? match[1].str() : "fragColor";
+
+	out += "\n"
+		"layout(rgba32ui, binding = " + std::to_string(COUNTS_UNIT) + ") uniform writeonly uimage2D gsCounts;\n"
+		"layout(std430, binding = " + std::to_string(HISTOGRAM_BINDING) + ") buffer GSHistogram { uint gsHistogram[]; };\n"
+		"uniform int gsHeatMode;\n"
+		"uniform float gsHeatMax;\n"
+		"uniform float gsHeatBlend;\n"
+		"vec3 gsPalette(float t) {\n"
+		"    t = clamp(t, 0.0, 1.0);\n"
+		"    return clamp(vec3(1.5) - abs(4.0 * vec3(t) - vec3(3.0, 2.0, 1.0)), 0.0, 1.0);\n"
+		"}\n"
+		"void main() {\n"
+		"    gsMain();\n"
+		"    uvec4 counts = uvec4(gsSteps, gsCalls, gsExits, 0u);\n"
+		"    imageStore(gsCounts, ivec2(gl_FragCoord.xy), counts);\n"
+		"    uint value = counts[gsHeatMode];\n"
+		"    uint bin = min(uint(float(value) / gsHeatMax * " + std::to_string(NUM_BINS) + ".0), " + std::to_string(NUM_BINS - 1) + "u);\n"
+		"    atomicAdd(gsHistogram[bin], 1u);\n"
+		"    atomicMax(gsHistogram[" + std::to_string(NUM_BINS) + "], value);\n"
+		"    vec3 heat = gsPalette(float(value) / gsHeatMax);\n"
+		"    " + color + " = vec4(mix(" + color + ".rgb, heat, gsHeatBlend), 1.0);\n"
+		"}\n";
+
+	return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void HeatMap::showHeatMap(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Heat map", &active);
+	ImGui::SetWindowSize({ 450.0f, 400.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	if (ImGui::Checkbox("Enabled", &enabled))
+		toggled = true;
+
+	ImGui::Text("Ray marcher:");
+	ImGui::SameLine(0.35f * width);
+	ImGui::SetNextItemWidth(0.6f * width);
+	toggled |= ImGui::InputText("##march", marchName, sizeof(marchName), ImGuiInputTextFlags_EnterReturnsTrue);
+
+	ImGui::Text("Distance function:");
+	ImGui::SameLine(0.35f * width);
+	ImGui::SetNextItemWidth(0.6f * width);
+	toggled |= ImGui::InputText("##dist", distName, sizeof(distName), ImGuiInputTextFlags_EnterReturnsTrue);
+
+	int32_t value = static_cast<int32_t>(mode);
+	ImGui::RadioButton("Steps", &value, 0);
+	ImGui::SameLine();
+	ImGui::RadioButton("Distance calls", &value, 1);
+	ImGui::SameLine();
+	ImGui::RadioButton("Early exits", &value, 2);
+	mode = static_cast<Mode>(value);
+
+	ImGui::Checkbox("Auto scale", &autoScale);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(0.4f * width);
+	ImGui::DragFloat("Max", &maxValue, 1.0f, 1.0f, 1e6f, "%.0f");
+
+	ImGui::SetNextItemWidth(0.6f * width);
+	ImGui::SliderFloat("Blend", &blend, 0.0f, 1.0f);
+
+	if (isEnabled()) {
+		ImGui::Separator();
+		ImGui::Text("Mean: %.1f   Max: %u", frameMean, frameMax);
+		ImGui::PlotHistogram("##histogram", bins.data(), int(NUM_BINS), 0, nullptr, 0.0f, FLT_MAX, { width, 100.0f });
+
+		if (isHovered)
+			ImGui::Text("Pixel: %u steps, %u calls, %u exits", hovered.x, hovered.y, hovered.z);
+	}
+	else if (enabled) {
+		ImGui::TextColored({ 1.0f, 0.4f, 0.4f, 1.0f }, "Instrumented shader failed to compile");
+	}
+
+	ImGui::End();
+}
+
+bool HeatMap::wasToggled(void) {
+	bool value = toggled;
+	toggled = false;
+	return value;
+}
+
+void HeatMap::open(void) {
+	active = true;
+}
+
+void HeatMap::close(void) {
+	active = false;
+}
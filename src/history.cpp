@@ -0,0 +1,255 @@
+#include "history.h"
+#include "frameCodec.h"
+#include "profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+
+History::History(void) : shared(std::make_shared<Shared>()), pool(std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u)) {}
+
+History::~History(void) {
+	glDeleteTextures(1, &texture);
+}
+
+void History::capture(float time, const glm::uvec2& size) {
+	if (!enabled || displaying || size.x == 0 || size.y == 0)
+		return;
+
+	if (readback.capture(size.x, size.y))
+		inFlight.push_back(time);
+}
+
+void History::update(void) {
+	if (!enabled)
+		return;
+
+	GSHADER_PROFILE_FUNCTION();
+	std::vector<uint8_t> rgb;
+	glm::uvec2 size;
+	while (!inFlight.empty() && readback.fetch(rgb, size)) {
+		const float time = inFlight.front();
+		inFlight.erase(inFlight.begin());
+
+		// Frames are dropped while workers are behind, so raw copies can't pile up
+		if (pool.pending() >= 2 * pool.size())
+			continue;
+
+		uint32_t generation = 0;
+		{
+			std::lock_guard<std::mutex> lock(shared->mtx);
+			generation = shared->generation;
+		}
+
+		std::shared_ptr<Shared> state = shared;
+		pool.submit([state, generation, time, size, raw = std::move(rgb)](void) {
+			auto data = std::make_shared<std::vector<uint8_t>>();
+			codec::compress(raw.data(), raw.size(), 3, *data);
+			data->shrink_to_fit();
+
+			std::lock_guard<std::mutex> lock(state->mtx);
+			if (generation == state->generation)
+				state->compressed.push_back({ time, size, std::move(data) });
+		});
+		rgb = std::vector<uint8_t>();
+	}
+
+	std::vector<Frame> arrived;
+	bool decoded = false;
+	{
+		std::lock_guard<std::mutex> lock(shared->mtx);
+		arrived.swap(shared->compressed);
+
+		if (shared->decoded) {
+			shared->decoded = false;
+			decoded = true;
+			size = shared->size;
+			rgb.swap(shared->rgb);
+		}
+	}
+
+	for (Frame& frame : arrived) {
+		usedBytes += frame.data->size();
+		rawBytes += size_t(3) * frame.size.x * frame.size.y;
+		frames.push_back(std::move(frame));
+	}
+
+	const size_t limit = size_t(budget) << 20;
+	while (usedBytes > limit && !frames.empty()) {
+		usedBytes -= frames.front().data->size();
+		rawBytes -= size_t(3) * frames.front().size.x * frames.front().size.y;
+		frames.pop_front();
+	}
+
+	if (decoded && rgb.empty()) {
+		decoding = displaying = false;
+		shownTime = -1.0f;
+	}
+	else if (decoded) {
+		decoding = false;
+		if (texSize != size) {
+			glDeleteTextures(1, &texture);
+			glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+			glTextureStorage2D(texture, 1, GL_RGB8, size.x, size.y);
+			glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			texSize = size;
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTextureSubImage2D(texture, 0, 0, 0, size.x, size.y, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+}
+
+bool History::isBusy(void) {
+	return enabled && (decoding || !inFlight.empty());
+}
+
+bool History::scrubRequested(float& time) {
+	if (!requested)
+		return false;
+
+	requested = false;
+	time = target;
+	return true;
+}
+
+const History::Frame* History::closest(float time) const {
+	if (frames.empty())
+		return nullptr;
+
+	// Close enough means within half the average spacing of stored frames
+	float low = frames.front().time, high = low;
+	const Frame* best = &frames.front();
+	for (const Frame& frame : frames) {
+		low = std::min(low, frame.time);
+		high = std::max(high, frame.time);
+		if (std::abs(frame.time - time) < std::abs(best->time - time))
+			best = &frame;
+	}
+
+	const float tolerance = std::max(0.5f * (high - low) / float(std::max<size_t>(frames.size() - 1, 1)), 1e-3f);
+	return std::abs(best->time - time) <= tolerance ? best : nullptr;
+}
+
+bool History::display(float time) {
+	const Frame* frame = closest(time);
+	if (frame == nullptr)
+		return false;
+
+	displaying = true;
+	if (frame->time == shownTime)
+		return true;
+
+	// Decoded on a worker; view keeps its current image until the frame is uploaded
+	shownTime = frame->time;
+	decoding = true;
+
+	uint32_t ticket = 0;
+	{
+		std::lock_guard<std::mutex> lock(shared->mtx);
+		ticket = ++shared->ticket;
+	}
+
+	std::shared_ptr<Shared> state = shared;
+	pool.submit([state, ticket, size = frame->size, data = frame->data](void) {
+		// Corrupt frames come back empty, so the view goes live again
+		std::vector<uint8_t> rgb;
+		if (!codec::decompress(*data, size_t(3) * size.x * size.y, 3, rgb))
+			rgb.clear();
+
+		std::lock_guard<std::mutex> lock(state->mtx);
+		if (ticket == state->ticket) {
+			state->decoded = true;
+			state->size = size;
+			state->rgb = std::move(rgb);
+		}
+	});
+
+	return true;
+}
+
+void History::resume(void) {
+	displaying = false;
+}
+
+void History::clear(void) {
+	{
+		std::lock_guard<std::mutex> lock(shared->mtx);
+		shared->generation++;
+		shared->compressed.clear();
+	}
+
+	readback.clear();
+	inFlight.clear();
+	frames.clear();
+	usedBytes = rawBytes = 0;
+	displaying = false;
+	shownTime = -1.0f;
+}
+
+bool History::setScene(uint64_t key) {
+	if (key == scene)
+		return false;
+
+	scene = key;
+	clear();
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void History::showHistory(float currentTime) {
+	if (!active)
+		return;
+
+	ImGui::Begin("Frame history", &active);
+
+	if (ImGui::Checkbox("Keep frames", &enabled) && !enabled)
+		clear();
+
+	ImGui::SliderInt("Memory (MB)", &budget, 16, 8192);
+
+	const float ratio = rawBytes > 0 ? float(usedBytes) / float(rawBytes) : 0.0f;
+	ImGui::Text("Frames: %zu, %.1f MB, %.0f%% of raw size", frames.size(), float(usedBytes) / 1048576.0f, 100.0f * ratio);
+
+	if (frames.empty()) {
+		ImGui::TextDisabled("No frames stored yet");
+		ImGui::End();
+		return;
+	}
+
+	float low = frames.front().time, high = low;
+	for (const Frame& frame : frames) {
+		low = std::min(low, frame.time);
+		high = std::max(high, frame.time);
+	}
+
+	// Dragging pauses playback; times without a stored frame are drawn again
+	float time = displaying ? shownTime : std::clamp(currentTime, low, high);
+	ImGui::SetNextItemWidth(-1.0f);
+	if (ImGui::SliderFloat("##scrub", &time, low, high, "iTime = %.3f")) {
+		requested = true;
+		target = time;
+	}
+
+	if (displaying) {
+		ImGui::TextColored({ 0.3f, 0.8f, 1.0f, 1.0f }, "Showing stored frame at %.3f s", shownTime);
+		ImGui::SameLine();
+		if (ImGui::Button("Live"))
+			resume();
+	}
+
+	ImGui::End();
+}
+
+void History::open(void) {
+	active = true;
+}
+
+void History::close(void) {
+	active = false;
+}
@@ -0,0 +1,218 @@
+#include "imageReader.h"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef GSHADER_PNG
+#include <png.h>
+#endif
+
+#ifdef GSHADER_JPEG
+#include <cstdio>
+#include <csetjmp>
+#include <jpeglib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Decoders produce rows from top to bottom
+static void flipRows(Image& image) {
+    const size_t rowSize = size_t(image.width) * image.channels;
+    std::vector<uint8_t> row(rowSize);
+    for (uint32_t k = 0; k < image.height / 2; k++) {
+        uint8_t* top = image.pixels.data() + k * rowSize;
+        uint8_t* bottom = image.pixels.data() + (image.height - 1 - k) * rowSize;
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Binary PPM and PGM
+
+static bool decodePNM(const std::vector<uint8_t>& bytes, Image& image, std::string& error) {
+    size_t pos = 2;
+    auto readNumber = [&](uint32_t& value) -> bool {
+        // Spaces and comments may separate header fields
+        while (pos < bytes.size() && (std::isspace(bytes[pos]) || bytes[pos] == '#')) {
+            if (bytes[pos] == '#') {
+                while (pos < bytes.size() && bytes[pos] != '\n')
+                    pos++;
+            }
+            else {
+                pos++;
+            }
+        }
+
+        if (pos >= bytes.size() || !std::isdigit(bytes[pos]))
+            return false;
+
+        value = 0;
+        while (pos < bytes.size() && std::isdigit(bytes[pos]))
+            value = 10 * value + (bytes[pos++] - '0');
+        return true;
+    };
+
+    uint32_t maxVal = 0;
+    if (!readNumber(image.width) || !readNumber(image.height) || !readNumber(maxVal)) {
+        error = "Corrupted header";
+        return false;
+    }
+
+    if (maxVal != 255) {
+        error = "Only 8 bit images are supported";
+        return false;
+    }
+
+    pos++; // single space before pixel data
+
+    image.channels = bytes[1] == '6' ? 3 : 1;
+    const size_t size = size_t(image.width) * image.height * image.channels;
+    if (pos + size > bytes.size()) {
+        error = "Truncated pixel data";
+        return false;
+    }
+
+    image.pixels.assign(bytes.begin() + pos, bytes.begin() + pos + size);
+    flipRows(image);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// PNG
+
+#ifdef GSHADER_PNG
+static bool decodePNG(const std::vector<uint8_t>& bytes, Image& image, std::string& error) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+
+    if (!png_image_begin_read_from_memory(&png, bytes.data(), bytes.size())) {
+        error = png.message;
+        return false;
+    }
+
+    // Everything is brought to 8 bits, keeping alpha only if present
+    const bool gray = (png.format & PNG_FORMAT_FLAG_COLOR) == 0;
+    const bool alpha = (png.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+    png.format = alpha ? PNG_FORMAT_RGBA : (gray ? PNG_FORMAT_GRAY : PNG_FORMAT_RGB);
+
+    image.width = png.width;
+    image.height = png.height;
+    image.channels = PNG_IMAGE_SAMPLE_CHANNELS(png.format);
+    image.pixels.resize(PNG_IMAGE_SIZE(png));
+
+    // Negative stride stores the last row first
+    const png_int_32 stride = -png_int_32(PNG_IMAGE_ROW_STRIDE(png));
+    if (!png_image_finish_read(&png, nullptr, image.pixels.data(), stride, nullptr)) {
+        error = png.message;
+        png_image_free(&png);
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// JPEG
+
+#ifdef GSHADER_JPEG
+namespace {
+
+struct JpegError {
+    jpeg_error_mgr manager;
+    std::jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+void onJpegError(j_common_ptr info) {
+    JpegError* err = reinterpret_cast<JpegError*>(info->err);
+    (*info->err->format_message)(info, err->message);
+    std::longjmp(err->jump, 1);
+}
+
+} // namespace
+
+static bool decodeJPEG(const std::vector<uint8_t>& bytes, Image& image, std::string& error) {
+    jpeg_decompress_struct info;
+    JpegError err;
+    info.err = jpeg_std_error(&err.manager);
+    err.manager.error_exit = onJpegError;
+
+    if (setjmp(err.jump)) {
+        error = err.message;
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, bytes.data(), static_cast<unsigned long>(bytes.size()));
+    jpeg_read_header(&info, TRUE);
+
+    info.out_color_space = info.num_components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_start_decompress(&info);
+
+    image.width = info.output_width;
+    image.height = info.output_height;
+    image.channels = info.output_components;
+    image.pixels.resize(size_t(image.width) * image.height * image.channels);
+
+    const size_t rowSize = size_t(image.width) * image.channels;
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = image.pixels.data() + (image.height - 1 - info.output_scanline) * rowSize;
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+bool ImageReader::decode(const std::vector<uint8_t>& bytes, Image& image, std::string& error) {
+    image = Image();
+
+    if (bytes.size() >= 2 && bytes[0] == 'P' && (bytes[1] == '5' || bytes[1] == '6'))
+        return decodePNM(bytes, image, error);
+
+    if (bytes.size() >= 8 && std::memcmp(bytes.data(), "\x89PNG\r\n\x1a\n", 8) == 0) {
+#ifdef GSHADER_PNG
+        return decodePNG(bytes, image, error);
+#else
+        error = "PNG support requires building with -DGSHADER_PNG=ON";
+        return false;
+#endif
+    }
+
+    if (bytes.size() >= 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF) {
+#ifdef GSHADER_JPEG
+        return decodeJPEG(bytes, image, error);
+#else
+        error = "JPEG support requires building with -DGSHADER_JPEG=ON";
+        return false;
+#endif
+    }
+
+    error = "Unknown image format";
+    return false;
+}
+
+bool ImageReader::load(const fs::path& path, Image& image, std::string& error) {
+    std::vector<uint8_t> bytes = readFile(path);
+    if (bytes.empty()) {
+        error = "Cannot read '" + path.string() + "'";
+        return false;
+    }
+    return decode(bytes, image, error);
+}
+
+std::vector<uint8_t> ImageReader::readFile(const fs::path& path) {
+    std::ifstream arq(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(arq), std::istreambuf_iterator<char>());
+}
@@ -0,0 +1,56 @@
+#include "imageWriter.h"
+
+#include "GRender/mailbox.h"
+
+#include <algorithm>
+#include <string>
+
+namespace fs = std::filesystem;
+
+ImageWriter::~ImageWriter(void) {
+    if (arq.is_open())
+        arq.close();
+}
+
+bool ImageWriter::open(const fs::path& path, uint32_t width, uint32_t height) {
+    arq.open(path, std::ios::binary);
+    if (!arq.is_open()) {
+        GRender::mailbox::CreateError("Cannot write image: " + path.string());
+        return false;
+    }
+
+    this->width = width;
+    this->height = height;
+    rowsWritten = 0;
+
+    arq << "P6\n" << width << " " << height << "\n255\n";
+    return true;
+}
+
+bool ImageWriter::isOpen(void) const {
+    return arq.is_open();
+}
+
+void ImageWriter::writeRows(const uint8_t* rgb, uint32_t numRows) {
+    numRows = std::min(numRows, height - rowsWritten);
+    arq.write(reinterpret_cast<const char*>(rgb), std::streamsize(3) * width * numRows);
+    rowsWritten += numRows;
+}
+
+bool ImageWriter::close(void) {
+    bool complete = rowsWritten == height && arq.good();
+    arq.close();
+    return complete;
+}
+
+bool ImageWriter::save(const fs::path& path, uint32_t width, uint32_t height, const uint8_t* rgb) {
+    ImageWriter writer;
+    if (!writer.open(path, width, height))
+        return false;
+
+    // OpenGL images start at the bottom row
+    for (uint32_t k = 0; k < height; k++)
+        writer.writeRows(rgb + size_t(3) * width * (height - k - 1), 1);
+
+    return writer.close();
+}
@@ -0,0 +1,113 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+namespace fs = std::filesystem;
+
+MappedFile::MappedFile(const fs::path& path) {
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+
+    file = hFile;
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(hFile, &length) || length.QuadPart == 0) {
+        release();
+        return;
+    }
+
+    mapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        release();
+        return;
+    }
+
+    data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    size = data ? size_t(length.QuadPart) : 0;
+    if (!data)
+        release();
+#else
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    // Empty files cannot be mapped
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        release();
+        return;
+    }
+
+    void* ptr = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        release();
+        return;
+    }
+
+    // Data is streamed front to back, so read-ahead pays off
+    madvise(ptr, size_t(info.st_size), MADV_SEQUENTIAL);
+
+    data = static_cast<const uint8_t*>(ptr);
+    size = size_t(info.st_size);
+#endif
+}
+
+MappedFile::~MappedFile(void) {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept {
+    std::swap(data, rhs.data);
+    std::swap(size, rhs.size);
+#ifdef _WIN32
+    std::swap(file, rhs.file);
+    std::swap(mapping, rhs.mapping);
+#else
+    std::swap(fd, rhs.fd);
+#endif
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept {
+    if (&rhs != this) {
+        release();
+        new(this) MappedFile(std::move(rhs));
+    }
+    return *this;
+}
+
+void MappedFile::release(void) {
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file)
+        CloseHandle(file);
+
+    file = mapping = nullptr;
+#else
+    if (data)
+        munmap(const_cast<uint8_t*>(data), size);
+    if (fd >= 0)
+        close(fd);
+
+    fd = -1;
+#endif
+
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,163 @@
+#include "poster.h"
+#include "profiler.h"
+
+#include "GRender/mailbox.h"
+
+#include "imgui.h"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+void Poster::showPoster(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Poster", &active);
+	ImGui::SetWindowSize({ 400.0f, 170.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	if (rendering) {
+		uint32_t done = current.y * numTiles.x + current.x;
+		float progress = float(done) / float(numTiles.x * numTiles.y);
+		ImGui::ProgressBar(progress, { 0.75f * width, 0.0f });
+		ImGui::SameLine();
+		if (ImGui::Button("Cancel")) {
+			cancel();
+		}
+
+		ImGui::End();
+		return;
+	}
+
+	uint32_t minVal = 16, maxVal = 1 << 17;
+	ImGui::Text("Resolution:");
+	ImGui::SameLine(0.35f * width);
+	ImGui::SetNextItemWidth(0.6f * width);
+	ImGui::DragScalarN("##resolution", ImGuiDataType_U32, glm::value_ptr(resolution), 2, 16.0f, &minVal, &maxVal);
+
+	// Tiles are limited by the largest texture the GPU is able to render into, and by the viewport
+	GLint maxSize = 0, maxViewport[2] = { 0, 0 };
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+	uint32_t maxTile = std::min<uint32_t>({ uint32_t(maxSize), uint32_t(maxViewport[0]), uint32_t(maxViewport[1]), 8192 });
+	ImGui::Text("Tile size:");
+	ImGui::SameLine(0.35f * width);
+	ImGui::SetNextItemWidth(0.6f * width);
+	ImGui::DragScalarN("##tileSize", ImGuiDataType_U32, glm::value_ptr(tileSize), 2, 16.0f, &minVal, &maxTile);
+
+	ImGui::Text("Tiles per frame:");
+	ImGui::SameLine(0.35f * width);
+	ImGui::SetNextItemWidth(0.6f * width);
+	ImGui::SliderInt("##tilesPerFrame", &tilesPerFrame, 1, 16);
+
+	if (ImGui::Button("Render...")) {
+		startOn = true;
+	}
+
+	ImGui::End();
+}
+
+bool Poster::requested(void) {
+	bool value = startOn;
+	startOn = false;
+	return value;
+}
+
+bool Poster::start(const fs::path& path, float time) {
+	fs::path output = path;
+	if (output.extension() != ".ppm")
+		output += ".ppm";
+
+	if (!writer.open(output, resolution.x, resolution.y))
+		return false;
+
+	this->time = time;
+	numTiles = (resolution + tileSize - 1u) / tileSize;
+	current = { 0, 0 };
+
+	tile = RenderTarget(tileSize.x, tileSize.y);
+	band.resize(size_t(3) * resolution.x * tileSize.y);
+	pixels.resize(size_t(3) * tileSize.x * tileSize.y);
+
+	rendering = true;
+	return true;
+}
+
+void Poster::cancel(void) {
+	rendering = false;
+	writer.close();
+
+	// Releasing memory
+	tile = RenderTarget();
+	band = std::vector<uint8_t>();
+	pixels = std::vector<uint8_t>();
+}
+
+bool Poster::isRendering(void) const {
+	return rendering;
+}
+
+glm::ivec2 Poster::beginTile(void) {
+	tile.bind();
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	// OpenGL counts rows from the bottom, but we stream the image from the top.
+	// Last row of tiles might be partially below the image, which is simply not read.
+	int32_t x = current.x * tileSize.x;
+	int32_t y = int32_t(resolution.y) - int32_t((current.y + 1) * tileSize.y);
+	return { x, y };
+}
+
+void Poster::endTile(void) {
+	GSHADER_PROFILE_FUNCTION();
+	const glm::ivec2 offset = {
+		current.x * tileSize.x,
+		int32_t(resolution.y) - int32_t((current.y + 1) * tileSize.y)
+	};
+
+	// Region of the tile that is actually inside the image
+	int32_t y0 = std::max(0, -offset.y);
+	uint32_t cols = std::min(tileSize.x, resolution.x - offset.x);
+	uint32_t rows = tileSize.y - y0;
+
+	tile.readRGB(0, y0, cols, rows, pixels.data());
+	tile.unbind();
+
+	// Copying into band, flipping rows so they go from top to bottom
+	for (uint32_t k = 0; k < rows; k++) {
+		const uint8_t* src = pixels.data() + size_t(3) * cols * k;
+		uint8_t* dst = band.data() + size_t(3) * (size_t(resolution.x) * (rows - k - 1) + offset.x);
+		std::memcpy(dst, src, size_t(3) * cols);
+	}
+
+	current.x++;
+	if (current.x < numTiles.x)
+		return;
+
+	// Row of tiles is complete
+	writer.writeRows(band.data(), rows);
+	current.x = 0;
+	current.y++;
+
+	if (current.y == numTiles.y) {
+		if (writer.close())
+			GRender::mailbox::CreateInfo("Poster saved!");
+		else
+			GRender::mailbox::CreateError("Poster could not be completely written!");
+
+		cancel();
+	}
+}
+
+void Poster::open(void) {
+	active = true;
+}
+
+void Poster::close(void) {
+	active = false;
+}
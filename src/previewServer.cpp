@@ -0,0 +1,417 @@
+#include "previewServer.h"
+
+#include "GRender/mailbox.h"
+
+#include "imgui.h"
+
+#include <chrono>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <jpeglib.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define closeSocket closesocket
+static constexpr int sendFlags = 0;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define closeSocket ::close
+static constexpr int sendFlags = MSG_NOSIGNAL;
+#endif
+
+struct PreviewServer::Client {
+	Socket sock = -1;
+	std::thread th;
+	std::atomic<bool> done{ false };
+};
+
+static bool sendAll(intptr_t sock, const char* data, size_t size) {
+	while (size > 0) {
+		int sent = ::send(static_cast<int>(sock), data, static_cast<int>(size), sendFlags);
+		if (sent <= 0)
+			return false;
+
+		data += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+static bool sendAll(intptr_t sock, const std::string& msg) {
+	return sendAll(sock, msg.data(), msg.size());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+PreviewServer::PreviewServer(void) {
+#ifdef _WIN32
+	WSADATA wsa;
+	WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+}
+
+PreviewServer::~PreviewServer(void) {
+	stop();
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+bool PreviewServer::start(uint16_t port) {
+	if (running)
+		return true;
+
+	Socket sock = static_cast<Socket>(::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+	if (sock < 0) {
+		GRender::mailbox::CreateError("Preview server: cannot create socket");
+		return false;
+	}
+
+	int yes = 1;
+	setsockopt(static_cast<int>(sock), SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+
+	// Only reachable from this machine
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (::bind(static_cast<int>(sock), reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(static_cast<int>(sock), 8) != 0) {
+		closeSocket(static_cast<int>(sock));
+		GRender::mailbox::CreateError("Preview server: cannot listen on port " + std::to_string(port));
+		return false;
+	}
+
+	listener = sock;
+	this->port = port;
+
+	// Encoding is only useful for a couple of frames in flight
+	uint32_t numThreads = std::min(std::max(std::thread::hardware_concurrency() / 2, 1u), 4u);
+	encoders = std::make_unique<ThreadPool>(numThreads);
+
+	running = true;
+	acceptThread = std::thread(&PreviewServer::acceptLoop, this);
+	return true;
+}
+
+void PreviewServer::stop(void) {
+	if (!running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		running = false;
+	}
+	cvFrame.notify_all();
+	acceptThread.join();
+
+	closeSocket(static_cast<int>(listener));
+	listener = -1;
+
+	// Unblocking clients stuck in 'send'
+	std::lock_guard<std::mutex> lock(mtxClients);
+	for (auto& client : clients) {
+		::shutdown(static_cast<int>(client->sock), 2);
+		client->th.join();
+		closeSocket(static_cast<int>(client->sock));
+	}
+	clients.clear();
+	numClients = 0;
+
+	encoders.reset();
+
+	std::lock_guard<std::mutex> lockFrame(mtx);
+	latest.reset();
+}
+
+bool PreviewServer::isRunning(void) const {
+	return running;
+}
+
+bool PreviewServer::wantsFrames(void) const {
+	return running && numClients > 0;
+}
+
+void PreviewServer::publish(std::vector<uint8_t>&& rgb, const glm::uvec2& size) {
+	if (!wantsFrames())
+		return;
+
+	// All encoders are busy, so this frame would only arrive late
+	if (encoders->pending() >= encoders->size()) {
+		numDropped++;
+		return;
+	}
+
+	uint64_t id = ++publishID;
+	auto pixels = std::make_shared<std::vector<uint8_t>>(std::move(rgb));
+
+	encoders->submit([this, id, pixels, size](void) -> void {
+		auto jpeg = std::make_shared<std::vector<uint8_t>>();
+		if (!encodeJPEG(*pixels, size, quality, *jpeg))
+			return;
+
+		numEncoded++;
+
+		std::lock_guard<std::mutex> lock(mtx);
+		if (id > latestID) { // encoders might finish out of order
+			latestID = id;
+			latest = std::move(jpeg);
+		}
+		cvFrame.notify_all();
+	});
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void PreviewServer::acceptLoop(void) {
+	while (running) {
+		// Waking up regularly to check if server was stopped
+		fd_set set;
+		FD_ZERO(&set);
+		FD_SET(static_cast<int>(listener), &set);
+		timeval timeout = { 0, 200000 };
+
+		int ready = ::select(static_cast<int>(listener) + 1, &set, nullptr, nullptr, &timeout);
+
+		std::lock_guard<std::mutex> lock(mtxClients);
+
+		// Removing clients that already disconnected
+		for (auto it = clients.begin(); it != clients.end();) {
+			if ((*it)->done) {
+				(*it)->th.join();
+				closeSocket(static_cast<int>((*it)->sock));
+				it = clients.erase(it);
+			}
+			else {
+				it++;
+			}
+		}
+
+		if (ready <= 0)
+			continue;
+
+		Socket sock = static_cast<Socket>(::accept(static_cast<int>(listener), nullptr, nullptr));
+		if (sock < 0)
+			continue;
+
+		auto client = std::make_shared<Client>();
+		client->sock = sock;
+		client->th = std::thread(&PreviewServer::serveClient, this, client);
+		clients.push_back(client);
+	}
+}
+
+PreviewServer::Wait PreviewServer::waitFrame(uint64_t& lastID, Frame& frame) {
+	std::unique_lock<std::mutex> lock(mtx);
+	bool fresh = cvFrame.wait_for(lock, std::chrono::milliseconds(WAIT_MS), [&] { return !running || (latest && latestID != lastID); });
+	if (!running)
+		return Wait::STOPPED;
+
+	// Nothing is drawn while paused, so the last frame is handed again
+	if (!fresh) {
+		frame = latest;
+		return Wait::TIMEOUT;
+	}
+
+	// Every frame published in between is dropped for this client
+	if (lastID > 0 && latestID > lastID + 1)
+		numDropped += latestID - lastID - 1;
+
+	lastID = latestID;
+	frame = latest;
+	return Wait::FRAME;
+}
+
+void PreviewServer::serveClient(std::shared_ptr<Client> client) {
+	const Socket sock = client->sock;
+
+	// Reading request header
+	std::string request;
+	char buffer[1024];
+	while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+		int len = ::recv(static_cast<int>(sock), buffer, sizeof(buffer), 0);
+		if (len <= 0) {
+			client->done = true;
+			return;
+		}
+		request.append(buffer, len);
+	}
+
+	std::string path;
+	if (request.rfind("GET ", 0) == 0) {
+		size_t end = request.find(' ', 4);
+		path = request.substr(4, end - 4);
+	}
+
+	if (path == "/") {
+		const std::string page =
+			"<!DOCTYPE html><html><head><title>GShader</title></head>"
+			"<body style=\"margin:0;background:#000\">"
+			"<img src=\"/stream\" style=\"width:100vw;height:100vh;object-fit:contain\">"
+			"</body></html>";
+
+		sendAll(sock, "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\nContent-Length: "
+			+ std::to_string(page.size()) + "\r\n\r\n" + page);
+	}
+	else if (path == "/stream" || path == "/frame.jpg") {
+		numClients++;
+
+		bool single = path == "/frame.jpg";
+		bool started = false;
+
+		uint64_t lastID = 0;
+		Frame frame;
+		for (Wait wait = waitFrame(lastID, frame); wait != Wait::STOPPED; wait = waitFrame(lastID, frame)) {
+			if (frame == nullptr) {
+				// Paused before anything was drawn, client can retry later
+				sendAll(sock, "HTTP/1.0 503 Service Unavailable\r\nRetry-After: 1\r\nContent-Length: 0\r\n\r\n");
+				break;
+			}
+
+			if (!single && !started) {
+				started = sendAll(sock, "HTTP/1.0 200 OK\r\n"
+					"Cache-Control: no-cache\r\n"
+					"Content-Type: multipart/x-mixed-replace; boundary=gshaderframe\r\n\r\n");
+				if (!started)
+					break;
+			}
+
+			std::string header;
+			if (single)
+				header = "HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+			else
+				header = "--gshaderframe\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+			header += std::to_string(frame->size()) + "\r\n\r\n";
+
+			bool ok = sendAll(sock, header)
+				&& sendAll(sock, reinterpret_cast<const char*>(frame->data()), frame->size())
+				&& (single || sendAll(sock, "\r\n"));
+
+			if (!ok || single)
+				break;
+		}
+
+		numClients--;
+	}
+	else {
+		sendAll(sock, "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+	}
+
+	client->done = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+struct JpegError {
+	jpeg_error_mgr mgr;
+	jmp_buf jump;
+};
+}
+
+bool PreviewServer::encodeJPEG(const std::vector<uint8_t>& rgb, const glm::uvec2& size, int32_t quality, std::vector<uint8_t>& jpeg) {
+	jpeg_compress_struct cinfo;
+	JpegError error;
+
+	// Default error handler would terminate the program
+	cinfo.err = jpeg_std_error(&error.mgr);
+	error.mgr.error_exit = [](j_common_ptr info) {
+		longjmp(reinterpret_cast<JpegError*>(info->err)->jump, 1);
+	};
+
+	unsigned char* buffer = nullptr;
+	unsigned long length = 0;
+
+	if (setjmp(error.jump)) {
+		jpeg_destroy_compress(&cinfo);
+		free(buffer);
+		return false;
+	}
+
+	jpeg_create_compress(&cinfo);
+	jpeg_mem_dest(&cinfo, &buffer, &length);
+
+	cinfo.image_width = size.x;
+	cinfo.image_height = size.y;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, quality, TRUE);
+	jpeg_start_compress(&cinfo, TRUE);
+
+	// OpenGL rows start at the bottom
+	const size_t stride = size_t(3) * size.x;
+	while (cinfo.next_scanline < cinfo.image_height) {
+		JSAMPROW row = const_cast<JSAMPROW>(rgb.data() + stride * (size.y - cinfo.next_scanline - 1));
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_compress(&cinfo);
+	jpeg.assign(buffer, buffer + length);
+
+	jpeg_destroy_compress(&cinfo);
+	free(buffer);
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void PreviewServer::showServer(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Preview server", &active);
+	ImGui::SetWindowSize({ 400.0f, 170.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	if (!running) {
+		ImGui::Text("Port:");
+		ImGui::SameLine(0.3f * width);
+		ImGui::SetNextItemWidth(0.65f * width);
+		ImGui::InputInt("##port", &port);
+		port = std::min(std::max(port, 1024), 65535);
+	}
+	else {
+		ImGui::Text("URL: http://127.0.0.1:%d/", port);
+		ImGui::Text("Clients: %u", numClients.load());
+		ImGui::Text("Frames encoded: %llu  dropped: %llu", (unsigned long long)numEncoded.load(), (unsigned long long)numDropped.load());
+	}
+
+	int32_t value = quality;
+	ImGui::Text("Quality:");
+	ImGui::SameLine(0.3f * width);
+	ImGui::SetNextItemWidth(0.65f * width);
+	if (ImGui::SliderInt("##quality", &value, 10, 100))
+		quality = value;
+
+	if (ImGui::Button(running ? "Stop" : "Start")) {
+		if (running)
+			stop();
+		else
+			start(static_cast<uint16_t>(port));
+	}
+
+	ImGui::End();
+}
+
+void PreviewServer::open(void) {
+	active = true;
+}
+
+void PreviewServer::close(void) {
+	active = false;
+}
@@ -0,0 +1,256 @@
+#include "profiler.h"
+
+#include "json.hpp"
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+Profiler::Scope::Scope(const char* name) : name(name), start(now()) {
+	local().depth++;
+}
+
+Profiler::Scope::~Scope(void) {
+	Ring& ring = local();
+	ring.depth--;
+	uint64_t end = now();
+	push(ring, { name, start, end, ring.depth });
+
+	if (ring.depth == 0)
+		ring.lastEnd = end;
+}
+
+void Profiler::frame(void) {
+	Ring& ring = local();
+	ring.name = "Main thread";
+
+	uint64_t time = now();
+
+	// Whatever happens between our last scope and next frame belongs to the framework
+	if (ring.frameEnd > 0 && ring.lastEnd > ring.frameEnd)
+		push(ring, { "GRender (swap, events)", ring.lastEnd, time, 0 });
+
+	ring.frameBegin = ring.frameEnd;
+	ring.frameEnd = time;
+}
+
+bool Profiler::enabled(void) {
+#ifdef GSHADER_PROFILING
+	return true;
+#else
+	return false;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+Profiler::Registry& Profiler::registry(void) {
+	static Registry reg;
+	return reg;
+}
+
+Profiler::Ring& Profiler::local(void) {
+	// Rings are shared with registry, so events outlive the thread that wrote them
+	thread_local std::shared_ptr<Ring> ring;
+	if (!ring) {
+		Registry& reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mtx);
+
+		ring = std::make_shared<Ring>();
+		ring->id = uint32_t(reg.rings.size());
+		ring->name = "Thread " + std::to_string(ring->id);
+		reg.rings.push_back(ring);
+	}
+	return *ring;
+}
+
+uint64_t Profiler::now(void) {
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::push(Ring& ring, const Event& event) {
+	uint64_t head = ring.head.load(std::memory_order_relaxed);
+	ring.events[head % CAPACITY] = event;
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+std::vector<Profiler::Event> Profiler::snapshot(const Ring& ring) {
+	uint64_t before = ring.head.load(std::memory_order_acquire);
+	uint64_t first = before > CAPACITY ? before - CAPACITY : 0;
+
+	std::vector<Event> out;
+	out.reserve(before - first);
+	for (uint64_t k = first; k < before; k++)
+		out.push_back(ring.events[k % CAPACITY]);
+
+	// Entries overwritten while copying are dropped
+	uint64_t after = ring.head.load(std::memory_order_acquire);
+	uint64_t valid = after > CAPACITY ? after - CAPACITY : 0;
+	if (valid > first)
+		out.erase(out.begin(), out.begin() + std::min<uint64_t>(valid - first, out.size()));
+
+	return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Profiler::showProfiler(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Profiler", &active);
+	ImGui::SetWindowSize({ 800.0f, 400.0f });
+
+	if (!enabled()) {
+		ImGui::TextWrapped("Profiling is disabled in this build. Configure with -DGSHADER_PROFILING=ON to enable it.");
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Checkbox("Pause", &paused);
+	ImGui::SameLine();
+	if (ImGui::Button("Export trace..."))
+		exportOn = true;
+
+	///////////////////////////////////////////////////////
+	// Collecting events during last complete frame
+
+	if (!paused) {
+		Registry& reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mtx);
+
+		frameBegin = frameEnd = 0;
+		for (auto& ring : reg.rings) {
+			if (ring->frameBegin > 0) {
+				frameBegin = ring->frameBegin;
+				frameEnd = ring->frameEnd;
+			}
+		}
+
+		lanes.clear();
+		maxDepth = 0;
+		for (auto& ring : reg.rings) {
+			std::vector<Event> events;
+			for (const Event& ev : snapshot(*ring)) {
+				if (ev.end > frameBegin && ev.start < frameEnd) {
+					events.push_back(ev);
+					maxDepth = std::max(maxDepth, ev.depth);
+				}
+			}
+
+			if (!events.empty())
+				lanes.emplace_back(ring->name, std::move(events));
+		}
+	}
+
+	if (frameEnd <= frameBegin) {
+		ImGui::Text("Waiting for frames...");
+		ImGui::End();
+		return;
+	}
+
+	const double duration = double(frameEnd - frameBegin);
+	ImGui::Text("Frame: %.3f ms", 1e-6 * duration);
+
+	///////////////////////////////////////////////////////
+	// Flame graph, one lane per thread and one row per depth
+
+	const float width = ImGui::GetContentRegionAvail().x;
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	ImDrawList* draw = ImGui::GetWindowDrawList();
+
+	for (size_t k = 0; k < lanes.size(); k++) {
+		const auto& [name, events] = lanes[k];
+		ImGui::Text("%s", name.c_str());
+
+		ImVec2 corner = ImGui::GetCursorScreenPos();
+		ImVec2 size = { width, (maxDepth + 1) * rowHeight };
+		ImGui::PushID(int32_t(k));
+		ImGui::InvisibleButton("##lane", size);
+		ImGui::PopID();
+
+		const bool hovered = ImGui::IsItemHovered();
+		const ImVec2 mouse = ImGui::GetMousePos();
+
+		for (const Event& ev : events) {
+			double t0 = std::max(0.0, double(ev.start) - double(frameBegin)) / duration;
+			double t1 = std::min(1.0, (double(ev.end) - double(frameBegin)) / duration);
+
+			ImVec2 p0 = { corner.x + float(t0) * width, corner.y + ev.depth * rowHeight };
+			ImVec2 p1 = { corner.x + float(t1) * width, p0.y + rowHeight - 1.0f };
+
+			// Color is stable for a given name
+			size_t hash = std::hash<std::string>()(ev.name);
+			ImU32 color = IM_COL32(80 + hash % 120, 80 + (hash >> 8) % 120, 80 + (hash >> 16) % 120, 255);
+
+			draw->AddRectFilled(p0, p1, color);
+			if (p1.x - p0.x > 30.0f) {
+				draw->PushClipRect(p0, p1, true);
+				draw->AddText({ p0.x + 2.0f, p0.y }, IM_COL32(255, 255, 255, 255), ev.name);
+				draw->PopClipRect();
+			}
+
+			if (hovered && mouse.x >= p0.x && mouse.x < p1.x && mouse.y >= p0.y && mouse.y < p1.y)
+				ImGui::SetTooltip("%s\n%.3f ms", ev.name, 1e-6 * double(ev.end - ev.start));
+		}
+	}
+
+	ImGui::End();
+}
+
+bool Profiler::exportRequested(void) {
+	bool value = exportOn;
+	exportOn = false;
+	return value;
+}
+
+bool Profiler::exportTrace(const fs::path& path) const {
+	using json = nlohmann::json;
+
+	json events = json::array();
+	uint64_t origin = UINT64_MAX;
+
+	std::vector<std::pair<uint32_t, std::vector<Event>>> data;
+	{
+		Registry& reg = registry();
+		std::lock_guard<std::mutex> lock(reg.mtx);
+
+		for (auto& ring : reg.rings) {
+			data.emplace_back(ring->id, snapshot(*ring));
+			for (const Event& ev : data.back().second)
+				origin = std::min(origin, ev.start);
+
+			events.push_back({ {"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", ring->id}, {"args", {{"name", ring->name}}} });
+		}
+	}
+
+	// Complete events, timestamps in microseconds
+	for (const auto& [tid, list] : data) {
+		for (const Event& ev : list) {
+			events.push_back({ {"name", ev.name}, {"ph", "X"}, {"pid", 1}, {"tid", tid},
+				{"ts", 1e-3 * double(ev.start - origin)}, {"dur", 1e-3 * double(ev.end - ev.start)} });
+		}
+	}
+
+	std::ofstream arq(path);
+	if (!arq)
+		return false;
+
+	arq << json{ {"traceEvents", events}, {"displayTimeUnit", "ms"} };
+	return true;
+}
+
+void Profiler::open(void) {
+	active = true;
+}
+
+void Profiler::close(void) {
+	active = false;
+}
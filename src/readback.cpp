@@ -0,0 +1,75 @@
+#include "readback.h"
+
+#include <cstring>
+
+Readback::~Readback(void) {
+    clear();
+    for (Slot& slot : slots)
+        glDeleteBuffers(1, &slot.pbo);
+}
+
+bool Readback::capture(uint32_t width, uint32_t height) {
+    if (count == slots.size())
+        return false;
+
+    Slot& slot = slots[(head + count) % slots.size()];
+    size_t bytes = size_t(3) * width * height;
+
+    if (slot.pbo == 0)
+        glGenBuffers(1, &slot.pbo);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.size = { width, height };
+    count++;
+
+    return true;
+}
+
+bool Readback::fetch(std::vector<uint8_t>& rgb, glm::uvec2& size) {
+    if (count == 0)
+        return false;
+
+    Slot& slot = slots[head];
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+        return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    size = slot.size;
+    size_t bytes = size_t(3) * size.x * size.y;
+    rgb.resize(bytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (ptr) {
+        std::memcpy(rgb.data(), ptr, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    head = (head + 1) % slots.size();
+    count--;
+
+    return ptr != nullptr;
+}
+
+void Readback::clear(void) {
+    for (; count > 0; count--) {
+        Slot& slot = slots[head];
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        head = (head + 1) % slots.size();
+    }
+}
@@ -0,0 +1,441 @@
+#include "recorder.h"
+
+#include "GRender/mailbox.h"
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+namespace chrono = std::chrono;
+
+// Log layout: header, then one record per frame starting with a byte of flags
+static constexpr char MAGIC[4] = { 'G', 'S', 'R', 'C' };
+static constexpr uint32_t VERSION = 3; // 3 adds removals, older logs read the same
+
+enum : uint8_t { UNIFORM_EDIT, COLOR_EDIT, UNIFORM_REMOVAL, COLOR_REMOVAL };
+
+enum : uint8_t {
+	RENDER = 1 << 0,
+	PLAY   = 1 << 1,
+	STEP   = 1 << 2,
+	RESET  = 1 << 3,
+	CAMERA = 1 << 4,
+	CURSOR = 1 << 5,
+	EDITS  = 1 << 6,
+};
+
+template <typename TP>
+static void write(std::ofstream& arq, const TP& value) {
+	arq.write(reinterpret_cast<const char*>(&value), sizeof(TP));
+}
+
+template <typename TP>
+static bool read(std::ifstream& arq, TP& value) {
+	arq.read(reinterpret_cast<char*>(&value), sizeof(TP));
+	return bool(arq);
+}
+
+static void writeString(std::ofstream& arq, const std::string& str) {
+	write(arq, static_cast<uint16_t>(str.size()));
+	arq.write(str.data(), str.size());
+}
+
+static bool readString(std::ifstream& arq, std::string& str) {
+	uint16_t size = 0;
+	if (!read(arq, size))
+		return false;
+
+	str.resize(size);
+	arq.read(&str[0], size);
+	return bool(arq);
+}
+
+static double percentile(std::vector<double> values, double p) {
+	if (values.empty())
+		return 0.0;
+
+	size_t k = std::min(values.size() - 1, size_t(p * values.size()));
+	std::nth_element(values.begin(), values.begin() + k, values.end());
+	return values[k];
+}
+
+static double average(const std::vector<double>& values) {
+	double sum = 0.0;
+	for (double v : values)
+		sum += v;
+	return values.empty() ? 0.0 : sum / double(values.size());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+bool Recorder::startRecording(const fs::path& path, const fs::path& shaderpath, float time, bool playing) {
+	if (replaying)
+		return false;
+
+	output.open(path, std::ios::binary);
+	if (!output) {
+		GRender::mailbox::CreateError("Cannot write to '" + path.string() + "'");
+		return false;
+	}
+
+	output.write(MAGIC, sizeof(MAGIC));
+	write(output, VERSION);
+	writeString(output, fs::absolute(shaderpath).string());
+	write(output, time);
+	write(output, static_cast<uint8_t>(playing));
+
+	// First frame carries complete state
+	hasLast = false;
+	values.clear();
+	numFrames = 0;
+	recording = true;
+	return true;
+}
+
+void Recorder::stopRecording(void) {
+	if (!recording)
+		return;
+
+	output.close();
+	recording = false;
+	GRender::mailbox::CreateInfo("Recorded " + std::to_string(numFrames) + " frames");
+}
+
+void Recorder::record(Frame& frame, const uniform::Uniform& uniforms, const Colors& colors) {
+	if (!recording)
+		return;
+
+	frame.edits.clear();
+
+	auto compare = [&](const Edit& edit) -> void {
+		auto it = values.find(edit.name);
+		if (it == values.end() || it->second.tp != edit.tp || it->second.count != edit.count || it->second.range != edit.range || it->second.value != edit.value) {
+			values[edit.name] = edit;
+			frame.edits.push_back(edit);
+		}
+	};
+
+	std::set<std::string> present;
+	for (const auto& [name, data] : uniforms) {
+		present.insert(name);
+
+		Edit edit;
+		edit.kind = UNIFORM_EDIT;
+		edit.tp = data->tp;
+		edit.name = name;
+		edit.count = data->count;
+		edit.value.resize(uniform::numValues(data.get()));
+		std::memcpy(edit.range.data(), uniform::rangePointer(data.get()), sizeof(edit.range));
+		std::memcpy(edit.value.data(), uniform::dataPointer(data.get()), 4 * edit.value.size());
+		compare(edit);
+	}
+
+	for (const auto& [name, cor] : colors) {
+		present.insert(name);
+
+		Edit edit;
+		edit.kind = COLOR_EDIT;
+		edit.tp = uniform::Type::VEC3;
+		edit.name = name;
+		edit.value.resize(3);
+		std::memcpy(edit.value.data(), &cor[0], 3 * sizeof(float));
+		compare(edit);
+	}
+
+	// Values deleted since last frame, which a replay would otherwise keep
+	for (auto it = values.begin(); it != values.end();) {
+		if (present.count(it->first) > 0) {
+			++it;
+			continue;
+		}
+
+		Edit edit;
+		edit.kind = it->second.kind == COLOR_EDIT ? COLOR_REMOVAL : UNIFORM_REMOVAL;
+		edit.name = it->first;
+		frame.edits.push_back(edit);
+		it = values.erase(it);
+	}
+
+	bool camera = !hasLast || frame.position != last.position || frame.yaw != last.yaw || frame.pitch != last.pitch || frame.fov != last.fov;
+	bool cursor = !hasLast || frame.cursor != last.cursor;
+
+	uint8_t flags = (frame.render ? RENDER : 0) | (frame.play ? PLAY : 0) | (frame.step ? STEP : 0) | (frame.reset ? RESET : 0)
+		| (camera ? CAMERA : 0) | (cursor ? CURSOR : 0) | (frame.edits.empty() ? 0 : EDITS);
+
+	write(output, flags);
+	write(output, frame.deltaTime);
+
+	if (camera) {
+		write(output, frame.position);
+		write(output, frame.yaw);
+		write(output, frame.pitch);
+		write(output, frame.fov);
+	}
+
+	if (cursor)
+		write(output, frame.cursor);
+
+	if (!frame.edits.empty()) {
+		write(output, static_cast<uint16_t>(frame.edits.size()));
+		for (const Edit& edit : frame.edits) {
+			write(output, edit.kind);
+			write(output, static_cast<uint8_t>(edit.tp));
+			write(output, static_cast<uint16_t>(edit.count));
+			writeString(output, edit.name);
+			write(output, edit.range);
+			output.write(reinterpret_cast<const char*>(edit.value.data()), 4 * edit.value.size());
+		}
+	}
+
+	last = frame;
+	hasLast = true;
+	numFrames++;
+}
+
+bool Recorder::startReplay(const fs::path& path, bool headless) {
+	if (recording)
+		return false;
+
+	input.open(path, std::ios::binary);
+
+	char magic[4] = { 0 };
+	uint32_t version = 0;
+	uint8_t playing = 0;
+	std::string shader;
+
+	input.read(magic, sizeof(magic));
+	bool valid = bool(input) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 && read(input, version) && version >= 2 && version <= VERSION
+		&& readString(input, shader) && read(input, startTime) && read(input, playing);
+
+	if (!valid) {
+		input.close();
+		GRender::mailbox::CreateError("'" + path.string() + "' isn't a valid recording");
+		return false;
+	}
+
+	shaderpath = shader;
+	startPlaying = playing != 0;
+
+	hasLast = false;
+	numFrames = 0;
+	cpuTimes.clear();
+	gpuTimes.clear();
+	timer.clear();
+
+	this->headless = headless;
+	if (headless)
+		glfwHideWindow(glfwGetCurrentContext());
+
+	begin = frameStart = Clock::now();
+	replaying = true;
+	return true;
+}
+
+bool Recorder::next(Frame& frame) {
+	if (!replaying)
+		return false;
+
+	// Time between consecutive frames, which includes interface and buffer swap
+	Clock::time_point now = Clock::now();
+	if (numFrames > 0)
+		cpuTimes.push_back(chrono::duration<double, std::milli>(now - frameStart).count());
+	frameStart = now;
+
+	double ms;
+	while (timer.fetch(ms))
+		gpuTimes.push_back(ms);
+
+	uint8_t flags = 0;
+	if (!read(input, flags) || !read(input, frame.deltaTime)) {
+		finish();
+		return false;
+	}
+
+	frame.render = flags & RENDER;
+	frame.play = flags & PLAY;
+	frame.step = flags & STEP;
+	frame.reset = flags & RESET;
+
+	if (flags & CAMERA) {
+		read(input, frame.position);
+		read(input, frame.yaw);
+		read(input, frame.pitch);
+		read(input, frame.fov);
+	}
+	else {
+		frame.position = last.position;
+		frame.yaw = last.yaw;
+		frame.pitch = last.pitch;
+		frame.fov = last.fov;
+	}
+
+	if (flags & CURSOR)
+		read(input, frame.cursor);
+	else
+		frame.cursor = last.cursor;
+
+	frame.edits.clear();
+	if (flags & EDITS) {
+		uint16_t count = 0;
+		read(input, count);
+		frame.edits.resize(count);
+
+		for (Edit& edit : frame.edits) {
+			uint8_t tp = 0;
+			uint16_t num = 1;
+			read(input, edit.kind);
+			read(input, tp);
+			read(input, num);
+			edit.tp = static_cast<uniform::Type>(tp);
+			edit.count = std::max<int32_t>(num, 1);
+			if (edit.kind == UNIFORM_EDIT || edit.kind == COLOR_EDIT)
+				edit.value.resize(size_t(edit.count) * uniform::numComponents(edit.tp));
+			readString(input, edit.name);
+			read(input, edit.range);
+			input.read(reinterpret_cast<char*>(edit.value.data()), 4 * edit.value.size());
+		}
+	}
+
+	if (!input) {
+		GRender::mailbox::CreateWarn("Recording ended with a truncated frame");
+		finish();
+		return false;
+	}
+
+	last = frame;
+	hasLast = true;
+	numFrames++;
+	return true;
+}
+
+void Recorder::apply(const Frame& frame, uniform::Uniform& uniforms, Colors& colors, GRender::Camera& camera) {
+	camera.setPosition(frame.position);
+	camera.setYaw(frame.yaw);
+	camera.setPitch(frame.pitch);
+	camera.setFOV(frame.fov);
+
+	for (const Edit& edit : frame.edits) {
+		if (edit.kind == UNIFORM_REMOVAL) {
+			uniforms.remove(edit.name);
+			continue;
+		}
+
+		if (edit.kind == COLOR_REMOVAL) {
+			colors.remove(edit.name);
+			continue;
+		}
+
+		if (edit.kind == COLOR_EDIT) {
+			glm::vec3 cor;
+			std::memcpy(&cor[0], edit.value.data(), sizeof(cor));
+			colors.set(edit.name, cor);
+			continue;
+		}
+
+		uniform::ParentData* data = uniforms.find(edit.name);
+		if (data == nullptr) {
+			data = uniform::create(edit.name, edit.tp, edit.count);
+			uniforms.append(edit.name, data);
+		}
+
+		if (data->tp != edit.tp || data->count != edit.count)
+			continue;
+
+		std::memcpy(uniform::rangePointer(data), edit.range.data(), sizeof(edit.range));
+		std::memcpy(uniform::dataPointer(data), edit.value.data(), 4 * edit.value.size());
+	}
+}
+
+void Recorder::beginTiming(void) {
+	if (replaying)
+		timer.begin();
+}
+
+void Recorder::endTiming(void) {
+	if (replaying)
+		timer.end();
+}
+
+void Recorder::finish(void) {
+	replaying = false;
+	input.close();
+
+	double total = chrono::duration<double>(Clock::now() - begin).count();
+
+	std::stringstream report;
+	report.precision(3);
+	report << std::fixed;
+	report << "Replayed " << numFrames << " frames in " << total << " s\n";
+	report << "Frame time (ms): mean " << average(cpuTimes) << ", median " << percentile(cpuTimes, 0.5)
+		<< ", p95 " << percentile(cpuTimes, 0.95) << ", max " << percentile(cpuTimes, 1.0) << "\n";
+	report << "GPU time (ms): mean " << average(gpuTimes) << ", median " << percentile(gpuTimes, 0.5)
+		<< ", p95 " << percentile(gpuTimes, 0.95) << ", max " << percentile(gpuTimes, 1.0) << "\n";
+
+	if (headless) {
+		std::cout << report.str();
+		glfwSetWindowShouldClose(glfwGetCurrentContext(), GLFW_TRUE);
+	}
+	else {
+		GRender::mailbox::CreateInfo(report.str());
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Recorder::showRecorder(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Recorder", &active);
+	ImGui::SetWindowSize({ 350.0f, 120.0f });
+
+	if (recording) {
+		ImGui::Text("Recording: %llu frames", static_cast<unsigned long long>(numFrames));
+		if (ImGui::Button("Stop"))
+			stopRecording();
+	}
+	else if (replaying) {
+		ImGui::Text("Replaying: frame %llu", static_cast<unsigned long long>(numFrames));
+	}
+	else {
+		if (ImGui::Button("Record..."))
+			recordOn = true;
+
+		ImGui::SameLine();
+		if (ImGui::Button("Replay..."))
+			replayOn = true;
+	}
+
+	ImGui::End();
+}
+
+bool Recorder::recordRequested(void) {
+	bool value = recordOn;
+	recordOn = false;
+	return value;
+}
+
+bool Recorder::replayRequested(void) {
+	bool value = replayOn;
+	replayOn = false;
+	return value;
+}
+
+void Recorder::open(void) {
+	active = true;
+}
+
+void Recorder::close(void) {
+	active = false;
+}
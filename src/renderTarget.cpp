@@ -0,0 +1,67 @@
+#include "renderTarget.h"
+
+#include "GRender/mailbox.h"
+
+#include <utility>
+
+RenderTarget::RenderTarget(uint32_t width, uint32_t height, GLenum format) : format(format), size(width, height) {
+    glGenFramebuffers(1, &bufferID);
+    glBindFramebuffer(GL_FRAMEBUFFER, bufferID);
+
+    glGenTextures(1, &texID);
+    glBindTexture(GL_TEXTURE_2D, texID);
+    glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+
+    // Integer formats cannot be linearly filtered
+    bool isInteger = format == GL_R32UI || format == GL_R32I || format == GL_RGBA32UI;
+    GLint filter = isInteger ? GL_NEAREST : GL_LINEAR;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texID, 0);
+
+    GRender::ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "RenderTarget is incomplete!");
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+RenderTarget::~RenderTarget(void) {
+    glDeleteTextures(1, &texID);
+    glDeleteFramebuffers(1, &bufferID);
+}
+
+RenderTarget::RenderTarget(RenderTarget&& rhs) noexcept {
+    std::swap(bufferID, rhs.bufferID);
+    std::swap(texID, rhs.texID);
+    std::swap(format, rhs.format);
+    std::swap(size, rhs.size);
+}
+
+RenderTarget& RenderTarget::operator=(RenderTarget&& rhs) noexcept {
+    if (&rhs != this) {
+        std::swap(bufferID, rhs.bufferID);
+        std::swap(texID, rhs.texID);
+        std::swap(format, rhs.format);
+        std::swap(size, rhs.size);
+    }
+    return *this;
+}
+
+void RenderTarget::bind(void) {
+    glBindFramebuffer(GL_FRAMEBUFFER, bufferID);
+    glViewport(0, 0, size.x, size.y);
+}
+
+void RenderTarget::unbind(void) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::readRGB(int32_t x, int32_t y, uint32_t width, uint32_t height, uint8_t* rgb) const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, bufferID);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
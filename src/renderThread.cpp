@@ -0,0 +1,152 @@
+#include "renderThread.h"
+#include "profiler.h"
+
+#include "GLFW/glfw3.h"
+
+#include <chrono>
+
+RenderThread::~RenderThread(void) {
+    stop();
+}
+
+bool RenderThread::start(Setup setup) {
+    if (isRunning())
+        return true;
+
+    // Windows can only be created from main thread; sharing gives access to the textures drawn
+    GLFWwindow* main = glfwGetCurrentContext();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    window = glfwCreateWindow(1, 1, "GShader render", nullptr, main);
+    glfwDefaultWindowHints();
+
+    if (window == nullptr) {
+        GRender::mailbox::CreateError("Cannot create a shared OpenGL context for render thread");
+        return false;
+    }
+
+    this->setup = std::move(setup);
+    pending = stopping = false;
+    worker = std::thread(&RenderThread::run, this);
+    return true;
+}
+
+void RenderThread::stop(void) {
+    if (!isRunning())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    worker.join();
+
+    glfwDestroyWindow(window);
+    window = nullptr;
+    frameTime = 0.0f;
+}
+
+void RenderThread::submit(void) {
+    snapshots.publish();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending = true;
+    }
+    cv.notify_one();
+}
+
+uint32_t RenderThread::getTexture(void) {
+    frames.acquire();
+    return frames.front().target.getID();
+}
+
+void RenderThread::run(void) {
+    glfwMakeContextCurrent(window);
+
+    // Vertex arrays aren't shared between contexts, so this one has its own quad
+    const float vertices[] = {
+        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+         1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+        -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+         1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+    };
+
+    uint32_t vao = 0, vbo = 0;
+    glCreateBuffers(1, &vbo);
+    glNamedBufferStorage(vbo, sizeof(vertices), vertices, 0);
+
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, 5 * sizeof(float));
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glEnableVertexArrayAttrib(vao, 2);
+    glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+    glVertexArrayAttribBinding(vao, 2, 0);
+
+    {
+        // Interface keeps its own copy of the program, which reports errors
+        std::filesystem::path loaded;
+        DynamicShader program;
+        program.setSilent(true);
+        program.initialize();
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this](void) { return pending || stopping; });
+                if (stopping)
+                    break;
+                pending = false;
+            }
+
+            if (!snapshots.acquire())
+                continue;
+
+            GSHADER_PROFILE_SCOPE("Render thread");
+            Snapshot& snap = snapshots.front();
+
+            if (snap.shaderpath != loaded || snap.modules != program.usesModules() || snap.pruning != program.usesPruning() || program.wasUpdated()) {
+                program.setModules(snap.modules);
+                program.setPruning(snap.pruning);
+                program.loadShader(snap.shaderpath);
+                loaded = snap.shaderpath;
+            }
+
+            if (program.hasFailed() || snap.resolution.x == 0 || snap.resolution.y == 0)
+                continue;
+
+            auto begin = std::chrono::steady_clock::now();
+
+            Frame& frame = frames.back();
+            if (frame.target.getSize() != snap.resolution)
+                frame.target = RenderTarget(snap.resolution.x, snap.resolution.y);
+
+            frame.target.bind();
+            setup(program, snap);
+            glBindVertexArray(vao);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            glBindVertexArray(0);
+            frame.target.unbind();
+
+            // Frame is handed over only once GPU is done with it, so interface never waits
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000) == GL_TIMEOUT_EXPIRED) {}
+            glDeleteSync(fence);
+
+            frames.publish();
+            frameTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        }
+    }
+
+    // Resources created here are released here, while context is still current
+    for (Frame& frame : frames.all())
+        frame.target = RenderTarget();
+
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glfwMakeContextCurrent(nullptr);
+}
@@ -0,0 +1,97 @@
+#include "scheduler.h"
+#include "profiler.h"
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+
+#include "imgui.h"
+
+namespace chrono = std::chrono;
+
+bool Scheduler::wait(bool playing) {
+	GSHADER_PROFILE_SCOPE("Scheduler wait");
+	GLFWwindow* window = glfwGetCurrentContext();
+
+	auto minimized = [window](void) -> bool {
+		return glfwGetWindowAttrib(window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(window, GLFW_VISIBLE);
+	};
+	bool focused = glfwGetWindowAttrib(window, GLFW_FOCUSED);
+
+	// Nothing to see, so we sleep until the window is restored or closed
+	if (minimized() && !policy.renderMinimized) {
+		state = "Minimized";
+		while (minimized() && !glfwWindowShouldClose(window))
+			glfwWaitEvents();
+
+		lastFrame = Clock::now();
+		return false;
+	}
+
+	if (!playing) {
+		// Interface only needs to be refreshed when user does something
+		state = "Paused";
+		float fps = policy.pausedFPS > 0.0f ? policy.pausedFPS : 1.0f;
+		waitUntil(lastFrame + chrono::duration_cast<Clock::duration>(chrono::duration<float>(1.0f / fps)), true);
+	}
+	else {
+		state = focused ? "Focused" : "Unfocused";
+		float fps = focused ? policy.focusedFPS : policy.unfocusedFPS;
+		if (fps > 0.0f)
+			waitUntil(lastFrame + chrono::duration_cast<Clock::duration>(chrono::duration<float>(1.0f / fps)), false);
+	}
+
+	lastFrame = Clock::now();
+	return true;
+}
+
+void Scheduler::waitUntil(Clock::time_point deadline, bool wakeOnEvent) {
+	// Waiting for events instead of sleeping keeps the window responsive to the OS
+	for (Clock::time_point now = Clock::now(); now < deadline; now = Clock::now()) {
+		glfwWaitEventsTimeout(chrono::duration<double>(deadline - now).count());
+		if (wakeOnEvent)
+			break;
+	}
+}
+
+void Scheduler::showScheduler(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Scheduler", &active);
+	ImGui::SetWindowSize({ 400.0f, 180.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+	ImGui::Text("State: %s", state);
+
+	auto row = [&](const char* label, const char* tag, float* value, float minVal, float maxVal) -> void {
+		ImGui::Text("%s", label);
+		ImGui::SameLine(0.4f * width);
+		ImGui::SetNextItemWidth(0.55f * width);
+		// Takes effect while dragging, but is only saved once the slider is released
+		ImGui::SliderFloat(tag, value, minVal, maxVal, *value > 0.0f ? "%.0f fps" : "unlimited");
+		modified |= ImGui::IsItemDeactivatedAfterEdit();
+	};
+
+	row("Focused:", "##focused", &policy.focusedFPS, 0.0f, 240.0f);
+	row("Unfocused:", "##unfocused", &policy.unfocusedFPS, 0.0f, 60.0f);
+	row("Paused:", "##paused", &policy.pausedFPS, 1.0f, 60.0f);
+
+	modified |= ImGui::Checkbox("Render when minimized", &policy.renderMinimized);
+
+	ImGui::End();
+}
+
+bool Scheduler::wasModified(void) {
+	bool value = modified;
+	modified = false;
+	return value;
+}
+
+void Scheduler::open(void) {
+	active = true;
+}
+
+void Scheduler::close(void) {
+	active = false;
+}
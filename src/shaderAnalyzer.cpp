@@ -0,0 +1,399 @@
+#include "shaderAnalyzer.h"
+#include "dynamicShader.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <regex>
+#include <set>
+
+static std::string trim(const std::string& str) {
+	size_t a = str.find_first_not_of(" \t\r\n");
+	if (a == std::string::npos)
+		return "";
+	size_t b = str.find_last_not_of(" \t\r\n");
+	return str.substr(a, b - a + 1);
+}
+
+static bool parseInteger(const std::string& str, int64_t& value) {
+	std::string txt = trim(str);
+	if (!txt.empty() && (txt.back() == 'u' || txt.back() == 'U'))
+		txt.pop_back();
+
+	if (txt.empty())
+		return false;
+
+	char* end = nullptr;
+	value = std::strtoll(txt.c_str(), &end, 0);
+	return *end == '\0';
+}
+
+void ShaderAnalyzer::analyze(const DynamicShader& shader) {
+	analyze(shader.getSource());
+
+	const std::string& src = shader.getSource();
+	for (Entry& entry : entries)
+		entry.location = shader.locate(int32_t(glsl::lineOf(src, nodes[entry.name].begin)));
+}
+
+void ShaderAnalyzer::analyze(const std::string& source) {
+	constants.clear();
+	nodes.clear();
+	paramCache.clear();
+	entries.clear();
+
+	const std::string src = glsl::stripComments(source);
+
+	// Integer constants available to loop bounds
+	static const std::regex rgxDefine(R"(#\s*define\s+(\w+)\s+([-+]?\w+)\s*\n)");
+	static const std::regex rgxConst(R"(\bconst\s+u?int\s+(\w+)\s*=\s*([-+]?\w+)\s*;)");
+	for (const std::regex* rgx : { &rgxDefine, &rgxConst }) {
+		for (auto it = std::sregex_iterator(src.begin(), src.end(), *rgx); it != std::sregex_iterator(); it++) {
+			int64_t value;
+			if (parseInteger((*it)[2].str(), value))
+				constants[(*it)[1].str()] = value;
+		}
+	}
+
+	std::vector<glsl::Function> functions = glsl::findFunctions(src);
+	for (const glsl::Function& fn : functions) {
+		if (!fn.prototype)
+			nodes[fn.name];  // registering names first, so calls can be recognized
+	}
+
+	for (const glsl::Function& fn : functions) {
+		if (fn.prototype)
+			continue;
+
+		// Overloads are merged into the same node
+		Node& node = nodes[fn.name];
+		if (node.statements == 0) {
+			node.params = fn.params;
+			node.begin = fn.begin;
+		}
+		parseBody(src, fn, node);
+	}
+
+	////////////////////////////////////////////////////////////
+	// Propagating invocations from main in topological order
+
+	std::vector<std::string> order;
+	std::set<std::string> visited;
+	std::function<void(const std::string&)> visit = [&](const std::string& name) -> void {
+		if (!visited.insert(name).second)
+			return;
+
+		for (const CallSite& call : nodes[name].calls)
+			visit(call.callee);
+
+		order.push_back(name);
+	};
+
+	if (nodes.count("main"))
+		visit("main");
+
+	std::reverse(order.begin(), order.end());
+
+	std::map<std::string, double> count;
+	std::map<std::string, bool> bounded;
+	count["main"] = 1.0;
+	bounded["main"] = true;
+
+	for (const std::string& name : order) {
+		for (const CallSite& call : nodes[name].calls) {
+			double mult = 1.0;
+			bool known = bounded[name];
+
+			for (const Bound& loop : call.loops) {
+				int64_t value = loop.value;
+				if (loop.param >= 0)
+					value = paramValue(name, loop.param, known) - loop.offset;
+
+				known &= loop.known;
+				mult *= double(std::max<int64_t>(value, 0));
+			}
+
+			count[call.callee] += count[name] * mult;
+			if (!bounded.count(call.callee))
+				bounded[call.callee] = true;
+			bounded[call.callee] = bounded[call.callee] && known;
+		}
+	}
+
+	for (const auto& [name, node] : nodes) {
+		Entry entry;
+		entry.name = name;
+		entry.invocations = count[name];
+		entry.weight = entry.invocations * node.statements;
+		entry.bounded = !bounded.count(name) || bounded[name];
+
+		std::set<std::string> callees;
+		for (const CallSite& call : node.calls)
+			callees.insert(call.callee);
+		entry.callees.assign(callees.begin(), callees.end());
+
+		entries.push_back(std::move(entry));
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) -> bool {
+		return a.invocations > b.invocations;
+	});
+}
+
+void ShaderAnalyzer::parseBody(const std::string& src, const glsl::Function& fn, Node& node) {
+	struct Frame {
+		Bound bound;
+		int32_t depth;
+		bool braceless;
+	};
+
+	std::vector<Frame> frames;
+	int32_t depth = 0;
+
+	// Opens a loop whose header is the bracket at 'open'. Returns position to continue from
+	auto openLoop = [&](size_t open, const Bound& bound) -> size_t {
+		size_t close = glsl::matchBracket(src, open);
+		size_t next = glsl::skipSpaces(src, close + 1);
+
+		if (src[next] == '{')
+			frames.push_back({ bound, depth + 1, false });
+		else
+			frames.push_back({ bound, depth, true });
+
+		return close;
+	};
+
+	for (size_t k = fn.bodyBegin + 1; k + 1 < fn.end; k++) {
+		const char ch = src[k];
+
+		if (ch == '{') {
+			depth++;
+		}
+		else if (ch == '}') {
+			depth--;
+			while (!frames.empty() && !frames.back().braceless && depth < frames.back().depth)
+				frames.pop_back();
+		}
+		else if (ch == ';') {
+			node.statements++;
+			while (!frames.empty() && frames.back().braceless && frames.back().depth == depth)
+				frames.pop_back();
+		}
+		else if (glsl::isIdentifierChar(ch) && !glsl::isIdentifierChar(src[k - 1]) && src[k - 1] != '.') {
+			size_t end = k;
+			while (glsl::isIdentifierChar(src[end]))
+				end++;
+
+			const std::string word = src.substr(k, end - k);
+			size_t next = glsl::skipSpaces(src, end);
+
+			if (next < fn.end && src[next] == '(') {
+				size_t close = glsl::matchBracket(src, next);
+
+				if (word == "for") {
+					end = openLoop(next, parseLoop(src.substr(next + 1, close - next - 1), node));
+				}
+				else if (word == "while") {
+					Bound bound;
+					bound.known = false;
+					end = openLoop(next, bound);
+				}
+				else if (nodes.count(word)) {
+					CallSite call;
+					call.callee = word;
+					call.args = glsl::splitArguments(src, next, close);
+					for (const Frame& frame : frames)
+						call.loops.push_back(frame.bound);
+
+					node.calls.push_back(std::move(call));
+				}
+			}
+
+			k = end - 1;
+		}
+	}
+}
+
+ShaderAnalyzer::Bound ShaderAnalyzer::parseLoop(const std::string& header, const Node& node) {
+	Bound bound;
+	bound.known = false;
+
+	size_t s1 = header.find(';');
+	size_t s2 = header.find(';', s1 + 1);
+	if (s1 == std::string::npos || s2 == std::string::npos)
+		return bound;
+
+	// Initial value of loop variable
+	static const std::regex rgxInit(R"((\w+)\s*=\s*([-+]?\w+)\s*$)");
+	std::smatch init;
+	std::string strInit = trim(header.substr(0, s1));
+	if (!std::regex_search(strInit, init, rgxInit))
+		return bound;
+
+	const std::string var = init[1].str();
+	int64_t start = 0;
+	if (!parseInteger(init[2].str(), start)) {
+		if (!constants.count(init[2].str()))
+			return bound;
+		start = constants[init[2].str()];
+	}
+
+	// Only the first comparison matters for the upper bound
+	std::string cond = header.substr(s1 + 1, s2 - s1 - 1);
+	cond = cond.substr(0, cond.find("&&"));
+
+	static const std::regex rgxCond(R"(^\s*(\w+)\s*(<=|<|>=|>)\s*(\w+)\s*$)");
+	std::smatch match;
+	if (!std::regex_search(cond, match, rgxCond) || match[1].str() != var)
+		return bound;
+
+	const std::string op = match[2].str(), limit = match[3].str();
+	bool increasing = op[0] == '<';
+	int64_t inclusive = op.size() == 2 ? 1 : 0;
+
+	int64_t value;
+	if (parseInteger(limit, value) || constants.count(limit)) {
+		if (constants.count(limit))
+			value = constants[limit];
+
+		bound.value = increasing ? value - start + inclusive : start - value + inclusive;
+		bound.known = true;
+		return bound;
+	}
+
+	// Bound given by one of the function parameters is resolved from call sites
+	auto it = std::find(node.params.begin(), node.params.end(), limit);
+	if (it != node.params.end() && increasing) {
+		bound.param = int32_t(it - node.params.begin());
+		bound.offset = start - inclusive;
+		bound.known = true;
+	}
+
+	return bound;
+}
+
+int64_t ShaderAnalyzer::evaluate(const std::string& expr, const std::string& caller, bool& known) {
+	int64_t value;
+	const std::string txt = trim(expr);
+
+	if (parseInteger(txt, value))
+		return value;
+
+	if (constants.count(txt))
+		return constants[txt];
+
+	const std::vector<std::string>& params = nodes[caller].params;
+	auto it = std::find(params.begin(), params.end(), txt);
+	if (it != params.end())
+		return paramValue(caller, int32_t(it - params.begin()), known);
+
+	known = false;
+	return 1;
+}
+
+int64_t ShaderAnalyzer::paramValue(const std::string& fn, int32_t param, bool& known) {
+	auto& cache = paramCache[fn];
+	if (cache.count(param))
+		return cache[param];
+
+	cache[param] = 1; // GLSL has no recursion, this only guards against broken sources
+
+	// Worst case is the largest value passed by any caller
+	int64_t value = 0;
+	bool found = false;
+	for (const auto& [caller, node] : nodes) {
+		for (const CallSite& call : node.calls) {
+			if (call.callee == fn && param < int32_t(call.args.size())) {
+				value = std::max(value, evaluate(call.args[param], caller, known));
+				found = true;
+			}
+		}
+	}
+
+	if (!found) {
+		known = false;
+		value = 1;
+	}
+
+	cache[param] = value;
+	return value;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void ShaderAnalyzer::showAnalysis(void) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Cost analysis", &active);
+	ImGui::SetWindowSize({ 600.0f, 350.0f });
+
+	if (ImGui::Button("Analyze")) {
+		analyzeOn = true;
+	}
+	ImGui::SameLine();
+	ImGui::Text("Worst-case invocations per pixel");
+
+	const ImVec2 size = { 0.97f * ImGui::GetWindowWidth(), 0.8f * ImGui::GetWindowHeight() };
+	if (ImGui::BeginTable("##costs", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, size)) {
+		ImGui::TableSetupColumn("Function");
+		ImGui::TableSetupColumn("Calls / pixel");
+		ImGui::TableSetupColumn("Weight");
+		ImGui::TableSetupColumn("Location");
+		ImGui::TableHeadersRow();
+
+		for (const Entry& entry : entries) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", entry.name.c_str());
+
+			if (ImGui::IsItemHovered() && !entry.callees.empty()) {
+				std::string callees = "Calls:";
+				for (const std::string& name : entry.callees)
+					callees += " " + name;
+				ImGui::SetTooltip("%s", callees.c_str());
+			}
+
+			ImGui::TableNextColumn();
+			if (entry.invocations == 0.0)
+				ImGui::TextColored({ 0.5f, 0.5f, 0.5f, 1.0f }, "unused");
+			else
+				ImGui::Text(entry.bounded ? "%.0f" : "%.0f+ (unknown loop)", entry.invocations);
+
+			ImGui::TableNextColumn();
+			ImGui::Text("%.0f", entry.weight);
+
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", entry.location.c_str());
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+bool ShaderAnalyzer::requested(void) {
+	bool value = analyzeOn;
+	analyzeOn = false;
+	return value;
+}
+
+void ShaderAnalyzer::invalidate(void) {
+	// Opening the panel analyzes anyway, so a closed one has nothing to do
+	if (active)
+		analyzeOn = true;
+}
+
+void ShaderAnalyzer::open(void) {
+	active = true;
+	analyzeOn = true;
+}
+
+void ShaderAnalyzer::close(void) {
+	active = false;
+}
@@ -0,0 +1,70 @@
+#include "stagingRing.h"
+
+StagingRing::StagingRing(size_t slotSize) : slotSize(slotSize) {
+}
+
+StagingRing::~StagingRing(void) {
+    for (GLsync& fence : fences)
+        glDeleteSync(fence);
+
+    if (bufferID != 0) {
+        glUnmapNamedBuffer(bufferID);
+        glDeleteBuffers(1, &bufferID);
+    }
+}
+
+uint8_t* StagingRing::acquire(void) {
+    if (bufferID == 0) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &bufferID);
+        glNamedBufferStorage(bufferID, NUM_SLOTS * slotSize, nullptr, flags);
+        mapped = static_cast<uint8_t*>(glMapNamedBufferRange(bufferID, 0, NUM_SLOTS * slotSize, flags));
+    }
+
+    if (mapped == nullptr)
+        return nullptr;
+
+    if (acquired)
+        return mapped + current * slotSize;
+
+    // Slots are used in order, so the next one is also the oldest in flight
+    GLsync& fence = fences[current];
+    if (fence) {
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            return nullptr;
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    acquired = true;
+    return mapped + current * slotSize;
+}
+
+void StagingRing::copyToBuffer(uint32_t buffer, size_t offset, size_t bytes) {
+    if (!acquired)
+        return;
+
+    glCopyNamedBufferSubData(bufferID, buffer, GLintptr(current * slotSize), GLintptr(offset), GLsizeiptr(bytes));
+    release();
+}
+
+void StagingRing::copyToTexture(uint32_t texture, int32_t x, int32_t y, uint32_t width, uint32_t height, GLenum format) {
+    if (!acquired)
+        return;
+
+    // With a pixel unpack buffer bound, the pointer is an offset into it
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bufferID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage2D(texture, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(current * slotSize));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    release();
+}
+
+void StagingRing::release(void) {
+    fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    current = (current + 1) % NUM_SLOTS;
+    acquired = false;
+}
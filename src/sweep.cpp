@@ -0,0 +1,378 @@
+#include "sweep.h"
+#include "imageWriter.h"
+#include "glsl.h"
+
+#include "GRender/mailbox.h"
+
+#include "imgui.h"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <regex>
+
+namespace fs = std::filesystem;
+using uniform::Type;
+
+// Binding point reserved for swept values
+static constexpr uint32_t SWEEP_BINDING = 6;
+
+// Every instance draws one tile of the grid, first row on top
+static const char* vertexSource =
+	"#version 450 core\n"
+	"uniform ivec2 gsSweepGrid;\n"
+	"out vec2 fragCoord;\n"
+	"flat out int gsInstance;\n"
+	"void main() {\n"
+	"    const vec2 corners[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),\n"
+	"                                   vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));\n"
+	"    vec2 corner = corners[gl_VertexID];\n"
+	"    ivec2 tile = ivec2(gl_InstanceID % gsSweepGrid.x, gsSweepGrid.y - 1 - gl_InstanceID / gsSweepGrid.x);\n"
+	"    vec2 pos = (vec2(tile) + corner) / vec2(gsSweepGrid);\n"
+	"    fragCoord = corner;\n"
+	"    gsInstance = gl_InstanceID;\n"
+	"    gl_Position = vec4(2.0 * pos - 1.0, 0.0, 1.0);\n"
+	"}\n";
+
+template <typename TP>
+static glm::vec4 toVec4(const uniform::ParentData* ptr, glm::vec2& range) {
+	const TP* data = reinterpret_cast<const TP*>(ptr);
+	range = glm::vec2(data->range);
+
+	glm::vec4 value = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int32_t k = 0; k < uniform::numComponents(ptr->tp); k++)
+		value[k] = float(data->data[k]);
+
+	return value;
+}
+
+Sweep::~Sweep(void) {
+	glDeleteBuffers(1, &bufferID);
+	glDeleteVertexArrays(1, &vaoID);
+}
+
+void Sweep::showSweep(const uniform::Uniform& uniforms, const Colors& colors) {
+	if (!active) {
+		return;
+	}
+
+	ImGui::Begin("Parameter sweep", &active);
+	ImGui::SetWindowSize({ 550.0f, 600.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+	const std::vector<Target> targets = gather(uniforms, colors);
+
+	for (int32_t k = 0; k < 2; k++) {
+		Axis& axis = axes[k];
+		ImGui::PushID(k);
+
+		if (k == 1) {
+			ImGui::Checkbox("Second axis", &useSecond);
+			if (!useSecond) {
+				ImGui::PopID();
+				break;
+			}
+		}
+
+		auto it = std::find_if(targets.begin(), targets.end(), [&](const Target& tg) { return tg.name == axis.name; });
+		const char* preview = it == targets.end() ? "Choose..." : axis.name.c_str() + 2;
+
+		ImGui::Text(k == 0 ? "Columns:" : "Rows:");
+		ImGui::SameLine(0.25f * width);
+		ImGui::SetNextItemWidth(0.45f * width);
+		if (ImGui::BeginCombo("##target", preview)) {
+			for (const Target& tg : targets) {
+				if (ImGui::Selectable(tg.name.c_str() + 2, tg.name == axis.name)) {
+					axis.name = tg.name;
+					axis.component = 0;
+					axis.from = tg.range.x;
+					axis.to = tg.range.y;
+				}
+			}
+			ImGui::EndCombo();
+		}
+
+		if (it != targets.end() && uniform::numComponents(it->tp) > 1) {
+			ImGui::SameLine();
+			ImGui::SetNextItemWidth(0.25f * width);
+			ImGui::SliderInt("##component", &axis.component, 0, uniform::numComponents(it->tp) - 1, "component %d");
+		}
+
+		ImGui::Text("Values:");
+		ImGui::SameLine(0.25f * width);
+		ImGui::SetNextItemWidth(0.45f * width);
+		ImGui::DragFloat2("##range", &axis.from, 0.01f);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(0.25f * width);
+		ImGui::SliderInt("##count", &axis.count, 1, 16, "%d steps");
+
+		ImGui::PopID();
+	}
+
+	uint32_t minVal = 16, maxVal = 2048;
+	ImGui::Text("Tile size:");
+	ImGui::SameLine(0.25f * width);
+	ImGui::SetNextItemWidth(0.45f * width);
+	ImGui::DragScalarN("##tileSize", ImGuiDataType_U32, glm::value_ptr(tileSize), 2, 4.0f, &minVal, &maxVal);
+
+	if (ImGui::Button("Render"))
+		renderOn = true;
+
+	if (grid.x > 0) {
+		ImGui::SameLine();
+		if (ImGui::Button("Save..."))
+			saveOn = true;
+
+		///////////////////////////////////////////////////////
+		// Contact sheet with values of hovered tile
+
+		const glm::uvec2& size = sheet.getSize();
+		ImVec2 port = { width, width * float(size.y) / float(size.x) };
+		ImGui::Image((void*)(uintptr_t)sheet.getID(), port, { 0.0f, 1.0f }, { 1.0f, 0.0f });
+
+		if (ImGui::IsItemHovered()) {
+			ImVec2 pos = ImGui::GetMousePos(), corner = ImGui::GetItemRectMin();
+			int32_t col = std::clamp(int32_t((pos.x - corner.x) / port.x * grid.x), 0, grid.x - 1);
+			int32_t row = std::clamp(int32_t((pos.y - corner.y) / port.y * grid.y), 0, grid.y - 1);
+
+			ImGui::BeginTooltip();
+			ImGui::Text("%s[%d] = %.4f", axes[0].name.c_str() + 2, axes[0].component, valueAt(axes[0], col));
+			if (grid.y > 1 || useSecond)
+				ImGui::Text("%s[%d] = %.4f", axes[1].name.c_str() + 2, axes[1].component, valueAt(axes[1], row));
+			ImGui::EndTooltip();
+		}
+	}
+
+	ImGui::End();
+}
+
+bool Sweep::requested(void) {
+	bool value = renderOn;
+	renderOn = false;
+	return value;
+}
+
+bool Sweep::saveRequested(void) {
+	bool value = saveOn;
+	saveOn = false;
+	return value;
+}
+
+bool Sweep::begin(const fs::path& shaderpath, const uniform::Uniform& uniforms, const Colors& colors) {
+	const std::vector<Target> targets = gather(uniforms, colors);
+	const int32_t numAxes = useSecond ? 2 : 1;
+
+	// Distinct uniforms being swept and their current values
+	std::vector<Type> types;
+	std::vector<glm::vec4> base;
+	std::array<size_t, 2> slot = { 0, 0 };
+
+	names.clear();
+	for (int32_t k = 0; k < numAxes; k++) {
+		auto it = std::find_if(targets.begin(), targets.end(), [&](const Target& tg) { return tg.name == axes[k].name; });
+		if (it == targets.end()) {
+			GRender::mailbox::CreateError("Every axis of the sweep needs a uniform or color!");
+			return false;
+		}
+
+		auto pos = std::find(names.begin(), names.end(), it->name);
+		slot[k] = pos - names.begin();
+		if (pos == names.end()) {
+			names.push_back(it->name);
+			types.push_back(it->tp);
+			base.push_back(it->value);
+		}
+	}
+
+	glm::ivec2 size = { axes[0].count, useSecond ? axes[1].count : 1 };
+
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	if (size.x * tileSize.x > uint32_t(maxSize) || size.y * tileSize.y > uint32_t(maxSize)) {
+		GRender::mailbox::CreateError("Contact sheet is larger than " + std::to_string(maxSize) + " pixels!");
+		return false;
+	}
+
+	///////////////////////////////////////////////////////
+	// One entry per instance and swept uniform
+
+	std::vector<glm::vec4> values(size_t(size.x) * size.y * names.size());
+	for (int32_t row = 0; row < size.y; row++) {
+		for (int32_t col = 0; col < size.x; col++) {
+			glm::vec4* inst = values.data() + (size_t(row) * size.x + col) * names.size();
+			std::copy(base.begin(), base.end(), inst);
+
+			inst[slot[0]][axes[0].component] = valueAt(axes[0], col);
+			if (useSecond)
+				inst[slot[1]][axes[1].component] = valueAt(axes[1], row);
+		}
+	}
+
+	if (!initialized) {
+		shader.initialize(vertexSource);
+		glGenVertexArrays(1, &vaoID);
+		glGenBuffers(1, &bufferID);
+		initialized = true;
+	}
+
+	// Always recompiled, as shader or swept uniforms might have changed since last time
+	shader.setPass([names = names, types](const std::string& src) -> std::string { return transform(src, names, types); });
+	shader.loadShader(shaderpath);
+	if (shader.hasFailed()) {
+		grid = { 0, 0 };
+		return false;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, values.size() * sizeof(glm::vec4), values.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SWEEP_BINDING, bufferID);
+
+	grid = size;
+	glm::uvec2 resolution = glm::uvec2(grid) * tileSize;
+	if (sheet.getSize() != resolution)
+		sheet = RenderTarget(resolution.x, resolution.y);
+
+	const float black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	glClearNamedFramebufferfv(sheet.getFramebufferID(), GL_COLOR, 0, black);
+	sheet.bind();
+
+	return true;
+}
+
+void Sweep::end(void) {
+	shader.setVec2i("gsSweepGrid", glm::value_ptr(grid));
+
+	glBindVertexArray(vaoID);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, grid.x * grid.y);
+	glBindVertexArray(0);
+
+	sheet.unbind();
+}
+
+bool Sweep::save(const fs::path& path) {
+	fs::path output = path;
+	if (output.extension() != ".ppm")
+		output += ".ppm";
+
+	const glm::uvec2& size = sheet.getSize();
+	std::vector<uint8_t> rgb(3 * size_t(size.x) * size.y);
+	sheet.readRGB(0, 0, size.x, size.y, rgb.data());
+
+	if (!ImageWriter::save(output, size.x, size.y, rgb.data()))
+		return false;
+
+	GRender::mailbox::CreateInfo("Contact sheet saved!");
+	return true;
+}
+
+void Sweep::open(void) {
+	active = true;
+}
+
+void Sweep::close(void) {
+	active = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+std::string Sweep::transform(const std::string& src, const std::vector<std::string>& names, const std::vector<Type>& types) {
+	const std::string clean = glsl::stripComments(src);
+	std::string out = src;
+
+	std::string assignments;
+	for (size_t k = 0; k < names.size(); k++) {
+		const std::string name = names[k].substr(2);
+
+		// Dropping the qualifier only, so positions and lines remain the same
+		std::smatch match;
+		const std::regex rgx("\\buniform(\\s+\\w+\\s+" + name + "\\s*;)");
+		if (!std::regex_search(clean, match, rgx)) {
+			GRender::mailbox::CreateWarn("Uniform '" + name + "' isn't declared in shader");
+			continue;
+		}
+		out.replace(match.position(0), 7, "       ");
+
+		static const char* swizzle[] = { ".x", ".xy", ".xyz", "" };
+		static const char* floatTypes[] = { "float", "vec2", "vec3", "vec4" };
+		static const char* intTypes[] = { "int", "ivec2", "ivec3", "ivec4" };
+
+		const int32_t n = uniform::numComponents(types[k]) - 1;
+		const bool isInteger = types[k] < Type::FLOAT;
+		const std::string value = "gsSweepValues[" + std::to_string(names.size()) + " * gsInstance + " + std::to_string(k) + "]" + swizzle[n];
+
+		assignments += "    " + name + " = " + (isInteger ? std::string(intTypes[n]) + "(round(" + value + "))" : std::string(floatTypes[n]) + "(" + value + ")") + ";\n";
+	}
+
+	// Renaming entry point, it is called from the new one
+	for (const glsl::Function& fn : glsl::findFunctions(clean)) {
+		if (fn.name == "main" && !fn.prototype) {
+			out.replace(clean.find("main", fn.begin), 4, "gsSweepMain");
+			break;
+		}
+	}
+
+	out += "\n"
+		"flat in int gsInstance;\n"
+		"layout(std430, binding = " + std::to_string(SWEEP_BINDING) + ") buffer GSSweep { vec4 gsSweepValues[]; };\n"
+		"void main() {\n" + assignments +
+		"    gsSweepMain();\n"
+		"}\n";
+
+	return out;
+}
+
+std::vector<Sweep::Target> Sweep::gather(const uniform::Uniform& uniforms, const Colors& colors) const {
+	std::vector<Target> targets;
+
+	for (const auto& [name, data] : uniforms) {
+		// Sweeping a single component of arrays or matrices isn't supported
+		if (data->count > 1 || data->tp >= Type::MAT2)
+			continue;
+
+		Target tg;
+		tg.name = name;
+		tg.tp = data->tp;
+
+		switch (data->tp) {
+		case Type::INT:
+			tg.value = toVec4<uniform::DataInt>(data.get(), tg.range);
+			break;
+		case Type::IVEC2:
+			tg.value = toVec4<uniform::DataInt2>(data.get(), tg.range);
+			break;
+		case Type::IVEC3:
+			tg.value = toVec4<uniform::DataInt3>(data.get(), tg.range);
+			break;
+		case Type::IVEC4:
+			tg.value = toVec4<uniform::DataInt4>(data.get(), tg.range);
+			break;
+		case Type::FLOAT:
+			tg.value = toVec4<uniform::DataFloat>(data.get(), tg.range);
+			break;
+		case Type::VEC2:
+			tg.value = toVec4<uniform::DataFloat2>(data.get(), tg.range);
+			break;
+		case Type::VEC3:
+			tg.value = toVec4<uniform::DataFloat3>(data.get(), tg.range);
+			break;
+		default:
+			tg.value = toVec4<uniform::DataFloat4>(data.get(), tg.range);
+			break;
+		}
+
+		targets.push_back(tg);
+	}
+
+	for (const auto& [name, cor] : colors)
+		targets.push_back({ name, Type::VEC3, { cor.x, cor.y, cor.z, 0.0f }, { 0.0f, 1.0f } });
+
+	return targets;
+}
+
+float Sweep::valueAt(const Axis& axis, int32_t k) const {
+	if (axis.count <= 1)
+		return axis.from;
+
+	return axis.from + (axis.to - axis.from) * float(k) / float(axis.count - 1);
+}
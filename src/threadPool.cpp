@@ -0,0 +1,64 @@
+#include "threadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t numThreads) {
+    numThreads = std::max(numThreads, 1u);
+    for (uint32_t k = 0; k < numThreads; k++)
+        workers.emplace_back(&ThreadPool::run, this);
+}
+
+ThreadPool::~ThreadPool(void) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cvJob.notify_all();
+
+    for (std::thread& th : workers)
+        th.join();
+}
+
+void ThreadPool::submit(std::function<void(void)> job) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        jobs.push(std::move(job));
+    }
+    cvJob.notify_one();
+}
+
+void ThreadPool::wait(void) {
+    std::unique_lock<std::mutex> lock(mtx);
+    cvDone.wait(lock, [&] { return jobs.empty() && running == 0; });
+}
+
+size_t ThreadPool::pending(void) {
+    std::lock_guard<std::mutex> lock(mtx);
+    return jobs.size() + running;
+}
+
+void ThreadPool::run(void) {
+    while (true) {
+        std::function<void(void)> job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvJob.wait(lock, [&] { return stop || !jobs.empty(); });
+
+            // Remaining jobs are discarded when pool is destroyed
+            if (stop)
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop();
+            running++;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            running--;
+        }
+        cvDone.notify_all();
+    }
+}
@@ -1,4 +1,6 @@
 #include "uniforms.h"
+#include "expression.h"
+#include "profiler.h"
 
 #include "GRender/mailbox.h"
 
@@ -6,13 +8,209 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <regex>
+
 namespace uniform {
 
+std::vector<Annotation> findAnnotations(const std::string& source, const std::string& keyword) {
+	const std::regex rgx("\\buniform\\s+(\\w+)\\s+(\\w+)\\s*;[ \\t]*//[ \\t]*@" + keyword + "\\b[ \\t]*([^\\r\\n]*)");
+
+	std::vector<Annotation> found;
+	for (auto it = std::sregex_iterator(source.begin(), source.end(), rgx); it != std::sregex_iterator(); ++it) {
+		std::string args = (*it)[3].str();
+		args.erase(args.find_last_not_of(" \t") + 1);
+		found.push_back({ (*it)[1].str(), (*it)[2].str(), std::move(args) });
+	}
+	return found;
+}
+
+int32_t numComponents(Type tp) {
+	switch (tp) {
+	case Type::MAT2:
+		return 4;
+	case Type::MAT3:
+		return 9;
+	case Type::MAT4:
+		return 16;
+	default:
+		break;
+	}
+
+	if (tp >= Type::FLOAT)
+		return static_cast<int32_t>(tp) - static_cast<int32_t>(Type::FLOAT) + 1;
+
+	return static_cast<int32_t>(tp) - static_cast<int32_t>(Type::INT) + 1;
+}
+
+Type fromGL(GLenum type) {
+	switch (type) {
+	case GL_INT:
+	case GL_BOOL:
+		return Type::INT;
+	case GL_INT_VEC2:
+	case GL_BOOL_VEC2:
+		return Type::IVEC2;
+	case GL_INT_VEC3:
+	case GL_BOOL_VEC3:
+		return Type::IVEC3;
+	case GL_INT_VEC4:
+	case GL_BOOL_VEC4:
+		return Type::IVEC4;
+	case GL_FLOAT:
+		return Type::FLOAT;
+	case GL_FLOAT_VEC2:
+		return Type::VEC2;
+	case GL_FLOAT_VEC3:
+		return Type::VEC3;
+	case GL_FLOAT_VEC4:
+		return Type::VEC4;
+	case GL_FLOAT_MAT2:
+		return Type::MAT2;
+	case GL_FLOAT_MAT3:
+		return Type::MAT3;
+	case GL_FLOAT_MAT4:
+		return Type::MAT4;
+	default:
+		return Type::NONE;
+	}
+}
+
+const char* glslName(Type tp) {
+	static const char* names[] = { "none", "int", "ivec2", "ivec3", "ivec4", "float", "vec2", "vec3", "vec4", "mat2", "mat3", "mat4" };
+	return names[static_cast<int32_t>(tp)];
+}
+
+int32_t numValues(const ParentData* ptr) {
+	return ptr->count * numComponents(ptr->tp);
+}
+
+void* dataPointer(ParentData* ptr) {
+	if (ptr->count > 1) {
+		if (ptr->tp < Type::FLOAT)
+			return reinterpret_cast<ArrayData<int32_t>*>(ptr)->data.data();
+
+		return reinterpret_cast<ArrayData<float>*>(ptr)->data.data();
+	}
+
+	switch (ptr->tp) {
+	case Type::INT:
+		return glm::value_ptr(reinterpret_cast<DataInt*>(ptr)->data);
+	case Type::IVEC2:
+		return glm::value_ptr(reinterpret_cast<DataInt2*>(ptr)->data);
+	case Type::IVEC3:
+		return glm::value_ptr(reinterpret_cast<DataInt3*>(ptr)->data);
+	case Type::IVEC4:
+		return glm::value_ptr(reinterpret_cast<DataInt4*>(ptr)->data);
+	case Type::FLOAT:
+		return glm::value_ptr(reinterpret_cast<DataFloat*>(ptr)->data);
+	case Type::VEC2:
+		return glm::value_ptr(reinterpret_cast<DataFloat2*>(ptr)->data);
+	case Type::VEC3:
+		return glm::value_ptr(reinterpret_cast<DataFloat3*>(ptr)->data);
+	case Type::MAT2:
+		return glm::value_ptr(reinterpret_cast<DataMat2*>(ptr)->data);
+	case Type::MAT3:
+		return glm::value_ptr(reinterpret_cast<DataMat3*>(ptr)->data);
+	case Type::MAT4:
+		return glm::value_ptr(reinterpret_cast<DataMat4*>(ptr)->data);
+	default:
+		return glm::value_ptr(reinterpret_cast<DataFloat4*>(ptr)->data);
+	}
+}
+
+void* rangePointer(ParentData* ptr) {
+	// Range comes right before data and has the same layout for every size
+	if (ptr->tp < Type::FLOAT)
+		return glm::value_ptr(reinterpret_cast<DataInt*>(ptr)->range);
+
+	return glm::value_ptr(reinterpret_cast<DataFloat*>(ptr)->range);
+}
+
+ParentData* create(const std::string& name, Type tp, int32_t count) {
+	glm::ivec2 irg = { 0, 1 };
+	glm::vec2 frg = { 0.0f, 1.0f };
+
+	if (count > 1) {
+		const size_t size = size_t(count) * numComponents(tp);
+		if (tp < Type::FLOAT) {
+			ArrayData<int32_t>* data = new ArrayData<int32_t>(name, tp, count, irg);
+			data->data.assign(size, 0);
+			return data;
+		}
+
+		ArrayData<float>* data = new ArrayData<float>(name, tp, count, frg);
+		data->data.assign(size, 0.0f);
+
+		// Matrices start as identity, same as single ones
+		const int32_t n = tp == Type::MAT2 ? 2 : (tp == Type::MAT3 ? 3 : (tp == Type::MAT4 ? 4 : 0));
+		for (int32_t k = 0; k < count && n > 0; k++) {
+			for (int32_t l = 0; l < n; l++)
+				data->data[size_t(k) * n * n + size_t(l) * (n + 1)] = 1.0f;
+		}
+		return data;
+	}
+
+	switch (tp) {
+	case Type::INT:
+		return new DataInt(name, tp, irg, glm::ivec1(0));
+	case Type::IVEC2:
+		return new DataInt2(name, tp, irg, glm::ivec2(0));
+	case Type::IVEC3:
+		return new DataInt3(name, tp, irg, glm::ivec3(0));
+	case Type::IVEC4:
+		return new DataInt4(name, tp, irg, glm::ivec4(0));
+	case Type::FLOAT:
+		return new DataFloat(name, tp, frg, glm::vec1(0.0f));
+	case Type::VEC2:
+		return new DataFloat2(name, tp, frg, glm::vec2(0.0f));
+	case Type::VEC3:
+		return new DataFloat3(name, tp, frg, glm::vec3(0.0f));
+	case Type::MAT2:
+		return new DataMat2(name, tp, frg, glm::mat2(1.0f));
+	case Type::MAT3:
+		return new DataMat3(name, tp, frg, glm::mat3(1.0f));
+	case Type::MAT4:
+		return new DataMat4(name, tp, frg, glm::mat4(1.0f));
+	default:
+		return new DataFloat4(name, tp, frg, glm::vec4(0.0f));
+	}
+}
+
+ParentData* copy(const std::string& name, const ParentData* ptr) {
+	ParentData* source = const_cast<ParentData*>(ptr);
+	ParentData* data = create(name, ptr->tp, ptr->count);
+	std::memcpy(rangePointer(data), rangePointer(source), 2 * sizeof(float));
+	std::memcpy(dataPointer(data), dataPointer(source), 4 * size_t(numValues(ptr)));
+	data->knob = ptr->knob;
+	data->expression = ptr->expression;
+	return data;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
 
 void Uniform::append(const std::string& name, ParentData* data) {
 	mData.emplace(name, std::move(data));
 }
 
+ParentData* Uniform::find(const std::string& name) {
+	auto it = mData.find(name);
+	return it == mData.end() ? nullptr : it->second.get();
+}
+
+void Uniform::remove(const std::string& name) {
+	mData.erase(name);
+}
+
+Uniform Uniform::clone(void) const {
+	Uniform copy;
+	for (const auto& [name, ptr] : mData)
+		copy.append(name, uniform::copy(ptr->name, ptr.get()));
+	return copy;
+}
+
 template<typename TP>
 void Uniform::addDataWizard(const Type& tp) {
 	const float width = 0.9f * ImGui::GetContentRegionAvail().x;
@@ -24,11 +222,13 @@ void Uniform::addDataWizard(const Type& tp) {
 
 	// A small test to determine if we are dealing with integers or floats
 	bool isInteger = tp >= Type::INT && tp <= Type::IVEC4;
+	bool isMatrix = tp >= Type::MAT2 && tp <= Type::MAT4;
 
 	// We are going to always have 4 values to data, independently of type
 	// This should simply code a bit
 	static glm::vec<2, TP> range = { 0, 1 };
 	static glm::vec<4, TP> data = { 0, 0, 0, 0 };
+	static int32_t count = 1;
 	static char newName[128] = { 0 };
 
 	//////////////////////////////////////////////////////////
@@ -53,12 +253,23 @@ void Uniform::addDataWizard(const Type& tp) {
 	}
 
 	///////////////////////////////////////////////////////
-	// Actual date
+	// Number of elements, arrays are declared as 'uniform vec3 name[count];'
+	ImGui::Text("Count:");
+	ImGui::SameLine(wSpacing);
+	ImGui::SetNextItemWidth(0.3f * width);
+	ImGui::InputInt("##Count:", &count);
+	count = std::clamp(count, 1, MAX_COUNT);
+
+	///////////////////////////////////////////////////////
+	// Actual date, matrices always start as identity
 	ImGui::Text(strData + 2);
 	ImGui::SameLine(wSpacing);
 
+	if (isMatrix) {
+		ImGui::TextDisabled("identity");
+	}
 	// integers
-	if (isInteger) {
+	else if (isInteger) {
 		int32_t sz = static_cast<int32_t>(tp);
 		float val = pow(0.25f * sz, 0.5f);
 		ImGui::SetNextItemWidth(val * width);
@@ -78,6 +289,7 @@ void Uniform::addDataWizard(const Type& tp) {
 		memset(newName, 0, sizeof(newName));
 		range = { 0, 1 };
 		data = { 0, 0, 0, 0 };
+		count = 1;
 		addOn = false;
 	};
 
@@ -89,6 +301,19 @@ void Uniform::addDataWizard(const Type& tp) {
 			if (mData.find(name) != mData.end()) {
 				GRender::mailbox::CreateWarn("'" + name.substr(2) + "' already exists!");
 			}
+			else if (count > 1 || isMatrix) {
+				// Every element starts with the values chosen above
+				ParentData* ptr = create(name, tp, count);
+				std::memcpy(rangePointer(ptr), glm::value_ptr(range), sizeof(range));
+
+				const int32_t sz = numComponents(tp);
+				TP* values = reinterpret_cast<TP*>(dataPointer(ptr));
+				for (int32_t k = 0; k < count && !isMatrix; k++)
+					std::copy(glm::value_ptr(data), glm::value_ptr(data) + sz, values + k * sz);
+
+				mData.emplace(name, ptr);
+				reset();
+			}
 			else {
 				switch (tp) {
 				case Type::INT:
@@ -129,7 +354,7 @@ void Uniform::addUniform() {
 	ImGui::SameLine(0.13f * 0.9f * size.x);
 
 	ImGui::SetNextItemWidth(0.3f * size.x);
-	const char* items[] = { "NONE", "INT", "IVEC2", "IVEC3", "IVEC4", "FLOAT", "VEC2", "VEC3", "VEC4" };
+	const char* items[] = { "NONE", "INT", "IVEC2", "IVEC3", "IVEC4", "FLOAT", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4" };
 	static int32_t currItem = 1;
 	ImGui::Combo("##comboType", &currItem, items, IM_ARRAYSIZE(items));
 
@@ -137,7 +362,7 @@ void Uniform::addUniform() {
 	if (tp >= Type::INT && tp <= Type::IVEC4) {
 		addDataWizard<int32_t>(tp);
 	}
-	else if (tp >= Type::FLOAT && tp <= Type::VEC4) {
+	else if (tp >= Type::FLOAT && tp <= Type::MAT4) {
 		addDataWizard<float>(tp);
 	}
 
@@ -158,25 +383,27 @@ void Uniform::showData(ParentData* ptr, std::string& toRemove) {
 	char local[128] = { 0 };
 	std::copy(name.begin() + 2, name.end(), local);
 
+	const bool issue = pushIssue(name);
 	ImGui::SetNextItemWidth(0.45f * width);
 	if (ImGui::InputText(name.c_str(), local, sizeof(local), ImGuiInputTextFlags_EnterReturnsTrue)) {
-		std::string tag = "##" + std::string{ local };
-		if (tag.size() > 2) {
-			auto it = mData.find(tag);
-			if (it == mData.end()) {
-				TP* data = new TP(tag, dt->tp, dt->range, dt->data);
-				mData.emplace(tag, std::move(data));
-				toRemove = name; // We remove the old one
-			}
-			else {
-				GRender::mailbox::CreateWarn("'" + tag.substr(2) + "' already exists!");
-			}
-		}
+		if (rename(ptr, local))
+			toRemove = name; // We remove the old one
+	}
+	if (issue)
+		popIssue(name);
+
+	// Scalars can be lowered by the quality governor while navigating
+	if ((dt->tp == Type::INT || dt->tp == Type::FLOAT) && ImGui::BeginPopupContextItem("knob")) {
+		ImGui::Checkbox("Quality knob", &dt->knob);
+		ImGui::EndPopup();
 	}
 	ImGui::SameLine();
 	ImGui::SetNextItemWidth(0.45f * width);
 
-	if (dt->tp >= Type::INT && dt->tp <= Type::IVEC4) {
+	// Expressions overwrite the value every frame, so it isn't editable
+	if (dt->expression)
+		ImGui::TextDisabled("= %s", dt->expression->getText().c_str());
+	else if (dt->tp >= Type::INT && dt->tp <= Type::IVEC4) {
 		const int32_t sz = static_cast<int32_t>(dt->tp);
 		ImGui::SliderScalarN(dt->name.c_str(), ImGuiDataType_S32, &dt->data.x, sz, &dt->range.x, &dt->range.y, "%d", 0);
 	}
@@ -192,6 +419,83 @@ void Uniform::showData(ParentData* ptr, std::string& toRemove) {
 	ImGui::PopID();
 }
 
+bool Uniform::rename(ParentData* ptr, const char* local) {
+	std::string tag = "##" + std::string{ local };
+	if (tag.size() <= 2)
+		return false;
+
+	if (mData.find(tag) != mData.end()) {
+		GRender::mailbox::CreateWarn("'" + tag.substr(2) + "' already exists!");
+		return false;
+	}
+
+	mData.emplace(tag, copy(tag, ptr));
+	return true;
+}
+
+void Uniform::showBlock(ParentData* ptr, std::string& toRemove) {
+	float width = ImGui::GetContentRegionAvail().x;
+	const std::string& name = ptr->name;
+
+	ImGui::PushID(name.c_str());
+	char local[128] = { 0 };
+	std::copy(name.begin() + 2, name.end(), local);
+
+	const bool issue = pushIssue(name);
+	ImGui::SetNextItemWidth(0.45f * width);
+	if (ImGui::InputText("##name", local, sizeof(local), ImGuiInputTextFlags_EnterReturnsTrue)) {
+		if (rename(ptr, local))
+			toRemove = name;
+	}
+	if (issue)
+		popIssue(name);
+
+	ImGui::SameLine();
+	std::string label = ptr->count > 1 ? "[" + std::to_string(ptr->count) + "]" : "";
+	if (ptr->expression)
+		label = "= " + ptr->expression->getText();
+	bool open = ImGui::TreeNode("##values", "%s", label.c_str());
+
+	ImGui::SameLine(0.95f * width);
+	if (ImGui::Button("X", { 0.05f * width, 0.0f })) {
+		toRemove = name;
+	}
+
+	if (open) {
+		// One slider per element, or per column of matrices
+		const bool isInteger = ptr->tp < Type::FLOAT;
+		const int32_t size = ptr->tp == Type::MAT2 ? 2 : (ptr->tp == Type::MAT3 ? 3 : (ptr->tp == Type::MAT4 ? 4 : numComponents(ptr->tp)));
+		const int32_t rows = numValues(ptr) / size;
+
+		uint8_t* values = reinterpret_cast<uint8_t*>(dataPointer(ptr));
+		void* range = rangePointer(ptr);
+
+		for (int32_t k = 0; k < rows; k++) {
+			ImGui::PushID(k);
+			ImGui::SetNextItemWidth(0.45f * width);
+			if (isInteger) {
+				const int32_t* rg = reinterpret_cast<const int32_t*>(range);
+				ImGui::SliderScalarN("##row", ImGuiDataType_S32, values + 4 * k * size, size, rg, rg + 1, "%d", 0);
+			}
+			else {
+				const float* rg = reinterpret_cast<const float*>(range);
+				ImGui::SliderScalarN("##row", ImGuiDataType_Float, values + 4 * k * size, size, rg, rg + 1, "%.3f", 1);
+			}
+
+			ImGui::SameLine();
+			if (ptr->tp < Type::MAT2)
+				ImGui::TextDisabled("%d", k);
+			else if (ptr->count > 1)
+				ImGui::TextDisabled("%d, column %d", k / size, k % size);
+			else
+				ImGui::TextDisabled("column %d", k);
+			ImGui::PopID();
+		}
+		ImGui::TreePop();
+	}
+	ImGui::PopID();
+}
+
 void Uniform::showUniforms() {
 	if (!active) {
 		return;
@@ -207,6 +511,11 @@ void Uniform::showUniforms() {
 	ImGui::BeginChild("child_2", size, true);
 
 	for (auto& [name, data] : mData) {
+		if (data->count > 1 || data->tp >= Type::MAT2) {
+			showBlock(data.get(), toRemove);
+			continue;
+		}
+
 		switch (data->tp) {
 		case Type::INT:
 			showData<DataInt>(data.get(), toRemove);
@@ -245,6 +554,28 @@ void Uniform::showUniforms() {
 		addOn = true;
 	}
 
+	if (!missing.empty()) {
+		ImGui::SameLine();
+		if (ImGui::Button(("Create missing (" + std::to_string(missing.size()) + ")").c_str())) {
+			for (const Missing& miss : missing) {
+				const std::string tag = "##" + miss.name;
+				if (mData.find(tag) == mData.end())
+					mData.emplace(tag, create(tag, miss.tp, miss.count));
+			}
+			missing.clear();
+		}
+
+		if (ImGui::IsItemHovered()) {
+			std::string names;
+			for (const Missing& miss : missing) {
+				names += (names.empty() ? "" : "\n") + std::string(glslName(miss.tp)) + " " + miss.name;
+				if (miss.count > 1)
+					names += "[" + std::to_string(miss.count) + "]";
+			}
+			ImGui::SetTooltip("Declared in shader, but nothing assigns them:\n%s", names.c_str());
+		}
+	}
+
 	ImGui::SameLine();
 	if (ImGui::Button("Close")) {
 		active = false;
@@ -258,37 +589,100 @@ void Uniform::showUniforms() {
 	}
 }
 
+bool Uniform::pushIssue(const std::string& name) {
+	auto it = issues.find(name);
+	if (it == issues.end())
+		return false;
+
+	const ImVec4 color = it->second.mismatch ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) : ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
+	ImGui::PushStyleColor(ImGuiCol_Text, color);
+	return true;
+}
+
+void Uniform::popIssue(const std::string& name) {
+	ImGui::PopStyleColor();
+	if (ImGui::IsItemHovered())
+		ImGui::SetTooltip("%s", issues[name].message.c_str());
+}
+
+void Uniform::reflect(const DynamicShader& shader) {
+	issues.clear();
+	missing.clear();
+	if (!active || shader.hasFailed())
+		return;
+
+	for (const auto& [name, data] : mData) {
+		const DynamicShader::Reflected* found = shader.findUniform(name.substr(2));
+		if (found == nullptr)
+			issues[name] = { false, "Not used by shader" };
+		else if (fromGL(found->type) != data->tp)
+			issues[name] = { true, std::string("Shader declares it as ") + (fromGL(found->type) == Type::NONE ? "another type" : glslName(fromGL(found->type))) };
+		else if (found->size > data->count)
+			issues[name] = { true, "Shader declares " + std::to_string(found->size) + " elements, only " + std::to_string(data->count) + " are set" };
+		else if (found->size < data->count)
+			issues[name] = { false, "Shader declares only " + std::to_string(found->size) + " elements, others are ignored" };
+	}
+
+	// Built-in uniforms and samplers are assigned by tools, so only user values show up here
+	for (const auto& [name, found] : shader.getUniforms()) {
+		const Type tp = fromGL(found.type);
+		if (tp != Type::NONE && !found.assigned)
+			missing.push_back({ name, tp, found.size });
+	}
+	std::sort(missing.begin(), missing.end(), [](const Missing& a, const Missing& b) { return a.name < b.name; });
+}
+
 
 /////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////
 
 
 void Uniform::submit(const DynamicShader& shader) {
+	GSHADER_PROFILE_FUNCTION();
 	for (const auto& [name, data] : mData) {
+		// Arrays go in one call too, starting from location of first element
+		const char* label = name.c_str() + 2;
+		const DynamicShader::Reflected* found = shader.findUniform(label);
+		if (found == nullptr)
+			continue;
+
+		// Elements beyond those declared would make the whole upload fail
+		const int32_t count = std::min(data->count, found->size);
+		void* ptr = dataPointer(data.get());
+
 		switch (data->tp) {
 		case Type::INT:
-			shader.setInteger(name.substr(2).c_str(), reinterpret_cast<DataInt*>(data.get())->data.x);
+			shader.setInteger(label, reinterpret_cast<const int32_t*>(ptr), count);
 			break;
 		case Type::IVEC2:
-			shader.setVec2i(name.substr(2).c_str(), glm::value_ptr(reinterpret_cast<DataInt2*>(data.get())->data));
+			shader.setVec2i(label, reinterpret_cast<const int32_t*>(ptr), count);
 			break;
 		case Type::IVEC3:
-			shader.setVec3i(name.substr(2).c_str(), glm::value_ptr(reinterpret_cast<DataInt3*>(data.get())->data));
+			shader.setVec3i(label, reinterpret_cast<const int32_t*>(ptr), count);
 			break;
 		case Type::IVEC4:
-			shader.setVec4i(name.substr(2).c_str(), glm::value_ptr(reinterpret_cast<DataInt4*>(data.get())->data));
+			shader.setVec4i(label, reinterpret_cast<const int32_t*>(ptr), count);
 			break;
 		case Type::FLOAT:
-			shader.setFloat(name.substr(2).c_str(), reinterpret_cast<DataFloat*>(data.get())->data.x);
+			shader.setFloat(label, reinterpret_cast<const float*>(ptr), count);
 			break;
 		case Type::VEC2:
-			shader.setVec2f(name.substr(2).c_str(), glm::value_ptr(reinterpret_cast<DataFloat2*>(data.get())->data));
+			shader.setVec2f(label, reinterpret_cast<const float*>(ptr), count);
 			break;
 		case Type::VEC3:
-			shader.setVec3f(name.substr(2).c_str(), glm::value_ptr(reinterpret_cast<DataFloat3*>(data.get())->data));
+			shader.setVec3f(label, reinterpret_cast<const float*>(ptr), count);
+			break;
+		case Type::MAT2:
+			shader.setMat2f(label, reinterpret_cast<const float*>(ptr), count);
+			break;
+		case Type::MAT3:
+			shader.setMat3f(label, reinterpret_cast<const float*>(ptr), count);
+			break;
+		case Type::MAT4:
+			shader.setMat4f(label, reinterpret_cast<const float*>(ptr), count);
 			break;
 		default:
-			shader.setVec4f(name.substr(2).c_str(), glm::value_ptr(reinterpret_cast<DataFloat4*>(data.get())->data));
+			shader.setVec4f(label, reinterpret_cast<const float*>(ptr), count);
 			break;
 		}
 	}
@@ -0,0 +1,282 @@
+#include "viewports.h"
+#include "configFile.h"
+#include "expression.h"
+#include "profiler.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fs = std::filesystem;
+
+// Scales are kept on a coarse grid, so targets aren't reallocated on every small change
+static constexpr float SCALE_STEP = 0.125f;
+
+void Viewports::add(const fs::path& path) {
+	std::unique_ptr<View> view = std::make_unique<View>();
+	if (load(*view, path))
+		views.push_back(std::move(view));
+}
+
+void Viewports::add(const fs::path& shaderpath, const Colors& colors, const uniform::Uniform& uniforms, const GRender::Camera& camera) {
+	std::unique_ptr<View> view = std::make_unique<View>();
+	view->colors = colors;
+	view->uniforms = uniforms.clone();
+	view->camera = camera;
+	if (load(*view, shaderpath))
+		views.push_back(std::move(view));
+}
+
+bool Viewports::load(View& view, const fs::path& path) {
+	fs::path shaderpath = path;
+	if (path.extension() == ".json") {
+		ConfigFile config(path);
+		config.load();
+
+		shaderpath = config.get<fs::path>();
+		if (shaderpath.empty())
+			return false;
+
+		view.colors = config.get<Colors>();
+		view.uniforms = config.get<uniform::Uniform>();
+		view.camera = config.get<GRender::Camera>();
+	}
+
+	if (!fs::exists(shaderpath)) {
+		GRender::mailbox::CreateError("File doesn't exist: " + shaderpath.string());
+		return false;
+	}
+
+	view.id = nextID++;
+	view.shaderpath = shaderpath;
+	view.shader.initialize();
+	view.shader.setModules(useModules);
+	view.shader.loadShader(shaderpath);
+	expr::scan(view.shader, view.uniforms, view.colors);
+	return true;
+}
+
+void Viewports::setModules(bool value) {
+	useModules = value;
+	for (std::unique_ptr<View>& view : views) {
+		view->shader.setModules(value);
+		view->shader.loadShader(view->shaderpath);
+		expr::scan(view->shader, view->uniforms, view->colors);
+	}
+}
+
+void Viewports::update(float deltaTime, bool playing, const GRender::Camera& mainCamera) {
+	// Closed windows are removed along with their resources
+	views.erase(std::remove_if(views.begin(), views.end(), [](const std::unique_ptr<View>& view) { return !view->open; }), views.end());
+
+	for (std::unique_ptr<View>& view : views) {
+		if (view->shader.wasUpdated()) {
+			view->shader.loadShader(view->shaderpath);
+			expr::scan(view->shader, view->uniforms, view->colors);
+		}
+
+		if (view->syncCamera)
+			view->camera = mainCamera;
+		else if (view->hovered && playing)
+			view->camera.controls(deltaTime);
+	}
+}
+
+bool Viewports::isHovered(void) const {
+	for (const std::unique_ptr<View>& view : views) {
+		if (view->hovered)
+			return true;
+	}
+	return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Viewports::distribute(void) {
+	// Shares follow weights, hovered view counts as several background ones
+	std::vector<double> cost(views.size()), weight(views.size()), share(views.size());
+	double total = 0.0;
+	for (size_t k = 0; k < views.size(); k++) {
+		const View& view = *views[k];
+		cost[k] = view.costPerPixel * double(view.size.x) * double(view.size.y);
+		weight[k] = view.hovered ? hoverWeight : 1.0;
+		total += weight[k];
+	}
+
+	for (size_t k = 0; k < views.size(); k++)
+		share[k] = budget * weight[k] / total;
+
+	// What cheap views don't use is given to the others
+	double surplus = 0.0, hungry = 0.0;
+	for (size_t k = 0; k < views.size(); k++) {
+		if (cost[k] < share[k]) {
+			surplus += share[k] - cost[k];
+			share[k] = cost[k];
+		}
+		else {
+			hungry += weight[k];
+		}
+	}
+
+	for (size_t k = 0; k < views.size() && hungry > 0.0; k++) {
+		if (cost[k] > share[k])
+			share[k] += surplus * weight[k] / hungry;
+	}
+
+	// Resolution is lowered first, frame rate only when the smallest one is still too expensive
+	for (size_t k = 0; k < views.size(); k++) {
+		View& view = *views[k];
+		if (cost[k] <= 0.0 || cost[k] <= share[k] || share[k] <= 0.0) {
+			view.scale = 1.0f;
+			view.interval = 1;
+			continue;
+		}
+
+		float scale = float(std::sqrt(share[k] / cost[k]));
+		scale = std::clamp(SCALE_STEP * std::floor(scale / SCALE_STEP), minScale, 1.0f);
+
+		double perFrame = cost[k] * scale * scale;
+		view.scale = scale;
+		view.interval = std::clamp(int32_t(std::ceil(perFrame / share[k])), 1, MAX_INTERVAL);
+	}
+}
+
+std::vector<Viewports::View*> Viewports::schedule(bool force) {
+	GSHADER_PROFILE_FUNCTION();
+	frame++;
+
+	// Measurements become available a few frames later
+	for (std::unique_ptr<View>& view : views) {
+		double ms = 0.0;
+		while (view->timer.fetch(ms)) {
+			uint64_t pixels = view->pending.front();
+			view->pending.pop_front();
+
+			double value = ms / double(std::max<uint64_t>(pixels, 1));
+			view->costPerPixel = view->costPerPixel > 0.0 ? 0.9 * view->costPerPixel + 0.1 * value : value;
+		}
+	}
+
+	distribute();
+
+	std::vector<View*> due;
+	for (std::unique_ptr<View>& view : views) {
+		if (view->shader.hasFailed())
+			continue;
+
+		if (force || frame - view->lastFrame >= uint64_t(view->interval))
+			due.push_back(view.get());
+	}
+	return due;
+}
+
+glm::uvec2 Viewports::begin(View& view) {
+	glm::uvec2 res = glm::max(glm::uvec2(glm::vec2(view.size) * view.scale), glm::uvec2(1, 1));
+	if (view.target.getSize() != res)
+		view.target = RenderTarget(res.x, res.y);
+
+	view.target.bind();
+	if (view.timer.begin())
+		view.pending.push_back(uint64_t(res.x) * uint64_t(res.y));
+
+	return res;
+}
+
+void Viewports::end(View& view) {
+	view.timer.end();
+	view.target.unbind();
+	view.lastFrame = frame;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void Viewports::showViewports(void) {
+	// Windows of views are always shown, only the settings panel can be closed
+	for (std::unique_ptr<View>& ptr : views) {
+		View& view = *ptr;
+		std::string title = view.shaderpath.filename().string() + "###view" + std::to_string(view.id);
+
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, { 0.0f, 0.0f });
+		ImGui::Begin(title.c_str(), &view.open);
+		view.hovered = ImGui::IsWindowHovered();
+
+		ImVec2 port = ImGui::GetContentRegionAvail();
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		view.size = { uint32_t(std::max(port.x, 1.0f)), uint32_t(std::max(port.y, 1.0f)) };
+
+		// Lower resolution images are simply stretched over the window
+		if (view.target.getID() != 0)
+			ImGui::Image((void*)(uintptr_t)view.target.getID(), port, { 0.0f, 1.0f }, { 1.0f, 0.0f });
+
+		if (view.hovered) {
+			ImVec2 mpos = ImGui::GetMousePos();
+			view.cursor.x = (mpos.x - origin.x) / port.x;
+			view.cursor.y = 1.0f - (mpos.y - origin.y) / port.y;
+		}
+
+		ImGui::End();
+		ImGui::PopStyleVar();
+	}
+
+	if (!active)
+		return;
+
+	ImGui::Begin("Viewports", &active);
+	ImGui::SetWindowSize({ 450.0f, 350.0f });
+
+	const float width = ImGui::GetContentRegionAvail().x;
+
+	ImGui::SetNextItemWidth(0.5f * width);
+	ImGui::SliderFloat("GPU budget (ms)", &budget, 1.0f, 50.0f, "%.1f");
+	ImGui::SetNextItemWidth(0.5f * width);
+	ImGui::SliderFloat("Minimum scale", &minScale, SCALE_STEP, 1.0f, "%.3f");
+	ImGui::SetNextItemWidth(0.5f * width);
+	ImGui::SliderFloat("Hovered weight", &hoverWeight, 1.0f, 16.0f, "%.1f");
+
+	if (ImGui::Button("Add viewport..."))
+		addOn = true;
+	ImGui::SameLine();
+	if (ImGui::Button("Duplicate main"))
+		duplicateOn = true;
+
+	ImGui::Separator();
+
+	for (std::unique_ptr<View>& ptr : views) {
+		View& view = *ptr;
+		ImGui::PushID(int(view.id));
+
+		ImGui::Text("%s", view.shaderpath.filename().string().c_str());
+		ImGui::SameLine(0.45f * width);
+		ImGui::Checkbox("Sync camera", &view.syncCamera);
+
+		double ms = view.costPerPixel * double(view.size.x) * double(view.size.y);
+		ImGui::TextDisabled("  full: %.2f ms   scale: %.0f%%   every %d frame%s", ms, 100.0f * view.scale, view.interval, view.interval > 1 ? "s" : "");
+
+		ImGui::PopID();
+	}
+
+	ImGui::End();
+}
+
+bool Viewports::addRequested(void) {
+	bool value = addOn;
+	addOn = false;
+	return value;
+}
+
+bool Viewports::duplicateRequested(void) {
+	bool value = duplicateOn;
+	duplicateOn = false;
+	return value;
+}
+
+void Viewports::open(void) {
+	active = true;
+}
+
+void Viewports::close(void) {
+	active = false;
+}